@@ -32,6 +32,7 @@ const char * ModeledString(Core::MemModeled modeled) {
    switch(modeled)
    {
       case Core::MEM_MODELED_NONE:           return "none";
+      case Core::MEM_MODELED_WARMUP:         return "warmup";
       case Core::MEM_MODELED_COUNT:          return "count";
       case Core::MEM_MODELED_COUNT_TLBTIME:  return "count/tlb";
       case Core::MEM_MODELED_TIME:           return "time";
@@ -225,7 +226,7 @@ Core::logMemoryHit(bool icache, mem_op_t mem_op_type, IntPtr address, MemModeled
 }
 
 MemoryResult
-Core::readInstructionMemory(IntPtr address, UInt32 instruction_size)
+Core::readInstructionMemory(IntPtr address, UInt32 instruction_size, MemModeled modeled)
 {
    LOG_PRINT("Instruction: Address(0x%x), Size(%u), Start READ",
            address, instruction_size);
@@ -257,7 +258,7 @@ Core::readInstructionMemory(IntPtr address, UInt32 instruction_size)
 
    // Cases with multiple cache lines or when we are not sure that it will be a hit call into the caches
    return initiateMemoryAccess(MemComponent::L1_ICACHE,
-             Core::NONE, Core::READ, address & blockmask, NULL, getMemoryManager()->getCacheBlockSize(), MEM_MODELED_COUNT_TLBTIME, 0, SubsecondTime::MaxTime());
+             Core::NONE, Core::READ, address & blockmask, NULL, getMemoryManager()->getCacheBlockSize(), modeled, 0, SubsecondTime::MaxTime());
 }
 
 void Core::accessMemoryFast(bool icache, mem_op_t mem_op_type, IntPtr address)
@@ -368,7 +369,8 @@ Core::initiateMemoryAccess(MemComponent::component_t mem_component,
                mem_op_type,
                curr_addr_aligned, curr_offset,
                data_buf ? curr_data_buffer_head : NULL, curr_size,
-               modeled);
+               modeled,
+               eip);
 
       if (hit_where != (HitWhere::where_t)mem_component)
       {
@@ -431,11 +433,12 @@ Core::initiateMemoryAccess(MemComponent::component_t mem_component,
             m_performance_model->handleMemoryLatency(shmem_time, hit_where);
          break;
       case MEM_MODELED_NONE:
+      case MEM_MODELED_WARMUP:
       case MEM_MODELED_RETURN:
          break;
    }
 
-   if (modeled != MEM_MODELED_NONE)
+   if (modeled != MEM_MODELED_NONE && modeled != MEM_MODELED_WARMUP)
    {
       getShmemPerfModel()->incrTotalMemoryAccessLatency(shmem_time);
    }
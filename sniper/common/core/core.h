@@ -71,6 +71,7 @@ class Core
       enum MemModeled
       {
          MEM_MODELED_NONE,      /* Not at all (pure backdoor access) */
+         MEM_MODELED_WARMUP,    /* Update cache and TLB contents, but don't count or time (functional warming) */
          MEM_MODELED_COUNT,     /* Count in #accesses/#misses */
          MEM_MODELED_COUNT_TLBTIME, /* Count in #accesses/#misses, queue TLBMissInstruction on TLB miss */
          MEM_MODELED_TIME,      /* Count + account for access latency (using MemAccessInstruction) */
@@ -87,7 +88,7 @@ class Core
       bool accessBranchPredictor(IntPtr eip, bool taken, IntPtr target);
 
       MemoryResult readInstructionMemory(IntPtr address,
-            UInt32 instruction_size);
+            UInt32 instruction_size, MemModeled modeled = MEM_MODELED_COUNT_TLBTIME);
 
       MemoryResult accessMemory(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size, MemModeled modeled = MEM_MODELED_NONE, IntPtr eip = 0, SubsecondTime now = SubsecondTime::MaxTime(), bool is_fault_mask = false);
       MemoryResult nativeMemOp(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size);
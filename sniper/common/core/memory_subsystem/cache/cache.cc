@@ -142,7 +142,9 @@ CacheBlockInfo* Cache::accessSingleLine(IntPtr addr, access_t access_type,
                   acc_data);
   } else {
     assert(writebacks != nullptr);
-    assert(cntlr != nullptr);
+    // Only compressed caches need the controller, to re-place lines whose
+    // compression factor changes
+    assert(cntlr != nullptr || !isCompressible());
 
     const Byte* wr_data_mux = nullptr;  // Proxy for write data buffer
 
@@ -278,6 +280,63 @@ CacheBlockInfo* Cache::peekBlock(UInt32 set_index, UInt32 way,
   return m_sets[set_index]->peekBlock(way, block_id);
 }
 
+UInt32 Cache::getSuperblockOccupancy(IntPtr addr) const {
+  IntPtr supertag;
+  UInt32 set_index;
+  splitAddress(addr, nullptr, &supertag, &set_index);
+
+  const SuperblockInfo* superblock_info =
+      m_sets[set_index]->findSuperblock(supertag);
+  if (superblock_info == nullptr) return 0;
+
+  UInt32 occupancy = 0;
+  for (UInt32 i = 0; i < SUPERBLOCK_SIZE; ++i) {
+    if (superblock_info->isValid(i)) ++occupancy;
+  }
+
+  return occupancy;
+}
+
+std::vector<IntPtr> Cache::getSuperblockVacancies(IntPtr addr) const {
+  std::vector<IntPtr> vacancies;
+
+  IntPtr supertag;
+  UInt32 set_index;
+  UInt32 block_id;
+  splitAddress(addr, nullptr, &supertag, &set_index, &block_id);
+
+  const SuperblockInfo* superblock_info =
+      m_sets[set_index]->findSuperblock(supertag);
+  if (superblock_info == nullptr) return vacancies;
+
+  IntPtr base_addr = (addr & ~(IntPtr(m_blocksize) - 1)) -
+                     IntPtr(block_id) * m_blocksize;
+  for (UInt32 i = 0; i < SUPERBLOCK_SIZE; ++i) {
+    if (superblock_info->isValid(i)) continue;
+
+    // With a non-trivial address home lookup the linear address decides the
+    // superblock, so only keep neighbours that really map onto this one
+    IntPtr vacant_addr = base_addr + IntPtr(i) * m_blocksize;
+    IntPtr vacant_supertag;
+    UInt32 vacant_set_index, vacant_block_id;
+    splitAddress(vacant_addr, nullptr, &vacant_supertag, &vacant_set_index,
+                 &vacant_block_id);
+    if (vacant_supertag == supertag && vacant_set_index == set_index &&
+        vacant_block_id == i) {
+      vacancies.push_back(vacant_addr);
+    }
+  }
+
+  return vacancies;
+}
+
+UInt64 Cache::getNumValidBlocks() const {
+  UInt64 num_valid = 0;
+  for (const auto& set : m_sets) num_valid += set->getNumValidBlocks();
+
+  return num_valid;
+}
+
 void Cache::splitAddress(IntPtr addr, IntPtr* tag, IntPtr* supertag,
                          UInt32* set_index, UInt32* block_id,
                          UInt32* offset) const {
@@ -134,6 +134,16 @@ class Cache : public CacheBase {
   CacheBlockInfo* peekBlock(UInt32 set_index, UInt32 way,
                             UInt32 block_id) const;
 
+  // Superblock queries used by compression-aware prefetching.  The occupancy
+  // is the number of valid blocks in the resident superblock holding addr (0
+  // when not resident), the vacancies are the addresses of its missing blocks.
+  UInt32 getSuperblockOccupancy(IntPtr addr) const;
+  std::vector<IntPtr> getSuperblockVacancies(IntPtr addr) const;
+
+  // Number of valid blocks over all sets, which exceeds the number of ways
+  // when compressed superblocks share a data way
+  UInt64 getNumValidBlocks() const;
+
   // Address parsing utilities
   void splitAddress(IntPtr addr, IntPtr* tag = nullptr,
                     IntPtr* supertag = nullptr, UInt32* set_index = nullptr,
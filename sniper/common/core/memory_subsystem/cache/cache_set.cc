@@ -222,6 +222,25 @@ CacheBlockInfo* CacheSet::find(IntPtr tag, UInt32 block_id, UInt32* way) const {
   return nullptr;
 }
 
+const SuperblockInfo* CacheSet::findSuperblock(IntPtr supertag) const {
+  for (const auto& superblock_info : m_superblock_info_ways) {
+    if (superblock_info.compareSupertag(supertag)) return &superblock_info;
+  }
+
+  return nullptr;
+}
+
+UInt32 CacheSet::getNumValidBlocks() const {
+  UInt32 num_valid = 0;
+  for (const auto& superblock_info : m_superblock_info_ways) {
+    for (UInt32 i = 0; i < SUPERBLOCK_SIZE; ++i) {
+      if (superblock_info.isValid(i)) ++num_valid;
+    }
+  }
+
+  return num_valid;
+}
+
 void CacheSet::invalidate(IntPtr tag, UInt32 block_id) {
   UInt32 inv_way;
   CacheBlockInfo* inv_block_info = find(tag, block_id, &inv_way);
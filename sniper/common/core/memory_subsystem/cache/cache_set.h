@@ -77,6 +77,8 @@ class CacheSet {
                  CacheCntlr* cntlr = nullptr);
   CacheBlockInfo* find(IntPtr tag, UInt32 block_id,
                        UInt32* way = nullptr) const;
+  const SuperblockInfo* findSuperblock(IntPtr supertag) const;
+  UInt32 getNumValidBlocks() const;
   void invalidate(IntPtr tag, UInt32 block_info);
   void insertLine(CacheBlockInfoUPtr ins_block_info, const Byte* ins_data, 
                   bool allow_fwd_inv, WritebackLines* writebacks, 
@@ -94,6 +94,10 @@ bool SuperblockInfo::compareTags(IntPtr tag, UInt32* block_id) const {
   return false;
 }
 
+bool SuperblockInfo::compareSupertag(IntPtr supertag) const {
+  return isValid() && supertag == m_supertag;
+}
+
 bool SuperblockInfo::isValidReplacement() const {
   for (UInt32 i = 0; i < SUPERBLOCK_SIZE; ++i) {
     const CacheBlockInfo* block_info = m_block_infos[i].get();
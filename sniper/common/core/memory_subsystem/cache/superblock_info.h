@@ -31,6 +31,7 @@ class SuperblockInfo {
   void  invalidateBlockInfo(IntPtr inv_tag, UInt32 block_id);
 
   bool compareTags(IntPtr tag, UInt32* block_id = nullptr) const;
+  bool compareSupertag(IntPtr supertag) const;
 
   bool isValidReplacement() const;
 
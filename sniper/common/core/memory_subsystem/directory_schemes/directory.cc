@@ -13,15 +13,75 @@ Directory::Directory(core_id_t core_id, String directory_type_str, UInt32 num_en
    m_max_hw_sharers(max_hw_sharers),
    m_use_max_hw_sharers(max_hw_sharers), // Value to pass through to DirectoryEntry::addSharer
    m_max_num_sharers(max_num_sharers),
-   m_limitless_software_trap_penalty(SubsecondTime::Zero())
+   m_limitless_software_trap_penalty(SubsecondTime::Zero()),
+   m_directory_entry_list(NULL),
+   m_sparse_entries(NULL),
+   m_footprint_bytes(0),
+   m_sharer_bits(0)
 {
-   // Look at the type of directory and create
-   m_directory_entry_list = new DirectoryEntry*[m_num_entries];
-
    m_directory_type = parseDirectoryType(directory_type_str);
-   for (UInt32 i = 0; i < m_num_entries; i++)
+
+   if (m_directory_type == SPARSE)
+   {
+      m_sparse_params.encoding = parseSparseEncoding(Sim()->getCfg()->getString("perf_model/dram_directory/sparse/encoding"));
+      m_sparse_params.num_cores = m_max_num_sharers;
+      m_sparse_params.group_size = m_sparse_params.encoding == SparseDirectoryParams::FULL_MAP
+         ? 1 : Sim()->getCfg()->getInt("perf_model/dram_directory/sparse/group_size");
+      LOG_ASSERT_ERROR(m_sparse_params.group_size > 0, "perf_model/dram_directory/sparse/group_size must be larger than zero");
+      m_sparse_params.num_groups = (m_max_num_sharers + m_sparse_params.group_size - 1) / m_sparse_params.group_size;
+      m_sparse_params.num_pointers = m_sparse_params.encoding == SparseDirectoryParams::FULL_MAP
+         ? 0 : Sim()->getCfg()->getInt("perf_model/dram_directory/sparse/pointers");
+      LOG_ASSERT_ERROR(m_sparse_params.encoding == SparseDirectoryParams::FULL_MAP || m_max_num_sharers <= 0x10000,
+                       "Sparse directory pointers hold at most 65536 cores");
+      m_sparse_params.num_words = m_sparse_params.encoding == SparseDirectoryParams::FULL_MAP
+         ? (m_max_num_sharers + 63) / 64 : 0;
+      m_sparse_params.num_group_words = m_sparse_params.encoding == SparseDirectoryParams::FULL_MAP
+         ? 0 : (m_sparse_params.num_groups + 63) / 64;
+      m_sparse_params.num_pointer_words = (m_sparse_params.num_pointers + 3) / 4;
+      m_sparse_params.entry_words = m_sparse_params.num_words + m_sparse_params.num_group_words + m_sparse_params.num_pointer_words;
+      UInt32 pointer_bits = m_max_num_sharers > 1 ? 32 - __builtin_clz(m_max_num_sharers - 1) : 1;
+      switch (m_sparse_params.encoding)
+      {
+         case SparseDirectoryParams::COARSE_VECTOR:
+            m_sparse_params.hw_bits = m_sparse_params.num_pointers * pointer_bits + m_sparse_params.num_groups;
+            break;
+         case SparseDirectoryParams::HIERARCHICAL:
+            // Pointers and top-level cluster vector, plus one bit per core in the cluster directories
+            m_sparse_params.hw_bits = m_sparse_params.num_pointers * pointer_bits + m_sparse_params.num_groups + m_max_num_sharers;
+            break;
+         default:
+            m_sparse_params.hw_bits = m_max_num_sharers;
+            break;
+      }
+      m_sparse_params.cluster_access_time = m_sparse_params.encoding == SparseDirectoryParams::HIERARCHICAL
+         ? SubsecondTime::NS() * Sim()->getCfg()->getInt("perf_model/dram_directory/sparse/cluster_access_time")
+         : SubsecondTime::Zero();
+
+      // Sharer state is exact and never exceeds the number of cores, there is no hardware sharer limit
+      m_use_max_hw_sharers = m_max_num_sharers;
+
+      // Allocate and initialize all entries up front, only lines that overflow their pointers allocate later on
+      m_sparse_params.footprint_bytes = &m_footprint_bytes;
+      m_sparse_entries = new DirectoryEntrySparse[m_num_entries];
+      m_sparse_sharers.resize(UInt64(m_num_entries) * m_sparse_params.entry_words);
+      for (UInt32 i = 0; i < m_num_entries; i++)
+      {
+         m_sparse_entries[i].init(&m_sparse_params, &m_sparse_sharers[UInt64(i) * m_sparse_params.entry_words]);
+      }
+      m_num_entries_allocated = m_num_entries;
+      // Entries that overflow their pointers add their exact sharer lists as they go
+      m_footprint_bytes += UInt64(m_num_entries) * sizeof(DirectoryEntrySparse) + m_sparse_sharers.size() * sizeof(UInt64);
+      m_sharer_bits = UInt64(m_num_entries) * m_sparse_params.hw_bits;
+   }
+   else
    {
-      m_directory_entry_list[i] = NULL;
+      // Look at the type of directory and create
+      m_directory_entry_list = new DirectoryEntry*[m_num_entries];
+      for (UInt32 i = 0; i < m_num_entries; i++)
+      {
+         m_directory_entry_list[i] = NULL;
+      }
+      m_footprint_bytes = m_num_entries * sizeof(DirectoryEntry*);
    }
 
    if (m_directory_type == LIMITLESS)
@@ -37,16 +97,23 @@ Directory::Directory(core_id_t core_id, String directory_type_str, UInt32 num_en
    }
 
    registerStatsMetric("directory", core_id, "entries-allocated", &m_num_entries_allocated);
+   registerStatsMetric("directory", core_id, "footprint-bytes", &m_footprint_bytes);
+   if (m_directory_type == SPARSE)
+      registerStatsMetric("directory", core_id, "sharer-bits", &m_sharer_bits);
 }
 
 Directory::~Directory()
 {
-   for (UInt32 i = 0; i < m_num_entries; i++)
+   if (m_directory_entry_list)
    {
-      if (m_directory_entry_list[i])
-         delete m_directory_entry_list[i];
+      for (UInt32 i = 0; i < m_num_entries; i++)
+      {
+         if (m_directory_entry_list[i])
+            delete m_directory_entry_list[i];
+      }
+      delete [] m_directory_entry_list;
    }
-   delete [] m_directory_entry_list;
+   delete [] m_sparse_entries;
 }
 
 DirectoryEntry*
@@ -54,6 +121,9 @@ Directory::getDirectoryEntry(UInt32 entry_num)
 {
    LOG_ASSERT_ERROR(entry_num < m_num_entries, "Invalid entry_num(%d) >= num_entries(%d)", entry_num, m_num_entries);
 
+   if (m_directory_type == SPARSE)
+      return &m_sparse_entries[entry_num];
+
    if (m_directory_entry_list[entry_num] == NULL)
    {
       m_directory_entry_list[entry_num] = createDirectoryEntry();
@@ -62,10 +132,24 @@ Directory::getDirectoryEntry(UInt32 entry_num)
    return m_directory_entry_list[entry_num];
 }
 
-void
-Directory::setDirectoryEntry(UInt32 entry_num, DirectoryEntry* directory_entry)
+DirectoryEntry*
+Directory::evictDirectoryEntry(UInt32 entry_num)
 {
-   m_directory_entry_list[entry_num] = directory_entry;
+   LOG_ASSERT_ERROR(entry_num < m_num_entries, "Invalid entry_num(%d) >= num_entries(%d)", entry_num, m_num_entries);
+
+   if (m_directory_type == SPARSE)
+   {
+      // Arena slots cannot be handed out, copy the victim and recycle the slot in place
+      DirectoryEntry* evicted_entry = new DirectoryEntrySparseCopy(m_sparse_entries[entry_num], &m_sparse_params);
+      m_sparse_entries[entry_num].reset();
+      return evicted_entry;
+   }
+   else
+   {
+      DirectoryEntry* evicted_entry = m_directory_entry_list[entry_num];
+      m_directory_entry_list[entry_num] = createDirectoryEntry();
+      return evicted_entry;
+   }
 }
 
 Directory::DirectoryType
@@ -77,6 +161,8 @@ Directory::parseDirectoryType(String directory_type_str)
       return LIMITED_NO_BROADCAST;
    else if (directory_type_str == "limitless")
       return LIMITLESS;
+   else if (directory_type_str == "sparse")
+      return SPARSE;
    else
    {
       LOG_PRINT_ERROR("Unsupported Directory Type: %s", directory_type_str.c_str());
@@ -84,11 +170,29 @@ Directory::parseDirectoryType(String directory_type_str)
    }
 }
 
+SparseDirectoryParams::Encoding
+Directory::parseSparseEncoding(String encoding_str)
+{
+   if (encoding_str == "full_map")
+      return SparseDirectoryParams::FULL_MAP;
+   else if (encoding_str == "coarse_vector")
+      return SparseDirectoryParams::COARSE_VECTOR;
+   else if (encoding_str == "hierarchical")
+      return SparseDirectoryParams::HIERARCHICAL;
+   else
+   {
+      LOG_PRINT_ERROR("Unsupported sparse directory encoding: %s", encoding_str.c_str());
+      return (SparseDirectoryParams::Encoding) -1;
+   }
+}
+
 DirectoryEntry*
 Directory::createDirectoryEntry()
 {
    // Specify the storage class to use for counting the directory sharers.
    // Due to alignment issues, the minimum size can already hold up to 64 nodes.
+   LOG_ASSERT_ERROR(m_directory_type != SPARSE, "Sparse directory entries are not allocated individually");
+
    if (m_max_num_sharers <= 64)
       return createDirectoryEntrySized<DirectorySharersBitset<64> >();
    else if (m_max_num_sharers <= 128)
@@ -109,12 +213,15 @@ Directory::createDirectoryEntrySized()
    {
       case FULL_MAP:
          m_use_max_hw_sharers = m_max_num_sharers;
+         m_footprint_bytes += sizeof(DirectoryEntryLimitedNoBroadcast<DirectorySharers>);
          return new DirectoryEntryLimitedNoBroadcast<DirectorySharers>(m_max_num_sharers, m_max_num_sharers);
 
       case LIMITED_NO_BROADCAST:
+         m_footprint_bytes += sizeof(DirectoryEntryLimitedNoBroadcast<DirectorySharers>);
          return new DirectoryEntryLimitedNoBroadcast<DirectorySharers>(m_max_hw_sharers, m_max_num_sharers);
 
       case LIMITLESS:
+         m_footprint_bytes += sizeof(DirectoryEntryLimitless<DirectorySharers>);
          return new DirectoryEntryLimitless<DirectorySharers>(m_max_hw_sharers, m_max_num_sharers, m_limitless_software_trap_penalty);
 
       default:
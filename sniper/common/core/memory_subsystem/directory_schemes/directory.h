@@ -2,9 +2,12 @@
 #define __DIRECTORY_H__
 
 #include "directory_entry.h"
+#include "directory_entry_sparse.h"
 #include "fixed_types.h"
 #include "subsecond_time.h"
 
+#include <vector>
+
 class Directory
 {
    public:
@@ -13,6 +16,7 @@ class Directory
          FULL_MAP = 0,
          LIMITED_NO_BROADCAST,
          LIMITLESS,
+         SPARSE,
          NUM_DIRECTORY_TYPES
       };
 
@@ -29,18 +33,30 @@ class Directory
 
       DirectoryEntry** m_directory_entry_list;
 
+      // SPARSE: all entries live in one arena, laid out set by set (entry_num = set * associativity + way),
+      // with their sharer bits, or coarse or cluster vectors and pointers, in a second contiguous array
+      SparseDirectoryParams m_sparse_params;
+      DirectoryEntrySparse* m_sparse_entries;
+      std::vector<UInt64> m_sparse_sharers;
+
+      UInt64 m_footprint_bytes;
+      UInt64 m_sharer_bits;          // SPARSE: sharer state of the modeled hardware, for the configured encoding
+
    public:
       Directory(core_id_t core_id, String directory_type_str, UInt32 num_entries, UInt32 max_hw_sharers, UInt32 max_num_sharers);
       ~Directory();
 
       DirectoryEntry* getDirectoryEntry(UInt32 entry_num);
-      void setDirectoryEntry(UInt32 entry_num, DirectoryEntry* directory_entry);
+      // Detach the entry in slot entry_num (so it can be kept around while it is being nullified) and leave a fresh
+      // entry in its place. The returned entry is owned by the caller.
+      DirectoryEntry* evictDirectoryEntry(UInt32 entry_num);
       DirectoryEntry* createDirectoryEntry();
       template <class DirectorySharers> DirectoryEntry* createDirectoryEntrySized();
 
       UInt32 getMaxHwSharers() const { return m_use_max_hw_sharers; }
 
       static DirectoryType parseDirectoryType(String directory_type_str);
+      static SparseDirectoryParams::Encoding parseSparseEncoding(String encoding_str);
 };
 
 #endif /* __DIRECTORY_H__ */
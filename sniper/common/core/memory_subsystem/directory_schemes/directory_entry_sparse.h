@@ -0,0 +1,355 @@
+#ifndef __DIRECTORY_ENTRY_SPARSE_H__
+#define __DIRECTORY_ENTRY_SPARSE_H__
+
+#include "directory_entry.h"
+#include "subsecond_time.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Shared, read-only description of how a sparse directory encodes its sharers
+struct SparseDirectoryParams
+{
+   enum Encoding
+   {
+      FULL_MAP = 0,     // One bit per core
+      COARSE_VECTOR,    // Exact pointers, one bit per group of <group_size> cores once they overflow
+      HIERARCHICAL,     // Exact pointers, one bit per cluster of <group_size> cores backed by cluster directories
+      NUM_ENCODINGS
+   };
+
+   Encoding encoding;
+   UInt32 num_cores;
+   UInt32 group_size;
+   UInt32 num_groups;
+   UInt32 num_pointers;
+   UInt32 num_words;          // 64-bit words of full-map sharer bits per entry (0 unless FULL_MAP)
+   UInt32 num_group_words;    // 64-bit words of coarse or cluster vector per entry (0 for FULL_MAP)
+   UInt32 num_pointer_words;  // 64-bit words of 16-bit sharer pointers per entry (0 for FULL_MAP)
+   UInt32 entry_words;        // num_words + num_group_words + num_pointer_words
+   UInt32 hw_bits;            // Sharer bits per entry in the modeled hardware
+   SubsecondTime cluster_access_time;
+   UInt64* footprint_bytes;   // Owning directory's footprint, entries add their overflow sets to it
+};
+
+// Directory entry living in the contiguous arena of a sparse Directory.
+//
+// full_map keeps one bit per core.  coarse_vector and hierarchical keep up to
+// num_pointers exact sharer pointers and a vector with one bit per group:
+// - As long as the pointers suffice, the sharers are known exactly.
+// - coarse_vector: on overflow every sharer's group bit is set, and the bits
+//   stay set until the line has no sharers left.  getSharersList() returns
+//   every core in the marked groups (non-sharers ignore the invalidation).
+// - hierarchical: the top level always knows which clusters share the line.
+//   On overflow the exact sharers are resolved by the cluster directories at
+//   the cost of one cluster lookup, until the pointers suffice again.
+// The MSI protocol relies on hasSharer() and exact sharer counts, so entries
+// that overflow their pointers also keep the exact sharer list off-arena.
+// It stands in for the private caches (or cluster directories) answering for
+// themselves and is only allocated for lines with more than num_pointers sharers.
+class DirectoryEntrySparse : public DirectoryEntry
+{
+   protected:
+      const SparseDirectoryParams* m_params;
+      UInt64* m_sharers;   // Full-map bits, num_words
+      UInt64* m_groups;    // Coarse or cluster vector, num_group_words, follows m_sharers in the arena
+      UInt64* m_pointers;  // Sharer pointers, num_pointer_words, follows m_groups in the arena
+      UInt32 m_num_sharers;
+      std::vector<core_id_t>* m_overflow;   // Exact sharers once the pointers overflowed, NULL otherwise
+
+      static bool testBit(const UInt64* bits, UInt32 index) { return (bits[index >> 6] >> (index & 63)) & 1; }
+      static void setBit(UInt64* bits, UInt32 index) { bits[index >> 6] |= UInt64(1) << (index & 63); }
+      static void clearBit(UInt64* bits, UInt32 index) { bits[index >> 6] &= ~(UInt64(1) << (index & 63)); }
+
+      bool isFullMap() const { return m_params->encoding == SparseDirectoryParams::FULL_MAP; }
+
+      core_id_t getPointer(UInt32 index) const { return (m_pointers[index >> 2] >> ((index & 3) << 4)) & 0xffff; }
+      void setPointer(UInt32 index, core_id_t core_id)
+      {
+         UInt32 shift = (index & 3) << 4;
+         m_pointers[index >> 2] = (m_pointers[index >> 2] & ~(UInt64(0xffff) << shift)) | (UInt64(core_id) << shift);
+      }
+
+      UInt32 getGroup(core_id_t core_id) const { return core_id / m_params->group_size; }
+
+      bool groupHasSharer(UInt32 group) const
+      {
+         if (m_overflow)
+         {
+            for(std::vector<core_id_t>::const_iterator it = m_overflow->begin(); it != m_overflow->end(); ++it)
+               if (getGroup(*it) == group)
+                  return true;
+         }
+         else
+         {
+            for(UInt32 i = 0; i < m_num_sharers; ++i)
+               if (getGroup(getPointer(i)) == group)
+                  return true;
+         }
+         return false;
+      }
+
+      size_t overflowBytes() const
+      {
+         return m_overflow ? sizeof(*m_overflow) + m_overflow->capacity() * sizeof(core_id_t) : 0;
+      }
+
+      void freeOverflow()
+      {
+         if (m_overflow)
+         {
+            *m_params->footprint_bytes -= overflowBytes();
+            delete m_overflow;
+            m_overflow = NULL;
+         }
+      }
+
+      // Move the pointers to an exact off-arena list, which can hold any number of sharers
+      void overflow()
+      {
+         m_overflow = new std::vector<core_id_t>();
+         m_overflow->reserve(m_params->num_pointers + 1);
+         for(UInt32 i = 0; i < m_num_sharers; ++i)
+            m_overflow->push_back(getPointer(i));
+         *m_params->footprint_bytes += overflowBytes();
+
+         if (m_params->encoding == SparseDirectoryParams::COARSE_VECTOR)
+            for(UInt32 i = 0; i < m_num_sharers; ++i)
+               setBit(m_groups, getGroup(getPointer(i)));
+      }
+
+   public:
+      DirectoryEntrySparse()
+         : DirectoryEntry()
+         , m_params(NULL)
+         , m_sharers(NULL)
+         , m_groups(NULL)
+         , m_pointers(NULL)
+         , m_num_sharers(0)
+         , m_overflow(NULL)
+      {}
+
+      ~DirectoryEntrySparse()
+      {
+         if (m_params)
+            freeOverflow();
+      }
+
+      // Arena entries are constructed in bulk and bound to their storage (entry_words) afterwards
+      void init(const SparseDirectoryParams* params, UInt64* storage)
+      {
+         m_params = params;
+         m_sharers = storage;
+         m_groups = m_sharers + params->num_words;
+         m_pointers = m_groups + params->num_group_words;
+         reset();
+      }
+
+      void reset()
+      {
+         m_address = INVALID_ADDRESS;
+         m_directory_block_info = DirectoryBlockInfo();
+         m_owner_id = INVALID_CORE_ID;
+         m_forwarder_id = INVALID_CORE_ID;
+         m_num_sharers = 0;
+         freeOverflow();
+         memset(m_sharers, 0, m_params->entry_words * sizeof(UInt64));
+      }
+
+      void copyFrom(const DirectoryEntrySparse& other)
+      {
+         m_address = other.m_address;
+         m_directory_block_info = other.m_directory_block_info;
+         m_owner_id = other.m_owner_id;
+         m_forwarder_id = other.m_forwarder_id;
+         m_num_sharers = other.m_num_sharers;
+         memcpy(m_sharers, other.m_sharers, m_params->entry_words * sizeof(UInt64));
+         freeOverflow();
+         if (other.m_overflow)
+         {
+            m_overflow = new std::vector<core_id_t>(*other.m_overflow);
+            *m_params->footprint_bytes += overflowBytes();
+         }
+      }
+
+      bool hasSharer(core_id_t sharer_id)
+      {
+         if (isFullMap())
+            return testBit(m_sharers, sharer_id);
+         if (m_overflow)
+            return std::find(m_overflow->begin(), m_overflow->end(), sharer_id) != m_overflow->end();
+         for(UInt32 i = 0; i < m_num_sharers; ++i)
+            if (getPointer(i) == sharer_id)
+               return true;
+         return false;
+      }
+
+      bool addSharer(core_id_t sharer_id, UInt32 max_hw_sharers)
+      {
+         assert(!hasSharer(sharer_id));
+         if (isFullMap())
+         {
+            setBit(m_sharers, sharer_id);
+         }
+         else
+         {
+            if (!m_overflow && m_num_sharers < m_params->num_pointers)
+               setPointer(m_num_sharers, sharer_id);
+            else
+            {
+               if (!m_overflow)
+                  overflow();
+               size_t bytes = overflowBytes();
+               m_overflow->push_back(sharer_id);
+               *m_params->footprint_bytes += overflowBytes() - bytes;
+            }
+            if (m_overflow || m_params->encoding == SparseDirectoryParams::HIERARCHICAL)
+               setBit(m_groups, getGroup(sharer_id));
+         }
+         ++m_num_sharers;
+         return true;
+      }
+
+      void removeSharer(core_id_t sharer_id, bool reply_expected)
+      {
+         assert(!reply_expected);
+         assert(hasSharer(sharer_id));
+         if (isFullMap())
+         {
+            clearBit(m_sharers, sharer_id);
+            --m_num_sharers;
+            return;
+         }
+
+         if (m_overflow)
+         {
+            std::vector<core_id_t>::iterator it = std::find(m_overflow->begin(), m_overflow->end(), sharer_id);
+            *it = m_overflow->back();
+            m_overflow->pop_back();
+         }
+         else
+         {
+            UInt32 index = 0;
+            while(getPointer(index) != sharer_id)
+               ++index;
+            setPointer(index, getPointer(m_num_sharers - 1));
+            setPointer(m_num_sharers - 1, 0);
+         }
+         --m_num_sharers;
+
+         if (m_params->encoding == SparseDirectoryParams::HIERARCHICAL)
+         {
+            // The cluster directory reports when it no longer holds the line
+            UInt32 group = getGroup(sharer_id);
+            if (!groupHasSharer(group))
+               clearBit(m_groups, group);
+            // and once few enough sharers are left, they fit in the pointers again
+            if (m_overflow && m_num_sharers <= m_params->num_pointers)
+            {
+               for(UInt32 i = 0; i < m_num_sharers; ++i)
+                  setPointer(i, (*m_overflow)[i]);
+               freeOverflow();
+            }
+         }
+         else if (m_num_sharers == 0)
+         {
+            // A coarse vector cannot tell which sharers are left, it is only cleared along with the line
+            freeOverflow();
+            memset(m_groups, 0, m_params->num_group_words * sizeof(UInt64));
+         }
+      }
+
+      UInt32 getNumSharers() { return m_num_sharers; }
+
+      core_id_t getOwner() { return m_owner_id; }
+      void setOwner(core_id_t owner_id)
+      {
+         if (owner_id != INVALID_CORE_ID)
+            assert(hasSharer(owner_id));
+         m_owner_id = owner_id;
+      }
+
+      core_id_t getOneSharer()
+      {
+         assert(m_num_sharers > 0);
+         if (!isFullMap())
+            return m_overflow ? m_overflow->front() : getPointer(0);
+         for(UInt32 w = 0; w < m_params->num_words; ++w)
+            if (m_sharers[w])
+               return (w << 6) + __builtin_ctzll(m_sharers[w]);
+         assert(false);
+         return INVALID_CORE_ID;
+      }
+
+      std::pair<bool, std::vector<core_id_t> > getSharersList()
+      {
+         std::pair<bool, std::vector<core_id_t> > sharers_list;
+         sharers_list.first = false;
+
+         if (isFullMap())
+         {
+            sharers_list.second.reserve(m_num_sharers);
+            for(UInt32 w = 0; w < m_params->num_words; ++w)
+               for(UInt64 bits = m_sharers[w]; bits; bits &= bits - 1)
+                  sharers_list.second.push_back((w << 6) + __builtin_ctzll(bits));
+         }
+         else if (!m_overflow)
+         {
+            sharers_list.second.reserve(m_num_sharers);
+            for(UInt32 i = 0; i < m_num_sharers; ++i)
+               sharers_list.second.push_back(getPointer(i));
+         }
+         else if (m_params->encoding == SparseDirectoryParams::COARSE_VECTOR)
+         {
+            // Every core in a marked group is a potential sharer
+            for(UInt32 w = 0; w < m_params->num_group_words; ++w)
+               for(UInt64 bits = m_groups[w]; bits; bits &= bits - 1)
+               {
+                  core_id_t group_start = ((w << 6) + __builtin_ctzll(bits)) * m_params->group_size;
+                  core_id_t group_end = std::min(group_start + m_params->group_size, m_params->num_cores);
+                  for(core_id_t core_id = group_start; core_id < group_end; ++core_id)
+                     sharers_list.second.push_back(core_id);
+               }
+         }
+         else
+         {
+            // Resolved by the cluster directories of the marked clusters
+            sharers_list.second = *m_overflow;
+            std::sort(sharers_list.second.begin(), sharers_list.second.end());
+         }
+
+         return sharers_list;
+      }
+
+      SubsecondTime getLatency()
+      {
+         // Once the pointers overflowed, the top level only knows which clusters share the line
+         if (m_params->encoding == SparseDirectoryParams::HIERARCHICAL && m_overflow)
+            return m_params->cluster_access_time;
+         return SubsecondTime::Zero();
+      }
+
+   private:
+      // Entries own their overflow list and are bound to arena storage, they are not copyable
+      DirectoryEntrySparse(const DirectoryEntrySparse&);
+      DirectoryEntrySparse& operator=(const DirectoryEntrySparse&);
+};
+
+// Stand-alone copy of an arena entry, used for entries that are being
+// replaced and must outlive the arena slot they were evicted from
+class DirectoryEntrySparseCopy : public DirectoryEntrySparse
+{
+   private:
+      std::vector<UInt64> m_storage;
+
+   public:
+      DirectoryEntrySparseCopy(const DirectoryEntrySparse& other, const SparseDirectoryParams* params)
+         : DirectoryEntrySparse()
+         , m_storage(params->entry_words)
+      {
+         init(params, m_storage.data());
+         copyFrom(other);
+      }
+};
+
+#endif /* __DIRECTORY_ENTRY_SPARSE_H__ */
@@ -22,10 +22,13 @@ DramCache::DramCache(MemoryManagerBase* memory_manager,
           "perf_model/dram/cache/data_access_time", m_core_id))),
       m_tags_access_time(SubsecondTime::NS(Sim()->getCfg()->getIntArray(
           "perf_model/dram/cache/tags_access_time", m_core_id))),
+      m_decompression_time(SubsecondTime::Zero()),
       m_data_array_bandwidth(
           8 * Sim()->getCfg()->getFloat("perf_model/dram/cache/bandwidth")),
       m_home_lookup(home_lookup),
       m_dram_cntlr(dram_cntlr),
+      m_compressible(Sim()->getCfg()->getBoolDefault(
+          "perf_model/dram/cache/compressible", false)),
       m_queue_model(NULL),
       m_prefetcher(NULL),
       m_prefetch_mshr("dram-cache.prefetch-mshr", m_core_id, 16),
@@ -35,6 +38,7 @@ DramCache::DramCache(MemoryManagerBase* memory_manager,
       m_write_misses(0),
       m_hits_prefetch(0),
       m_prefetches(0),
+      m_burst_extra_lines(0),
       m_prefetch_mshr_delay(SubsecondTime::Zero()) {
 
   UInt32 cache_size = Sim()->getCfg()->getIntArray(
@@ -49,9 +53,16 @@ DramCache::DramCache(MemoryManagerBase* memory_manager,
       "associativity(%d) * block_size(%d)",
       cache_size, num_sets, associativity, m_cache_block_size);
 
+  // Compressed DRAM caches store DISH-compressed superblocks, several lines
+  // then share one data way and are transferred in a single burst
+  if (m_compressible) {
+    m_decompression_time = SubsecondTime::NS(Sim()->getCfg()->getIntArray(
+        "perf_model/dram/cache/decompression_time", m_core_id));
+  }
+
   m_cache = new Cache(
       "dram-cache", "perf_model/dram/cache", m_core_id, num_sets, associativity,
-      m_cache_block_size, false,  // Cannot be compressed
+      m_cache_block_size, m_compressible,
       Sim()->getCfg()->getStringArray(
           "perf_model/dram/cache/replacement_policy", m_core_id),
       CacheBase::PR_L1_CACHE, /* Accelerator cache for prefetches only */
@@ -84,6 +95,13 @@ DramCache::DramCache(MemoryManagerBase* memory_manager,
   registerStatsMetric("dram-cache", m_core_id, "prefetches", &m_prefetches);
   registerStatsMetric("dram-cache", m_core_id, "prefetch-mshr-delay",
                       &m_prefetch_mshr_delay);
+  registerStatsMetric("dram-cache", m_core_id, "burst-extra-lines",
+                      &m_burst_extra_lines);
+  // Bytes of (uncompressed) data resident in the cache, exceeds cache_size
+  // when lines are compressed
+  Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(
+      "dram-cache", m_core_id, "effective-capacity", getEffectiveCapacity,
+      reinterpret_cast<UInt64>(this)));
 }
 
 DramCache::~DramCache() {
@@ -165,21 +183,35 @@ std::pair<bool, SubsecondTime> DramCache::doAccess(
 
       // If prefetch is still in progress, delay
       SubsecondTime t_completed = m_prefetch_mshr.getTagCompletionTime(addr);
-      if (t_completed != SubsecondTime::MaxTime() &&
-          t_completed > now + latency) {
+      bool late = t_completed != SubsecondTime::MaxTime() &&
+                  t_completed > now + latency;
+      if (late) {
         m_prefetch_mshr_delay += t_completed - (now + latency);
         latency = t_completed - now;
       }
+      if (m_prefetcher) m_prefetcher->notifyPrefetchHit(late);
     }
 
+    // Stores to a compressed superblock can change its compression factor
+    // and force co-resident lines out
+    WritebackLines writebacks;
+    writebacks.reserve(m_cache->getSuperblockSize());
+
     m_cache->accessSingleLine(addr, access_type, acc_data, m_cache_block_size,
-                              now + latency, true, nullptr /* No writebacks */,
-                              nullptr /* No controller reference */);
+                              now + latency, true, false, &writebacks,
+                              m_compressible ? &m_cache_hooks : nullptr);
 
-    latency += accessDataArray(access_type, requester, now + latency, perf);
+    latency +=
+        accessDataArray(access_type, addr, requester, now + latency, perf);
     if (access_type == Cache::STORE) {
+      // The line may have been re-inserted into another way
+      block_info =
+          dynamic_cast<PrL1CacheBlockInfo*>(m_cache->peekSingleLine(addr));
+      assert(block_info);
       block_info->setCState(CacheState::MODIFIED);
     }
+
+    handleWritebacks(writebacks, requester, now + latency);
   } else {
     // Cache peek operation returned a null pointer, indicating that it did
     // not contain the requested block
@@ -210,10 +242,17 @@ void DramCache::putDataToCache(Cache::access_t access_type, IntPtr addr,
                                SubsecondTime now) {
 
   WritebackLines writebacks;
-  writebacks.reserve(1);  // Reserve space for only one possible eviction
-
-  m_cache->insertSingleLine(addr, ins_data, now, false, &writebacks,
-                            nullptr /* No controller reference */);
+  // Replacing a superblock evicts all of its lines
+  writebacks.reserve(m_cache->getSuperblockSize());
+
+  // DRAM is not modeled functionally, so only stores carry a valid line.
+  // Load fills use the program data like the rest of the hierarchy does.
+  // Without compression, no block data is muxed in.
+  bool is_fill =
+      m_compressible && access_type == Cache::STORE && ins_data != nullptr;
+  m_cache->insertSingleLine(addr, is_fill ? ins_data : nullptr, now, is_fill,
+                            &writebacks,
+                            m_compressible ? &m_cache_hooks : nullptr);
 
   CacheBlockInfo* block_info = m_cache->peekSingleLine(addr);
   if (access_type == Cache::STORE) {
@@ -223,7 +262,13 @@ void DramCache::putDataToCache(Cache::access_t access_type, IntPtr addr,
   }
 
   // Write to data array off-line, so it doesn't affect return latency
-  accessDataArray(Cache::STORE, requester, now, nullptr);
+  accessDataArray(Cache::STORE, addr, requester, now, nullptr);
+
+  handleWritebacks(writebacks, requester, now);
+}
+
+void DramCache::handleWritebacks(WritebackLines& writebacks,
+                                 core_id_t requester, SubsecondTime now) {
 
   // Writeback to DRAM done off-line, so don't affect return latency
   if (!writebacks.empty()) {
@@ -234,6 +279,10 @@ void DramCache::putDataToCache(Cache::access_t access_type, IntPtr addr,
       const Byte* evict_block_data           = std::get<2>(wb).get();
       Byte* evict_block_data_unsafe = const_cast<Byte*>(evict_block_data);
 
+      // Prefetched line that is evicted without ever being used
+      if (m_prefetcher && evict_block_info->hasOption(CacheBlockInfo::PREFETCH))
+        m_prefetcher->notifyPrefetchEvicted();
+
       if (evict_block_info->getCState() == CacheState::MODIFIED) {
         m_dram_cntlr->putDataToDram(evict_addr, requester,
                                     evict_block_data_unsafe, now);
@@ -243,12 +292,25 @@ void DramCache::putDataToCache(Cache::access_t access_type, IntPtr addr,
 }
 
 SubsecondTime DramCache::accessDataArray(Cache::access_t access_type,
-                                         core_id_t requester,
+                                         IntPtr addr, core_id_t requester,
                                          SubsecondTime t_start,
                                          ShmemPerf* perf) {
 
+  // A burst always transfers one data way.  When the way holds a compressed
+  // superblock, the co-resident lines come along with the same burst but have
+  // to be decompressed (loads) or recompressed (stores).
   SubsecondTime processing_time = m_data_array_bandwidth.getRoundedLatency(
       8 * m_cache_block_size);  // bytes to bits
+  SubsecondTime compression_time = SubsecondTime::Zero();
+
+  if (m_cache->isCompressible()) {
+    UInt32 lines_per_burst = m_cache->getSuperblockOccupancy(addr);
+    if (lines_per_burst > 1) {
+      compression_time = m_decompression_time;
+      if (access_type == Cache::LOAD)
+        m_burst_extra_lines += lines_per_burst - 1;
+    }
+  }
 
   // Compute Queue Delay
   SubsecondTime queue_delay;
@@ -263,18 +325,27 @@ SubsecondTime DramCache::accessDataArray(Cache::access_t access_type,
   perf->updateTime(t_start + queue_delay, ShmemPerf::DRAM_CACHE_QUEUE);
   perf->updateTime(t_start + queue_delay + processing_time,
                    ShmemPerf::DRAM_CACHE_BUS);
-  perf->updateTime(t_start + queue_delay + processing_time + m_data_access_time,
+  SubsecondTime data_time = m_data_access_time + compression_time;
+  perf->updateTime(t_start + queue_delay + processing_time + data_time,
                    ShmemPerf::DRAM_CACHE_DATA);
 
-  return queue_delay + processing_time + m_data_access_time;
+  return queue_delay + processing_time + data_time;
+}
+
+UInt64 DramCache::getEffectiveCapacity(String objectName, UInt32 index,
+                                       String metricName, UInt64 arg) {
+  const DramCache* dram_cache = reinterpret_cast<const DramCache*>(arg);
+
+  return dram_cache->m_cache->getNumValidBlocks() *
+         dram_cache->m_cache_block_size;
 }
 
 void DramCache::callPrefetcher(IntPtr train_addr, bool dram_cache_hit,
                                bool prefetch_hit, SubsecondTime t_issue) {
 
-  // Always train the prefetcher
+  // Always train the prefetcher, the requesting PC is not known here
   std::vector<IntPtr> prefetch_list =
-      m_prefetcher->getNextAddress(train_addr, INVALID_CORE_ID);
+      m_prefetcher->getNextAddress(train_addr, 0, INVALID_CORE_ID);
 
   // Only do prefetches on misses, or on hits to lines previously brought in
   // by the prefetcher (if enabled)
@@ -305,6 +376,7 @@ void DramCache::callPrefetcher(IntPtr train_addr, bool dram_cache_hit,
         m_prefetch_mshr.getCompletionTime(t_issue, dram_latency, prefetch_addr);
 
         ++m_prefetches;
+        m_prefetcher->notifyPrefetchIssued();
       }
     }
   }
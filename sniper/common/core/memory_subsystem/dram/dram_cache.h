@@ -29,11 +29,17 @@ class DramCache : public DramCntlrInterface {
   UInt32 m_cache_block_size;
   SubsecondTime m_data_access_time;
   SubsecondTime m_tags_access_time;
+  SubsecondTime m_decompression_time;
   ComponentBandwidth m_data_array_bandwidth;
 
   AddressHomeLookup* m_home_lookup;
   DramCntlrInterface* m_dram_cntlr;
   Cache* m_cache;
+  bool m_compressible;
+  // The DRAM cache has no coherence controller, but Cache needs a controller
+  // reference to mux in block data (required for compression).  Only passed
+  // to the cache when it is compressible.
+  CacheCntlr m_cache_hooks;
   QueueModel* m_queue_model;
   Prefetcher* m_prefetcher;
   bool m_prefetch_on_prefetch_hit;
@@ -42,6 +48,7 @@ class DramCache : public DramCntlrInterface {
   UInt64 m_reads, m_writes;
   UInt64 m_read_misses, m_write_misses;
   UInt64 m_hits_prefetch, m_prefetches;
+  UInt64 m_burst_extra_lines;
   SubsecondTime m_prefetch_mshr_delay;
 
   std::pair<bool, SubsecondTime> doAccess(Cache::access_t access_type,
@@ -51,9 +58,14 @@ class DramCache : public DramCntlrInterface {
   void putDataToCache(Cache::access_t access_type, IntPtr addr,
                       core_id_t requester, const Byte* wr_data,
                       SubsecondTime now);
-  SubsecondTime accessDataArray(Cache::access_t access_type,
+  SubsecondTime accessDataArray(Cache::access_t access_type, IntPtr addr,
                                 core_id_t requester, SubsecondTime t_start,
                                 ShmemPerf* perf);
+  void handleWritebacks(WritebackLines& writebacks, core_id_t requester,
+                        SubsecondTime now);
+
+  static UInt64 getEffectiveCapacity(String objectName, UInt32 index,
+                                     String metricName, UInt64 arg);
   void callPrefetcher(IntPtr train_addr, bool dram_cache_hit, bool prefetch_hit,
                       SubsecondTime t_issue);
 };
@@ -0,0 +1,132 @@
+#include "best_offset_prefetcher.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+#include "log.h"
+
+#include <algorithm>
+
+static const IntPtr PAGE_SIZE = 4096;
+
+BestOffsetPrefetcher::BestOffsetPrefetcher(String configName, core_id_t core_id)
+   : m_cache_block_size(Sim()->getCfg()->getInt("perf_model/l1_dcache/cache_block_size"))
+   , m_rr_size(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/bop/rr_size", core_id))
+   , m_score_max(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/bop/score_max", core_id))
+   , m_round_max(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/bop/round_max", core_id))
+   , m_bad_score(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/bop/bad_score", core_id))
+   , m_rr_table(m_rr_size, INVALID_ADDRESS)
+   , m_test_index(0)
+   , m_round(0)
+   , m_best_offset(1)
+   , m_prefetch_on(true)
+   , m_num_phases(0)
+   , m_num_phases_off(0)
+   , m_throttle(configName, "bop", core_id,
+        Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/bop/degree", core_id), 1)
+{
+   LOG_ASSERT_ERROR(m_rr_size > 0 && (m_rr_size & (m_rr_size - 1)) == 0, "prefetcher/bop/rr_size must be a power of two");
+
+   // Candidate offsets are the integers up to offsets_max whose only prime factors are 2, 3 and 5,
+   // this keeps the list short while still covering most strides seen in practice
+   UInt32 offsets_max = Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/bop/offsets_max", core_id);
+   for(UInt32 offset = 1; offset <= offsets_max; ++offset)
+   {
+      UInt32 n = offset;
+      while (n % 2 == 0) n /= 2;
+      while (n % 3 == 0) n /= 3;
+      while (n % 5 == 0) n /= 5;
+      if (n == 1)
+         m_offsets.push_back(offset);
+   }
+   LOG_ASSERT_ERROR(!m_offsets.empty(), "prefetcher/bop/offsets_max must be at least 1");
+   m_scores.resize(m_offsets.size(), 0);
+
+   String name = "prefetcher-" + configName;
+   std::replace(name.begin(), name.end(), '/', '-');
+   registerStatsMetric(name, core_id, "bop-phases", &m_num_phases);
+   registerStatsMetric(name, core_id, "bop-phases-off", &m_num_phases_off);
+}
+
+UInt32
+BestOffsetPrefetcher::rrIndex(IntPtr line) const
+{
+   return (line ^ (line >> 8)) & (m_rr_size - 1);
+}
+
+bool
+BestOffsetPrefetcher::rrLookup(IntPtr line) const
+{
+   return m_rr_table[rrIndex(line)] == line;
+}
+
+void
+BestOffsetPrefetcher::rrInsert(IntPtr line)
+{
+   m_rr_table[rrIndex(line)] = line;
+}
+
+void
+BestOffsetPrefetcher::endPhase()
+{
+   UInt32 best = std::max_element(m_scores.begin(), m_scores.end()) - m_scores.begin();
+   m_best_offset = m_offsets[best];
+   m_prefetch_on = m_scores[best] > m_bad_score;
+
+   ++m_num_phases;
+   if (!m_prefetch_on)
+      ++m_num_phases_off;
+
+   std::fill(m_scores.begin(), m_scores.end(), 0);
+   m_test_index = 0;
+   m_round = 0;
+}
+
+void
+BestOffsetPrefetcher::learn(IntPtr line)
+{
+   // Test one offset per access, round-robin over the candidate list
+   if (rrLookup(line - m_offsets[m_test_index]))
+   {
+      if (++m_scores[m_test_index] >= m_score_max)
+      {
+         endPhase();
+         return;
+      }
+   }
+
+   if (++m_test_index == m_offsets.size())
+   {
+      m_test_index = 0;
+      if (++m_round >= m_round_max)
+         endPhase();
+   }
+}
+
+std::vector<IntPtr>
+BestOffsetPrefetcher::getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id)
+{
+   std::vector<IntPtr> addresses;
+   IntPtr line = current_address / m_cache_block_size;
+
+   learn(line);
+
+   // The original design inserts Y-D into the RR table when prefetch Y completes, which equals the
+   // trigger line X.  Fill notifications are not available to prefetchers here, so X is inserted at
+   // trigger time instead; this loses the lateness filtering but keeps the scored offsets identical.
+   rrInsert(line);
+
+   if (!m_prefetch_on)
+      return addresses;
+
+   UInt32 degree = m_throttle.getDegree();
+   for(UInt32 i = 1; i <= degree; ++i)
+   {
+      IntPtr prefetch_address = (line + i * m_best_offset) * m_cache_block_size;
+      // Offsets are learnt on physical lines, do not cross into a page we know nothing about
+      if (prefetch_address / PAGE_SIZE != current_address / PAGE_SIZE)
+         break;
+      addresses.push_back(prefetch_address);
+   }
+
+   return addresses;
+}
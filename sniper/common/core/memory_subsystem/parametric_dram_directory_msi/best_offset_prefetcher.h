@@ -0,0 +1,48 @@
+#pragma once
+
+#include "prefetcher.h"
+#include "prefetch_throttle.h"
+
+// Best-offset prefetcher (Michaud, HPCA 2016).
+// A learning phase tests a fixed list of candidate offsets d against the
+// recent-requests (RR) table: offset d scores a point on access X when line
+// X-d was recently requested.  At the end of a phase the best-scoring offset
+// becomes the prefetch offset D, or prefetching is turned off when even the
+// best score does not exceed <bad_score>.
+class BestOffsetPrefetcher : public Prefetcher
+{
+   public:
+      BestOffsetPrefetcher(String configName, core_id_t core_id);
+      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id);
+
+      virtual void notifyPrefetchIssued() { m_throttle.notifyIssued(); }
+      virtual void notifyPrefetchHit(bool late) { m_throttle.notifyUseful(late); }
+      virtual void notifyPrefetchEvicted() { m_throttle.notifyEvicted(); }
+
+   private:
+      const UInt32 m_cache_block_size;
+      const UInt32 m_rr_size;
+      const UInt32 m_score_max;
+      const UInt32 m_round_max;
+      const UInt32 m_bad_score;
+
+      std::vector<SInt64> m_offsets;
+      std::vector<UInt32> m_scores;
+      std::vector<IntPtr> m_rr_table;
+
+      UInt32 m_test_index;
+      UInt32 m_round;
+      SInt64 m_best_offset;
+      bool m_prefetch_on;
+
+      UInt64 m_num_phases;
+      UInt64 m_num_phases_off;
+
+      PrefetchThrottle m_throttle;
+
+      UInt32 rrIndex(IntPtr line) const;
+      bool rrLookup(IntPtr line) const;
+      void rrInsert(IntPtr line);
+      void learn(IntPtr line);
+      void endPhase();
+};
@@ -9,6 +9,7 @@
 #include "simulator.h"
 #include "subsecond_time.h"
 
+#include <algorithm>
 #include <cstring>
 
 // Define to allow private L2 caches not to take the stack lock.
@@ -152,6 +153,11 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component, String name,
       m_coherent(cache_params.coherent),
       m_prefetch_on_prefetch_hit(false),
       m_l1_mshr(cache_params.outstanding_misses > 0),
+      m_superblock_prefetch(
+          cache_params.compressible &&
+          Sim()->getCfg()->getBoolArray("perf_model/" + cache_params.configName +
+                                            "/superblock_prefetch",
+                                        core_id)),
       m_core_id(core_id),
       m_cache_block_size(cache_block_size),
       m_cache_writethrough(cache_params.writethrough),
@@ -236,6 +242,12 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component, String name,
                       &stats.qbs_query_latency);
   registerStatsMetric(name, core_id, "mshr-latency", &stats.mshr_latency);
   registerStatsMetric(name, core_id, "prefetches", &stats.prefetches);
+  registerStatsMetric(name, core_id, "prefetch-free-slot-fills",
+                      &stats.prefetch_free_slot_fills);
+  registerStatsMetric(name, core_id, "prefetch-superblock-evictions",
+                      &stats.prefetch_superblock_evictions);
+  registerStatsMetric(name, core_id, "superblock-evict-msgs",
+                      &stats.superblock_evict_msgs);
   for (CacheState::cstate_t state = CacheState::CSTATE_FIRST;
        state < CacheState::NUM_CSTATE_STATES;
        state = CacheState::cstate_t(int(state) + 1)) {
@@ -363,7 +375,7 @@ void CacheCntlr::setDRAMDirectAccess(DramCntlrInterface* dram_cntlr,
 HitWhere::where_t CacheCntlr::processMemOpFromCore(
     Core::lock_signal_t lock_signal, Core::mem_op_t mem_op_type,
     IntPtr ca_address, UInt32 offset, Byte* data_buf, UInt32 data_length,
-    bool modeled, bool count) {
+    bool modeled, bool count, IntPtr eip) {
   HitWhere::where_t hit_where = HitWhere::MISS;
 
   // Protect against concurrent access from sibling SMT threads
@@ -451,7 +463,7 @@ HitWhere::where_t CacheCntlr::processMemOpFromCore(
     hit_where = (HitWhere::where_t)m_mem_component;
 
     if (cache_block_info->hasOption(CacheBlockInfo::WARMUP) &&
-        Sim()->getInstrumentationMode() != InstMode::CACHE_ONLY) {
+        !InstMode::isWarmup(Sim()->getInstrumentationMode())) {
       stats.hits_warmup++;
       cache_block_info->clearOption(CacheBlockInfo::WARMUP);
     }
@@ -486,14 +498,17 @@ HitWhere::where_t CacheCntlr::processMemOpFromCore(
       // stamp. If so, delay.
       SubsecondTime t_now =
           getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-      if (m_master->mshr.count(ca_address) &&
-          (m_master->mshr[ca_address].t_issue < t_now &&
-           m_master->mshr[ca_address].t_complete > t_now)) {
+      bool late = m_master->mshr.count(ca_address) &&
+                  (m_master->mshr[ca_address].t_issue < t_now &&
+                   m_master->mshr[ca_address].t_complete > t_now);
+      if (late) {
         SubsecondTime latency = m_master->mshr[ca_address].t_complete - t_now;
         stats.mshr_latency += latency;
         getMemoryManager()->incrElapsedTime(latency,
                                             ShmemPerfModel::_USER_THREAD);
       }
+      if (prefetch_hit && m_master->m_prefetcher)
+        m_master->m_prefetcher->notifyPrefetchHit(late);
     }
 
   } else {
@@ -535,7 +550,7 @@ HitWhere::where_t CacheCntlr::processMemOpFromCore(
     MYLOG("processMemOpFromCore l%d before next", m_mem_component);
     hit_where = m_next_cache_cntlr->processShmemReqFromPrevCache(
         this, mem_op_type, ca_address, modeled, count, Prefetch::NONE, t_start,
-        false);
+        false, eip);
     bool next_cache_hit = hit_where != HitWhere::MISS;
     MYLOG("processMemOpFromCore l%d next hit = %d", m_mem_component,
           next_cache_hit);
@@ -566,7 +581,7 @@ HitWhere::where_t CacheCntlr::processMemOpFromCore(
       MYLOG("processMemOpFromCore l%d before next fill", m_mem_component);
       hit_where = m_next_cache_cntlr->processShmemReqFromPrevCache(
           this, mem_op_type, ca_address, false, false, Prefetch::NONE, t_start,
-          true);
+          true, eip);
       MYLOG("processMemOpFromCore l%d after next fill", m_mem_component);
       LOG_ASSERT_ERROR(
           hit_where != HitWhere::MISS,
@@ -650,8 +665,8 @@ HitWhere::where_t CacheCntlr::processMemOpFromCore(
       stats.loads_where[hit_where]++;
   }
 
-  if (modeled && m_master->m_prefetcher) {
-    trainPrefetcher(ca_address, cache_hit, prefetch_hit, t_start);
+  if (modeled && (m_master->m_prefetcher || m_superblock_prefetch)) {
+    trainPrefetcher(ca_address, eip, cache_hit, prefetch_hit, t_start);
   }
 
   // Call Prefetch on next-level caches (but not for atomic instructions as that
@@ -684,7 +699,7 @@ void CacheCntlr::updateHits(Core::mem_op_t mem_op_type, UInt64 hits) {
 
 void CacheCntlr::copyDataFromNextLevel(Core::mem_op_t mem_op_type,
                                        IntPtr address, bool modeled,
-                                       SubsecondTime t_now) {
+                                       SubsecondTime t_now, bool is_prefetch) {
   // TODO: what if it's already gone? someone else may invalitate it between the
   // time it arrived an when we get here...
   LOG_ASSERT_ERROR(
@@ -723,18 +738,45 @@ void CacheCntlr::copyDataFromNextLevel(Core::mem_op_t mem_op_type,
   } else {
     // Insert the Cache Block in our own cache
     insertCacheBlock(address, cstate, data_buf, m_core_id,
-                     ShmemPerfModel::_USER_THREAD, true);
+                     ShmemPerfModel::_USER_THREAD, true, is_prefetch);
     MYLOG("copyDataFromNextLevel l%d done (inserted)", m_mem_component);
   }
 }
 
-void CacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit,
+void CacheCntlr::trainPrefetcher(IntPtr address, IntPtr eip, bool cache_hit,
                                  bool prefetch_hit, SubsecondTime t_issue) {
   ScopedLock sl(getLock());
 
-  // Always train the prefetcher
-  std::vector<IntPtr> prefetchList =
-      m_master->m_prefetcher->getNextAddress(address, m_core_id);
+  // Always train the prefetcher. PC-indexed prefetchers get the PC of the
+  // data access that is being served, which is carried along with the request
+  // down to the lower cache levels (0 for prefetches).
+  std::vector<IntPtr> prefetchList;
+  if (m_master->m_prefetcher) {
+    prefetchList =
+        m_master->m_prefetcher->getNextAddress(address, eip, m_core_id);
+  }
+
+  if (m_superblock_prefetch) {
+    // Compression-aware ordering: first fill the missing blocks of the
+    // superblock that was just accessed, then candidates whose superblock is
+    // already resident. Both can be merged without claiming a new way, only
+    // the remaining candidates may evict a superblock.
+    std::vector<IntPtr> merge_list =
+        m_master->m_cache->getSuperblockVacancies(address);
+    std::vector<IntPtr> evict_list;
+    for (std::vector<IntPtr>::iterator it = prefetchList.begin();
+         it != prefetchList.end(); ++it) {
+      if (std::find(merge_list.begin(), merge_list.end(), *it) !=
+          merge_list.end())
+        continue;
+      if (m_master->m_cache->getSuperblockOccupancy(*it) > 0)
+        merge_list.push_back(*it);
+      else
+        evict_list.push_back(*it);
+    }
+    merge_list.insert(merge_list.end(), evict_list.begin(), evict_list.end());
+    prefetchList.swap(merge_list);
+  }
 
   // Only do prefetches on misses, or on hits to lines previously brought in by
   // the prefetcher (if enabled)
@@ -769,6 +811,8 @@ void CacheCntlr::Prefetch(SubsecondTime t_now) {
         // the cache
         if (!operationPermissibleinCache(address, Core::READ)) {
           address_to_prefetch = address;
+          if (m_master->m_prefetcher)
+            m_master->m_prefetcher->notifyPrefetchIssued();
           // Do at most one prefetch now, save the rest for a future call
           break;
         }
@@ -796,7 +840,7 @@ void CacheCntlr::doPrefetch(IntPtr prefetch_address, SubsecondTime t_start) {
       t_start);  // Start the prefetch at the same time as the original miss
   HitWhere::where_t hit_where =
       processShmemReqFromPrevCache(this, Core::READ, prefetch_address, true,
-                                   true, Prefetch::OWN, t_start, false);
+                                   true, Prefetch::OWN, t_start, false, 0);
 
   if (hit_where == HitWhere::MISS) {
     /* last level miss, a message has been sent. */
@@ -807,7 +851,7 @@ void CacheCntlr::doPrefetch(IntPtr prefetch_address, SubsecondTime t_start) {
 
     hit_where =
         processShmemReqFromPrevCache(this, Core::READ, prefetch_address, false,
-                                     false, Prefetch::OWN, t_start, false);
+                                     false, Prefetch::OWN, t_start, false, 0);
 
     LOG_ASSERT_ERROR(hit_where != HitWhere::MISS,
                      "Line was not there after prefetch");
@@ -826,7 +870,7 @@ void CacheCntlr::doPrefetch(IntPtr prefetch_address, SubsecondTime t_start) {
 HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
     CacheCntlr* requester, Core::mem_op_t mem_op_type, IntPtr address,
     bool modeled, bool count, Prefetch::prefetch_type_t isPrefetch,
-    SubsecondTime t_issue, bool have_write_lock) {
+    SubsecondTime t_issue, bool have_write_lock, IntPtr eip) {
 #ifdef PRIVATE_L2_OPTIMIZATION
   bool have_write_lock_internal = have_write_lock;
   if (!have_write_lock && m_shared_cores > 1) {
@@ -879,7 +923,7 @@ HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
       cache_block_info->clearOption(CacheBlockInfo::PREFETCH);
     }
     if (cache_block_info->hasOption(CacheBlockInfo::WARMUP) &&
-        Sim()->getInstrumentationMode() != InstMode::CACHE_ONLY) {
+        !InstMode::isWarmup(Sim()->getInstrumentationMode())) {
       stats.hits_warmup++;
       cache_block_info->clearOption(CacheBlockInfo::WARMUP);
     }
@@ -897,9 +941,10 @@ HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
       // stamp. If so, delay.
       SubsecondTime t_now =
           getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-      if (m_master->mshr.count(address) &&
-          (m_master->mshr[address].t_issue < t_now &&
-           m_master->mshr[address].t_complete > t_now)) {
+      bool late = m_master->mshr.count(address) &&
+                  (m_master->mshr[address].t_issue < t_now &&
+                   m_master->mshr[address].t_complete > t_now);
+      if (late) {
         SubsecondTime latency = m_master->mshr[address].t_complete - t_now;
         stats.mshr_latency += latency;
         getMemoryManager()->incrElapsedTime(latency,
@@ -909,6 +954,8 @@ HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
             m_mem_component, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS,
             ShmemPerfModel::_USER_THREAD);
       }
+      if (prefetch_hit && m_master->m_prefetcher)
+        m_master->m_prefetcher->notifyPrefetchHit(late);
     }
 
     if (mem_op_type != Core::READ)  // write that hits
@@ -1025,13 +1072,14 @@ HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
       hit_where = m_next_cache_cntlr->processShmemReqFromPrevCache(
           this, mem_op_type, address, modeled, count,
           isPrefetch == Prefetch::NONE ? Prefetch::NONE : Prefetch::OTHER,
-          t_issue, have_write_lock_internal);
+          t_issue, have_write_lock_internal, eip);
       if (hit_where != HitWhere::MISS) {
         cache_hit = true;
         /* get the data for ourselves */
         SubsecondTime t_now =
             getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-        copyDataFromNextLevel(mem_op_type, address, modeled, t_now);
+        copyDataFromNextLevel(mem_op_type, address, modeled, t_now,
+                              isPrefetch != Prefetch::NONE);
         if (isPrefetch != Prefetch::NONE)
           getCacheBlockInfo(address)->setOption(CacheBlockInfo::PREFETCH);
       }
@@ -1093,7 +1141,8 @@ HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
           insertCacheBlock(address,
                            mem_op_type == Core::READ ? CacheState::SHARED
                                                      : CacheState::MODIFIED,
-                           data_buf, m_core_id, ShmemPerfModel::_USER_THREAD, false);
+                           data_buf, m_core_id, ShmemPerfModel::_USER_THREAD, false,
+                           isPrefetch != Prefetch::NONE);
           if (isPrefetch != Prefetch::NONE)
             getCacheBlockInfo(address)->setOption(CacheBlockInfo::PREFETCH);
 
@@ -1122,8 +1171,8 @@ HitWhere::where_t CacheCntlr::processShmemReqFromPrevCache(
     }
   }
 
-  if (modeled && m_master->m_prefetcher) {
-    trainPrefetcher(address, cache_hit, prefetch_hit, t_issue);
+  if (modeled && (m_master->m_prefetcher || m_superblock_prefetch)) {
+    trainPrefetcher(address, eip, cache_hit, prefetch_hit, t_issue);
   }
 
 #ifdef PRIVATE_L2_OPTIMIZATION
@@ -1153,7 +1202,7 @@ void CacheCntlr::notifyPrevLevelEvict(core_id_t core_id,
                                       MemComponent::component_t mem_component,
                                       IntPtr address) {
   MYLOG("@%lx", address);
-  if (m_master->m_evicting_buf && address == m_master->m_evicting_address) {
+  if (getEvictingBuf(address)) {
     MYLOG("here being evicted");
   } else {
 #ifdef ENABLE_TRACK_SHARING_PREVCACHES
@@ -1484,7 +1533,8 @@ void CacheCntlr::retrieveCacheBlock(IntPtr address, Byte* data_buf,
 
 SharedCacheBlockInfo* CacheCntlr::insertCacheBlock(
     IntPtr address, CacheState::cstate_t cstate, Byte* data_buf,
-    core_id_t requester, ShmemPerfModel::Thread_t thread_num, bool is_fill) {
+    core_id_t requester, ShmemPerfModel::Thread_t thread_num, bool is_fill,
+    bool is_prefetch) {
 
   LOG_PRINT("CacheCntlr::insertCacheBlock (fill: %d) l%d @ %lx %p as %c (now %c)",
             is_fill, m_mem_component, address, data_buf, CStateString(cstate),
@@ -1509,9 +1559,19 @@ SharedCacheBlockInfo* CacheCntlr::insertCacheBlock(
   m_master->m_cache->insertSingleLine(address, data_buf, now, is_fill, &writebacks,
                                       this);
 
+  if (is_prefetch && m_master->m_cache->isCompressible()) {
+    // A writeback of the inserted line itself means it bypassed this level
+    // rather than displacing anything
+    if (!writebacks.empty() && std::get<0>(writebacks.front()) != address) {
+      ++stats.prefetch_superblock_evictions;
+    } else if (m_master->m_cache->getSuperblockOccupancy(address) > 1) {
+      ++stats.prefetch_free_slot_fills;
+    }
+  }
+
   SharedCacheBlockInfo* cache_block_info = setCacheState(address, cstate);
 
-  if (Sim()->getInstrumentationMode() == InstMode::CACHE_ONLY) {
+  if (InstMode::isWarmup(Sim()->getInstrumentationMode())) {
     cache_block_info->setOption(CacheBlockInfo::WARMUP);
   }
 
@@ -1710,12 +1770,11 @@ void CacheCntlr::writeCacheBlock(IntPtr address, UInt32 offset, Byte* data_buf,
 
   // TODO: should we update access counter?
 
-  if (m_master->m_evicting_buf && (address == m_master->m_evicting_address)) {
+  if (Byte* evicting_buf = getEvictingBuf(address)) {
     LOG_PRINT("writing to evict buffer %lx", address);
     assert(offset == 0);
     assert(data_length == getCacheBlockSize());
-    if (data_buf)
-      memcpy(m_master->m_evicting_buf + offset, data_buf, data_length);
+    if (data_buf) memcpy(evicting_buf + offset, data_buf, data_length);
   } else {
     WritebackLines writebacks;
     if (m_master->m_cache->isCompressible()) {
@@ -1766,7 +1825,6 @@ void CacheCntlr::handleWritebacks(const CacheBlockInfo* ins_block_info,
     for (const auto& wb : *writebacks) {
       IntPtr evict_addr                      = std::get<0>(wb);
       const CacheBlockInfo* evict_block_info = std::get<1>(wb).get();
-      Byte* evict_block_data                 = std::get<2>(wb).get();
       CacheState::cstate_t evict_cstate      = evict_block_info->getCState();
 
       LOG_PRINT("CacheCntlr (%s core_id: %d) is evicting data @%lx (state: %c)",
@@ -1795,65 +1853,72 @@ void CacheCntlr::handleWritebacks(const CacheBlockInfo* ins_block_info,
         // Line was prefetched, but is evicted without ever being used
         if (evict_block_info->hasOption(CacheBlockInfo::PREFETCH)) {
           ++stats.evict_prefetch;
+          if (m_master->m_prefetcher)
+            m_master->m_prefetcher->notifyPrefetchEvicted();
         }
 
         if (evict_block_info->hasOption(CacheBlockInfo::WARMUP)) {
           ++stats.evict_warmup;
         }
       }  // END locked region
+    }
 
+    /*
+     * Propagate the evictions to the previous levels.  All lines of an
+     * evicted superblock are back-invalidated in a single snoop pass, the
+     * previous levels will write modified data back to our evicting buffers
+     * when needed
+     */
+    if (!m_master->m_prev_cache_cntlrs.empty()) {
       LOG_PRINT(
-          "CacheCntlr (%s core_id: %d) eviction @%lx now propagating to "
+          "CacheCntlr (%s core_id: %d) %u evictions now propagating to "
           "previous levels",
-          MemComponentString(m_mem_component), m_core_id, evict_addr);
-
-      /*
-       * Propagate the eviction to the previous levels.
-       * They will write modified data back to our evicting buffer when needed
-       */
-      if (!m_master->m_prev_cache_cntlrs.empty()) {
-        // BEGIN locked region
-        ScopedLock sl(getLock());
+          MemComponentString(m_mem_component), m_core_id, writebacks->size());
 
-        // Set the evicting buffer for other threads
-        m_master->m_evicting_address = evict_addr;
-        m_master->m_evicting_buf     = evict_block_data;
+      // BEGIN locked region
+      ScopedLock sl(getLock());
 
-        // Determine the maximum latency for all the previous cache controllers
-        SubsecondTime latency = SubsecondTime::Zero();
-        for (auto it = m_master->m_prev_cache_cntlrs.begin();
-             it != m_master->m_prev_cache_cntlrs.end(); it++) {
+      // Set the evicting buffers for other threads
+      for (const auto& wb : *writebacks) {
+        m_master->m_evicting.emplace_back(std::get<0>(wb),
+                                          std::get<2>(wb).get());
+      }
 
+      // Determine the maximum latency for all the previous cache controllers
+      SubsecondTime latency = SubsecondTime::Zero();
+      for (auto it = m_master->m_prev_cache_cntlrs.begin();
+           it != m_master->m_prev_cache_cntlrs.end(); it++) {
+        for (const auto& wb : *writebacks) {
           SubsecondTime new_latency;
           bool dummy;
           std::tie(new_latency, dummy) = (*it)->updateCacheBlock(
-              evict_addr, CacheState::INVALID, Transition::BACK_INVAL, nullptr,
-              thread_num);
+              std::get<0>(wb), CacheState::INVALID, Transition::BACK_INVAL,
+              nullptr, thread_num);
 
           latency = getMax<SubsecondTime>(latency, new_latency);
         }
+      }
 
-        getMemoryManager()->incrElapsedTime(latency, thread_num);
-        atomic_add_subsecondtime(stats.snoop_latency, latency);
+      getMemoryManager()->incrElapsedTime(latency, thread_num);
+      atomic_add_subsecondtime(stats.snoop_latency, latency);
 
-        // Reset the evicting buffer for other threads
-        m_master->m_evicting_address = 0;
-        m_master->m_evicting_buf     = nullptr;
-        // END locked region
-      }
+      // Reset the evicting buffers for other threads
+      m_master->m_evicting.clear();
+      // END locked region
+    }
 
-      // Now properly get rid of the evicted line
+    // Now properly get rid of the evicted lines
 
-      LOG_PRINT(
-          "CacheCntlr (%s core_id: %d) eviction @%lx now properly getting rid "
-          "of data",
-          MemComponentString(m_mem_component), m_core_id, evict_addr);
+    if (m_perfect) {
+      // Nothing to do in this case
+    } else if (!m_coherent) {
+      assert(false);  // Not implemented
+    } else if (m_next_cache_cntlr) {
+      for (const auto& wb : *writebacks) {
+        IntPtr evict_addr = std::get<0>(wb);
+        Byte* evict_block_data = std::get<2>(wb).get();
+        CacheState::cstate_t evict_cstate = std::get<1>(wb)->getCState();
 
-      if (m_perfect) {
-        // Nothing to do in this case
-      } else if (!m_coherent) {
-        assert(false);  // Not implemented
-      } else if (m_next_cache_cntlr) {
         if (m_cache_writethrough) {
           assert(false);  // Not implemented
         } else {
@@ -1863,13 +1928,19 @@ void CacheCntlr::handleWritebacks(const CacheBlockInfo* ins_block_info,
            */
           if (evict_cstate == CacheState::MODIFIED)
             m_next_cache_cntlr->writeCacheBlock(evict_addr, 0, evict_block_data,
-                                                getCacheBlockSize(), 
+                                                getCacheBlockSize(),
                                                 thread_num);
         }
 
         m_next_cache_cntlr->notifyPrevLevelEvict(m_core_id_master,
                                                  m_mem_component, evict_addr);
-      } else if (m_master->m_dram_cntlr) {
+      }
+    } else if (m_master->m_dram_cntlr) {
+      for (const auto& wb : *writebacks) {
+        IntPtr evict_addr = std::get<0>(wb);
+        Byte* evict_block_data = std::get<2>(wb).get();
+        CacheState::cstate_t evict_cstate = std::get<1>(wb)->getCState();
+
         if (evict_cstate == CacheState::MODIFIED) {
           SubsecondTime t_now =
               getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
@@ -1900,53 +1971,159 @@ void CacheCntlr::handleWritebacks(const CacheBlockInfo* ins_block_info,
             // END locked region
           }
         }
+      }
+    } else {
+      // Send dirty blocks to directory instead of another cache or DRAM
+      // controller
+      sendEvictionsToDirectory(writebacks, thread_num);
+    }
+
+    // Check that the evictions were processed correctly
+    for (const auto& wb : *writebacks) {
+      CacheState::cstate_t final_cstate = getCacheState(std::get<0>(wb));
+      LOG_ASSERT_ERROR(
+          final_cstate == CacheState::INVALID,
+          "Evicted address did not become invalid, now in state %c",
+          CStateString(final_cstate));
+    }
+    LOG_PRINT("CacheCntlr (%s core_id: %d) completed %u total evictions",
+              MemComponentString(m_mem_component), m_core_id,
+              writebacks->size());
+  }
+}
+
+void CacheCntlr::sendEvictionsToDirectory(WritebackLines* writebacks,
+                                          ShmemPerfModel::Thread_t thread_num) {
+  UInt32 block_size = getCacheBlockSize();
+  std::vector<bool> sent(writebacks->size(), false);
+
+  for (UInt32 i = 0; i < writebacks->size(); ++i) {
+    if (sent[i]) continue;
+
+    /*
+     * Gather all evicted lines of the same superblock that can share one
+     * message: the directory addresses them relative to the first line, so
+     * they must be physically contiguous (not guaranteed with an address home
+     * lookup) and have the same home node.
+     */
+    IntPtr first_addr = std::get<0>((*writebacks)[i]);
+    UInt32 first_block_id;
+    m_master->m_cache->splitAddress(first_addr, nullptr, nullptr, nullptr,
+                                    &first_block_id);
+    IntPtr base_addr    = first_addr - first_block_id * block_size;
+    core_id_t home_node_id = getHome(first_addr);
+
+    const WritebackTuple* lines[SUPERBLOCK_SIZE] = {};
+    UInt32 num_lines = 0;
+    for (UInt32 j = i; j < writebacks->size(); ++j) {
+      if (sent[j]) continue;
+
+      IntPtr evict_addr = std::get<0>((*writebacks)[j]);
+      UInt32 block_id;
+      m_master->m_cache->splitAddress(evict_addr, nullptr, nullptr, nullptr,
+                                      &block_id);
+      if (evict_addr == base_addr + block_id * block_size &&
+          lines[block_id] == nullptr && getHome(evict_addr) == home_node_id) {
+        lines[block_id] = &(*writebacks)[j];
+        sent[j]         = true;
+        ++num_lines;
+      }
+    }
+
+    UInt32 first = 0;
+    while (lines[first] == nullptr) ++first;
+
+    if (num_lines == 1) {
+      const WritebackTuple& wb          = *lines[first];
+      IntPtr evict_addr                 = std::get<0>(wb);
+      Byte* evict_block_data            = std::get<2>(wb).get();
+      CacheState::cstate_t evict_cstate = std::get<1>(wb)->getCState();
+
+      if (evict_cstate == CacheState::MODIFIED) {
+        // Block was dirty, so send the data as well as the FLUSH operation
+        LOG_PRINT("CacheCntlr::insertCacheBlock eviction FLUSH @%lx",
+                  evict_addr);
+
+        getMemoryManager()->sendMsg(
+            PrL1PrL2DramDirectoryMSI::ShmemMsg::FLUSH_REP,
+            MemComponent::LAST_LEVEL_CACHE, MemComponent::TAG_DIR,
+            m_core_id /* requester */, home_node_id /* receiver */,
+            evict_addr, evict_block_data, block_size, HitWhere::UNKNOWN,
+            nullptr, thread_num);
       } else {
-        // Send dirty block to directory instead of another cache or DRAM
-        // controller
-        UInt32 home_node_id = getHome(evict_addr);
+        // Block was clean, so just need to INV
+        LOG_PRINT("CacheCntlr::insertCacheBlock eviction INV @%lx",
+                  evict_addr);
+
+        LOG_ASSERT_ERROR(
+            evict_cstate == CacheState::SHARED ||
+                evict_cstate == CacheState::EXCLUSIVE,
+            "Evicted block must be either S or E @%lx but we saw %c",
+            evict_addr, CStateString(evict_cstate));
+
+        getMemoryManager()->sendMsg(
+            PrL1PrL2DramDirectoryMSI::ShmemMsg::INV_REP,
+            MemComponent::LAST_LEVEL_CACHE, MemComponent::TAG_DIR,
+            m_core_id /* requester */, home_node_id /* receiver */,
+            evict_addr, nullptr, 0, HitWhere::UNKNOWN, nullptr, thread_num);
+      }
+    } else {
+      // One message for the whole superblock, dirty lines are packed in order
+      Byte data_buf[SUPERBLOCK_SIZE * block_size];
+      UInt32 data_length = 0;
+      UInt8 block_mask = 0, dirty_mask = 0;
+
+      for (UInt32 b = first; b < SUPERBLOCK_SIZE; ++b) {
+        if (lines[b] == nullptr) continue;
+
+        IntPtr evict_addr                 = std::get<0>(*lines[b]);
+        Byte* evict_block_data            = std::get<2>(*lines[b]).get();
+        CacheState::cstate_t evict_cstate = std::get<1>(*lines[b])->getCState();
+
+        block_mask |= 1 << (b - first);
         if (evict_cstate == CacheState::MODIFIED) {
-          // Block was dirty, so send the data as well as the FLUSH operation
-          LOG_PRINT("CacheCntlr::insertCacheBlock eviction FLUSH @%lx",
-                    evict_addr);
-
-          getMemoryManager()->sendMsg(
-              PrL1PrL2DramDirectoryMSI::ShmemMsg::FLUSH_REP,
-              MemComponent::LAST_LEVEL_CACHE, MemComponent::TAG_DIR,
-              m_core_id /* requester */, home_node_id /* receiver */,
-              evict_addr, evict_block_data, getCacheBlockSize(),
-              HitWhere::UNKNOWN, nullptr, thread_num);
+          dirty_mask |= 1 << (b - first);
+          if (evict_block_data)
+            memcpy(data_buf + data_length, evict_block_data, block_size);
+          else
+            memset(data_buf + data_length, 0, block_size);
+          data_length += block_size;
         } else {
-          // Block was clean, so just need to INV
-          LOG_PRINT("CacheCntlr::insertCacheBlock eviction INV @%lx",
-                    evict_addr);
-
           LOG_ASSERT_ERROR(
               evict_cstate == CacheState::SHARED ||
                   evict_cstate == CacheState::EXCLUSIVE,
               "Evicted block must be either S or E @%lx but we saw %c",
               evict_addr, CStateString(evict_cstate));
-
-          getMemoryManager()->sendMsg(
-              PrL1PrL2DramDirectoryMSI::ShmemMsg::INV_REP,
-              MemComponent::LAST_LEVEL_CACHE, MemComponent::TAG_DIR,
-              m_core_id /* requester */, home_node_id /* receiver */,
-              evict_addr, nullptr, 0, HitWhere::UNKNOWN, nullptr, thread_num);
         }
       }
 
-      // Check that the eviction was processed correctly
-      CacheState::cstate_t final_cstate = getCacheState(evict_addr);
-      LOG_ASSERT_ERROR(
-          final_cstate == CacheState::INVALID,
-          "Evicted address did not become invalid, now in state %c",
-          CStateString(final_cstate));
+      IntPtr evict_addr = std::get<0>(*lines[first]);
+      LOG_PRINT(
+          "CacheCntlr::insertCacheBlock superblock eviction @%lx mask %x "
+          "dirty %x",
+          evict_addr, block_mask, dirty_mask);
+
+      PrL1PrL2DramDirectoryMSI::ShmemMsg shmem_msg(
+          PrL1PrL2DramDirectoryMSI::ShmemMsg::EVICT_SUPERBLOCK_REP,
+          MemComponent::LAST_LEVEL_CACHE, MemComponent::TAG_DIR,
+          m_core_id /* requester */, evict_addr,
+          data_length ? data_buf : nullptr, data_length, nullptr);
+      shmem_msg.setBlockMask(block_mask, dirty_mask);
+      getMemoryManager()->sendMsg(shmem_msg, home_node_id, thread_num);
+
+      ++stats.superblock_evict_msgs;
     }
-    LOG_PRINT("CacheCntlr (%s core_id: %d) completed %u total evictions",
-              MemComponentString(m_mem_component), m_core_id,
-              writebacks->size());
   }
 }
 
+Byte* CacheCntlr::getEvictingBuf(IntPtr address) const {
+  for (const auto& evicting : m_master->m_evicting) {
+    if (evicting.first == address) return evicting.second;
+  }
+
+  return nullptr;
+}
+
 bool CacheCntlr::isInLowerLevelCache(CacheBlockInfo* block_info) {
   IntPtr address = m_master->m_cache->tagToAddress(block_info->getTag());
   for (CacheCntlrList::iterator it = m_master->m_prev_cache_cntlrs.begin();
@@ -2112,7 +2289,8 @@ void CacheCntlr::processExRepFromDramDirectory(
 
   // TODO: check presence of data, otherwise set data_buf to nullptr
   insertCacheBlock(address, CacheState::EXCLUSIVE, data_buf, requester,
-                   ShmemPerfModel::_SIM_THREAD, false);
+                   ShmemPerfModel::_SIM_THREAD, false,
+                   isPrefetchWaiter(address));
   MYLOG("processExRepFromDramDirectory l%d end", m_mem_component);
 }
 
@@ -2131,7 +2309,8 @@ void CacheCntlr::processShRepFromDramDirectory(
   // Insert Cache Block in L2 Cache
   // TODO: check presence of data, otherwise set data_buf to nullptr
   insertCacheBlock(address, CacheState::SHARED, data_buf, requester,
-                   ShmemPerfModel::_SIM_THREAD, false);
+                   ShmemPerfModel::_SIM_THREAD, false,
+                   isPrefetchWaiter(address));
 }
 
 void CacheCntlr::processUpgradeRepFromDramDirectory(
@@ -2370,6 +2549,14 @@ void CacheCntlr::cleanupMshr() {
   }
 }
 
+bool CacheCntlr::isPrefetchWaiter(IntPtr address) {
+  // Directory replies are inserted before the waiters are woken up, the
+  // oldest waiter is the request this reply answers
+  ScopedLock sl(getLock());
+  return !m_master->m_directory_waiters.empty(address) &&
+         m_master->m_directory_waiters.front(address)->isPrefetch;
+}
+
 void CacheCntlr::transition(IntPtr address, Transition::reason_t reason,
                             CacheState::cstate_t old_state,
                             CacheState::cstate_t new_state) {
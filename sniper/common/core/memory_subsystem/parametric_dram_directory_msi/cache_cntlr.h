@@ -169,8 +169,9 @@ class CacheMasterCntlr {
   ContentionModel m_l1_mshr;
   ContentionModel m_next_level_read_bandwidth;
   CacheDirectoryWaiterMap m_directory_waiters;
-  IntPtr m_evicting_address;
-  Byte* m_evicting_buf;
+  // Lines that are being evicted, with the buffers previous levels write
+  // their modified data back to
+  std::vector<std::pair<IntPtr, Byte*>> m_evicting;
 
   std::vector<SetLock> m_setlocks;
   UInt32 m_log_blocksize;
@@ -190,10 +191,10 @@ class CacheMasterCntlr {
         m_dram_outstanding_writebacks(NULL),
         m_l1_mshr(name + ".mshr", core_id, outstanding_misses),
         m_next_level_read_bandwidth(name + ".next_read", core_id),
-        m_evicting_address(0),
-        m_evicting_buf(NULL),
         m_prefetch_list(),
-        m_prefetch_next(SubsecondTime::Zero()) {}
+        m_prefetch_next(SubsecondTime::Zero()) {
+    m_evicting.reserve(SUPERBLOCK_SIZE);
+  }
   ~CacheMasterCntlr();
 
   friend class CacheCntlr;
@@ -214,6 +215,7 @@ class CacheCntlr : ::CacheCntlr {
   bool m_coherent;
   bool m_prefetch_on_prefetch_hit;
   bool m_l1_mshr;
+  bool m_superblock_prefetch;
 
   struct {
     UInt64 loads, stores;
@@ -248,6 +250,12 @@ class CacheCntlr : ::CacheCntlr {
     SubsecondTime qbs_query_latency;
     SubsecondTime mshr_latency;
     UInt64 prefetches;
+    UInt64 prefetch_free_slot_fills,  // prefetched lines merged into a
+                                      // resident superblock
+        prefetch_superblock_evictions;  // prefetched lines that evicted a
+                                        // superblock to make room
+    UInt64 superblock_evict_msgs;  // evictions of several lines sent to the
+                                   // directory as a single message
     UInt64 coherency_downgrades, coherency_upgrades, coherency_invalidates,
         coherency_writebacks;
 #ifdef ENABLE_TRANSITIONS
@@ -267,6 +275,7 @@ class CacheCntlr : ::CacheCntlr {
                       bool cache_hit, CacheState::cstate_t state,
                       Prefetch::prefetch_type_t isPrefetch);
   void cleanupMshr();
+  bool isPrefetchWaiter(IntPtr address);
   void transition(IntPtr address, Transition::reason_t reason,
                   CacheState::cstate_t old_state,
                   CacheState::cstate_t new_state);
@@ -301,9 +310,10 @@ class CacheCntlr : ::CacheCntlr {
                                    CacheBlockInfo** cache_block_info = NULL);
 
   void copyDataFromNextLevel(Core::mem_op_t mem_op_type, IntPtr address,
-                             bool modeled, SubsecondTime t_start);
-  void trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit,
-                       SubsecondTime t_issue);
+                             bool modeled, SubsecondTime t_start,
+                             bool is_prefetch = false);
+  void trainPrefetcher(IntPtr address, IntPtr eip, bool cache_hit,
+                       bool prefetch_hit, SubsecondTime t_issue);
   void Prefetch(SubsecondTime t_start);
   void doPrefetch(IntPtr prefetch_address, SubsecondTime t_start);
 
@@ -323,7 +333,8 @@ class CacheCntlr : ::CacheCntlr {
   SharedCacheBlockInfo* insertCacheBlock(IntPtr address,
                                          CacheState::cstate_t cstate,
                                          Byte* data_buf, core_id_t requester,
-                                         ShmemPerfModel::Thread_t thread_num, bool is_fill);
+                                         ShmemPerfModel::Thread_t thread_num, bool is_fill,
+                                         bool is_prefetch = false);
   std::pair<SubsecondTime, bool> updateCacheBlock(
       IntPtr address, CacheState::cstate_t cstate, Transition::reason_t reason,
       Byte* out_buf, ShmemPerfModel::Thread_t thread_num);
@@ -332,12 +343,15 @@ class CacheCntlr : ::CacheCntlr {
   void handleWritebacks(const CacheBlockInfo* ins_block_info,
                         ShmemPerfModel::Thread_t thread_num,
                         WritebackLines* writebacks);
+  void sendEvictionsToDirectory(WritebackLines* writebacks,
+                                ShmemPerfModel::Thread_t thread_num);
+  Byte* getEvictingBuf(IntPtr address) const;
 
   // Handle Request from previous level cache
   HitWhere::where_t processShmemReqFromPrevCache(
       CacheCntlr* requester, Core::mem_op_t mem_op_type, IntPtr address,
       bool modeled, bool count, Prefetch::prefetch_type_t isPrefetch,
-      SubsecondTime t_issue, bool have_write_lock);
+      SubsecondTime t_issue, bool have_write_lock, IntPtr eip);
 
   // Process Request from L1 Cache
   std::pair<HitWhere::where_t, SubsecondTime> accessDRAM(
@@ -428,7 +442,8 @@ class CacheCntlr : ::CacheCntlr {
                                          Core::mem_op_t mem_op_type,
                                          IntPtr ca_address, UInt32 offset,
                                          Byte* data_buf, UInt32 data_length,
-                                         bool modeled, bool count);
+                                         bool modeled, bool count,
+                                         IntPtr eip);
   void updateHits(Core::mem_op_t mem_op_type, UInt64 hits);
 
   // Notify next level cache of so it can update its sharing set
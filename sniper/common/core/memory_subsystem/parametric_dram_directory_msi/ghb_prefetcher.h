@@ -6,7 +6,7 @@ class GhbPrefetcher : public Prefetcher
 {
    public:
       GhbPrefetcher(String configName, core_id_t core_id);
-      std::vector<IntPtr> getNextAddress(IntPtr currentAddress, core_id_t core_id);
+      std::vector<IntPtr> getNextAddress(IntPtr currentAddress, IntPtr eip, core_id_t core_id);
 
       ~GhbPrefetcher();
 
@@ -386,7 +386,8 @@ MemoryManager::coreInitiateMemoryAccess(
       Core::mem_op_t mem_op_type,
       IntPtr address, UInt32 offset,
       Byte* data_buf, UInt32 data_length,
-      Core::MemModeled modeled)
+      Core::MemModeled modeled,
+      IntPtr eip)
 {
    LOG_ASSERT_ERROR(mem_component <= m_last_level_cache,
       "Error: invalid mem_component (%d) for coreInitiateMemoryAccess", mem_component);
@@ -401,8 +402,9 @@ MemoryManager::coreInitiateMemoryAccess(
          mem_op_type,
          address, offset,
          data_buf, data_length,
-         modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT ? false : true,
-         modeled == Core::MEM_MODELED_NONE ? false : true);
+         modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_WARMUP || modeled == Core::MEM_MODELED_COUNT ? false : true,
+         modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_WARMUP ? false : true,
+         eip);
 }
 
 void
@@ -508,13 +510,19 @@ MYLOG("send msg %u %ul%u > %ul%u", msg_type, requester, sender_mem_component, re
    PrL1PrL2DramDirectoryMSI::ShmemMsg shmem_msg(msg_type, sender_mem_component, receiver_mem_component, requester, address, data_buf, data_length, perf);
    shmem_msg.setWhere(where);
 
+   sendMsg(shmem_msg, receiver, thread_num);
+}
+
+void
+MemoryManager::sendMsg(PrL1PrL2DramDirectoryMSI::ShmemMsg& shmem_msg, core_id_t receiver, ShmemPerfModel::Thread_t thread_num)
+{
    Byte* msg_buf = shmem_msg.makeMsgBuf();
    SubsecondTime msg_time = getShmemPerfModel()->getElapsedTime(thread_num);
-   perf->updateTime(msg_time);
+   shmem_msg.getPerf()->updateTime(msg_time);
 
    if (m_enabled)
    {
-      LOG_PRINT("Sending Msg: type(%u), address(0x%x), sender_mem_component(%u), receiver_mem_component(%u), requester(%i), sender(%i), receiver(%i)", msg_type, address, sender_mem_component, receiver_mem_component, requester, getCore()->getId(), receiver);
+      LOG_PRINT("Sending Msg: type(%u), address(0x%x), sender_mem_component(%u), receiver_mem_component(%u), requester(%i), sender(%i), receiver(%i)", shmem_msg.getMsgType(), shmem_msg.getAddress(), shmem_msg.getSenderMemComponent(), shmem_msg.getReceiverMemComponent(), shmem_msg.getRequester(), getCore()->getId(), receiver);
    }
 
    NetPacket packet(msg_time, SHARED_MEM_1,
@@ -556,7 +564,7 @@ MemoryManager::accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::MemMode
 {
    bool hit = tlb->lookup(address, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
    if (hit == false
-       && !(modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT)
+       && !(modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_WARMUP || modeled == Core::MEM_MODELED_COUNT)
        && m_tlb_miss_penalty.getLatency() != SubsecondTime::Zero()
    )
    {
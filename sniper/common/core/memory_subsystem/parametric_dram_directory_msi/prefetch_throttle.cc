@@ -0,0 +1,142 @@
+#include "prefetch_throttle.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+#include "log.h"
+
+#include <algorithm>
+
+// Configurations without a throttle section (e.g. dram/cache) run unthrottled
+PrefetchThrottle::PrefetchThrottle(String configName, String prefetcherName, core_id_t core_id, UInt32 max_degree, UInt32 max_distance)
+   : m_enabled(Sim()->getCfg()->getBoolDefault("perf_model/" + configName + "/prefetcher/throttle/enabled", false))
+   , m_max_degree(std::max(max_degree, 1u))
+   , m_max_distance(std::max(max_distance, 1u))
+   , m_interval(m_enabled ? Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/throttle/interval", core_id) : 0)
+   , m_accuracy_high(m_enabled ? Sim()->getCfg()->getFloatArray("perf_model/" + configName + "/prefetcher/throttle/accuracy_high", core_id) : 0)
+   , m_accuracy_low(m_enabled ? Sim()->getCfg()->getFloatArray("perf_model/" + configName + "/prefetcher/throttle/accuracy_low", core_id) : 0)
+   , m_lateness_threshold(m_enabled ? Sim()->getCfg()->getFloatArray("perf_model/" + configName + "/prefetcher/throttle/lateness", core_id) : 0)
+   , m_pollution_threshold(m_enabled ? Sim()->getCfg()->getFloatArray("perf_model/" + configName + "/prefetcher/throttle/pollution", core_id) : 0)
+   , m_interval_issued(0)
+   , m_interval_useful(0)
+   , m_interval_late(0)
+   , m_interval_evicted(0)
+   , m_issued(0)
+   , m_useful(0)
+   , m_late(0)
+   , m_evicted(0)
+   , m_num_late(0)
+   , m_num_increments(0)
+   , m_num_decrements(0)
+{
+   if (m_enabled)
+   {
+      LOG_ASSERT_ERROR(m_interval > 0, "prefetcher/throttle/interval must be larger than zero");
+      LOG_ASSERT_ERROR(m_accuracy_low <= m_accuracy_high, "prefetcher/throttle/accuracy_low must not exceed accuracy_high");
+      // Start out moderately aggressive, as in the original proposal
+      setLevel(NUM_LEVELS / 2);
+   }
+   else
+   {
+      setLevel(NUM_LEVELS - 1);
+   }
+
+   // Stats object names cannot contain path separators (dram/cache)
+   String name = "prefetcher-" + configName;
+   std::replace(name.begin(), name.end(), '/', '-');
+   registerStatsMetric(name, core_id, prefetcherName + "-late", &m_num_late);
+   registerStatsMetric(name, core_id, prefetcherName + "-throttle-increments", &m_num_increments);
+   registerStatsMetric(name, core_id, prefetcherName + "-throttle-decrements", &m_num_decrements);
+}
+
+void
+PrefetchThrottle::setLevel(UInt32 level)
+{
+   // Level NUM_LEVELS-1 is the configured maximum, every level below halves both degree and distance
+   m_level = level;
+   UInt32 shift = NUM_LEVELS - 1 - level;
+   m_degree = std::max(m_max_degree >> shift, 1u);
+   m_distance = std::max(m_max_distance >> shift, 1u);
+}
+
+void
+PrefetchThrottle::notifyIssued()
+{
+   if (!m_enabled)
+      return;
+
+   if (++m_interval_issued >= m_interval)
+      adjust();
+}
+
+void
+PrefetchThrottle::notifyUseful(bool late)
+{
+   if (late)
+      ++m_num_late;
+
+   if (!m_enabled)
+      return;
+
+   ++m_interval_useful;
+   if (late)
+      ++m_interval_late;
+}
+
+void
+PrefetchThrottle::notifyEvicted()
+{
+   if (!m_enabled)
+      return;
+
+   ++m_interval_evicted;
+}
+
+void
+PrefetchThrottle::adjust()
+{
+   // Give the current interval and all previous ones (decayed) equal weight
+   m_issued = (m_issued + m_interval_issued) / 2.;
+   m_useful = (m_useful + m_interval_useful) / 2.;
+   m_late = (m_late + m_interval_late) / 2.;
+   m_evicted = (m_evicted + m_interval_evicted) / 2.;
+
+   m_interval_issued = m_interval_useful = m_interval_late = m_interval_evicted = 0;
+
+   double accuracy = m_issued > 0 ? m_useful / m_issued : 0;
+   bool late = m_useful > 0 && m_late / m_useful > m_lateness_threshold;
+   // Unused prefetches that were evicted are our proxy for cache pollution.
+   // In a compressed cache these also took superblock space away from demand lines.
+   bool polluting = m_issued > 0 && m_evicted / m_issued > m_pollution_threshold;
+
+   int delta = 0;
+   if (accuracy >= m_accuracy_high)
+   {
+      if (late)
+         delta = 1;
+      else if (polluting)
+         delta = -1;
+   }
+   else if (accuracy >= m_accuracy_low)
+   {
+      if (late && !polluting)
+         delta = 1;
+      else if (polluting)
+         delta = -1;
+   }
+   else
+   {
+      if (late || polluting)
+         delta = -1;
+   }
+
+   if (delta > 0 && m_level < NUM_LEVELS - 1)
+   {
+      setLevel(m_level + 1);
+      ++m_num_increments;
+   }
+   else if (delta < 0 && m_level > 0)
+   {
+      setLevel(m_level - 1);
+      ++m_num_decrements;
+   }
+}
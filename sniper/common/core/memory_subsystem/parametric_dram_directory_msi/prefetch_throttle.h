@@ -0,0 +1,53 @@
+#pragma once
+
+#include "fixed_types.h"
+
+// Feedback-directed prefetch throttling (Srinath et al., HPCA 2007).
+//
+// The owning prefetcher reports every issued prefetch, every prefetched line
+// that is later used by a demand access (and whether it arrived late), and
+// every prefetched line that is evicted unused.  After each interval of
+// <interval> issued prefetches, accuracy, lateness and pollution are computed
+// and the aggressiveness level is moved up or down.  Each level maps to a
+// (degree, distance) pair that the prefetcher queries when generating
+// addresses.  When throttling is disabled, the configured degree and distance
+// are returned unchanged.
+class PrefetchThrottle
+{
+   public:
+      PrefetchThrottle(String configName, String prefetcherName, core_id_t core_id, UInt32 max_degree, UInt32 max_distance);
+
+      UInt32 getDegree() const { return m_degree; }
+      UInt32 getDistance() const { return m_distance; }
+
+      void notifyIssued();
+      void notifyUseful(bool late);
+      void notifyEvicted();
+
+   private:
+      static const UInt32 NUM_LEVELS = 5;
+
+      const bool m_enabled;
+      const UInt32 m_max_degree;
+      const UInt32 m_max_distance;
+      const UInt32 m_interval;
+      const double m_accuracy_high;
+      const double m_accuracy_low;
+      const double m_lateness_threshold;
+      const double m_pollution_threshold;
+
+      UInt32 m_level;
+      UInt32 m_degree;
+      UInt32 m_distance;
+
+      // Counters for the current interval
+      UInt32 m_interval_issued, m_interval_useful, m_interval_late, m_interval_evicted;
+      // Exponentially decayed history over previous intervals
+      double m_issued, m_useful, m_late, m_evicted;
+
+      UInt64 m_num_late;
+      UInt64 m_num_increments, m_num_decrements;
+
+      void setLevel(UInt32 level);
+      void adjust();
+};
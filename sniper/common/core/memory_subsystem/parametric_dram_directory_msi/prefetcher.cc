@@ -4,6 +4,9 @@
 #include "log.h"
 #include "simple_prefetcher.h"
 #include "ghb_prefetcher.h"
+#include "stride_prefetcher.h"
+#include "stream_prefetcher.h"
+#include "best_offset_prefetcher.h"
 
 Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores)
 {
@@ -13,6 +16,12 @@ Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id
       return new SimplePrefetcher(configName, core_id, shared_cores);
    else if (type == "ghb")
       return new GhbPrefetcher(configName, core_id);
+   else if (type == "stride")
+      return new StridePrefetcher(configName, core_id);
+   else if (type == "stream")
+      return new StreamPrefetcher(configName, core_id);
+   else if (type == "bop")
+      return new BestOffsetPrefetcher(configName, core_id);
 
    LOG_PRINT_ERROR("Invalid prefetcher type %s", type.c_str());
 }
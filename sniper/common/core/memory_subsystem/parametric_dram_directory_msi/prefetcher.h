@@ -8,5 +8,13 @@ class Prefetcher
    public:
       static Prefetcher* createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores);
 
-      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id) = 0;
+      virtual ~Prefetcher() {}
+
+      // eip is the program counter of the instruction that caused the access, or 0 when unknown
+      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id) = 0;
+
+      // Feedback from the cache about prefetches generated by this prefetcher
+      virtual void notifyPrefetchIssued() {}
+      virtual void notifyPrefetchHit(bool late) {}
+      virtual void notifyPrefetchEvicted() {}
 };
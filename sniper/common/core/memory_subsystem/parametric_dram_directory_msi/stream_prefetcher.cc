@@ -0,0 +1,123 @@
+#include "stream_prefetcher.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+static const IntPtr PAGE_SIZE = 4096;
+
+StreamPrefetcher::StreamPrefetcher(String configName, core_id_t core_id)
+   : m_num_streams(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stream/streams", core_id))
+   , m_train_window(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stream/train_window", core_id))
+   , m_stop_at_page(Sim()->getCfg()->getBoolArray("perf_model/" + configName + "/prefetcher/stream/stop_at_page_boundary", core_id))
+   , m_cache_block_size(Sim()->getCfg()->getInt("perf_model/l1_dcache/cache_block_size"))
+   , m_streams(m_num_streams)
+   , m_lru_counter(0)
+   , m_throttle(configName, "stream", core_id,
+        Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stream/degree", core_id),
+        Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stream/distance", core_id))
+{
+   LOG_ASSERT_ERROR(m_num_streams > 0, "prefetcher/stream/streams must be larger than zero");
+}
+
+bool
+StreamPrefetcher::samePage(IntPtr line_a, IntPtr line_b) const
+{
+   return (line_a * m_cache_block_size) / PAGE_SIZE == (line_b * m_cache_block_size) / PAGE_SIZE;
+}
+
+StreamPrefetcher::Stream&
+StreamPrefetcher::allocateStream()
+{
+   Stream *victim = &m_streams[0];
+   for(std::vector<Stream>::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
+   {
+      if (it->state == INVALID)
+         return *it;
+      if (it->lru < victim->lru)
+         victim = &*it;
+   }
+   return *victim;
+}
+
+std::vector<IntPtr>
+StreamPrefetcher::getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id)
+{
+   std::vector<IntPtr> addresses;
+   IntPtr line = current_address / m_cache_block_size;
+   UInt32 degree = m_throttle.getDegree();
+   UInt32 distance = m_throttle.getDistance();
+
+   for(std::vector<Stream>::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
+   {
+      Stream &stream = *it;
+      if (stream.state == INVALID)
+         continue;
+
+      if (stream.state == MONITOR)
+      {
+         IntPtr lo = std::min(stream.start, stream.end), hi = std::max(stream.start, stream.end);
+         if (line < lo || line > hi)
+            continue;
+
+         stream.lru = ++m_lru_counter;
+         for(UInt32 i = 0; i < degree; ++i)
+         {
+            IntPtr next = stream.end + stream.direction;
+            if (m_stop_at_page && !samePage(next, line))
+               break;
+            stream.end = next;
+            addresses.push_back(next * m_cache_block_size);
+         }
+         // Drag the start of the region along so it never exceeds <distance> lines
+         if ((stream.direction > 0 ? stream.end - stream.start : stream.start - stream.end) > distance)
+            stream.start = stream.end - stream.direction * SInt64(distance);
+         return addresses;
+      }
+
+      // ALLOCATED or TRAINING: the access must fall within the train window around the stream head
+      SInt64 delta = SInt64(line - stream.end);
+      if (delta == 0 || std::abs(delta) > SInt64(m_train_window))
+         continue;
+
+      SInt32 direction = delta > 0 ? 1 : -1;
+      stream.lru = ++m_lru_counter;
+      if (stream.state == ALLOCATED || direction != stream.direction)
+      {
+         stream.state = TRAINING;
+         stream.direction = direction;
+         stream.trained = 1;
+      }
+      else
+      {
+         ++stream.trained;
+      }
+      stream.end = line;
+
+      if (stream.trained >= 2)
+      {
+         // Direction confirmed twice in a row, start prefetching ahead of the access
+         stream.state = MONITOR;
+         for(UInt32 i = 0; i < degree; ++i)
+         {
+            IntPtr next = stream.end + stream.direction;
+            if (m_stop_at_page && !samePage(next, line))
+               break;
+            stream.end = next;
+            addresses.push_back(next * m_cache_block_size);
+         }
+      }
+      return addresses;
+   }
+
+   Stream &stream = allocateStream();
+   stream.state = ALLOCATED;
+   stream.start = stream.end = line;
+   stream.direction = 0;
+   stream.trained = 0;
+   stream.lru = ++m_lru_counter;
+
+   return addresses;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "prefetcher.h"
+#include "prefetch_throttle.h"
+
+// Stream prefetcher modeled after the IBM POWER4/5 and Intel L2 streamers.
+// A miss allocates a stream; once two further accesses move away from it in
+// the same direction, each within <train_window> lines of the previous one,
+// the stream starts monitoring a region [start, end].  Every access inside
+// that region prefetches <degree> lines beyond end, and the region is kept
+// at most <distance> lines long.
+class StreamPrefetcher : public Prefetcher
+{
+   public:
+      StreamPrefetcher(String configName, core_id_t core_id);
+      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id);
+
+      virtual void notifyPrefetchIssued() { m_throttle.notifyIssued(); }
+      virtual void notifyPrefetchHit(bool late) { m_throttle.notifyUseful(late); }
+      virtual void notifyPrefetchEvicted() { m_throttle.notifyEvicted(); }
+
+   private:
+      enum StreamState
+      {
+         INVALID,
+         ALLOCATED,
+         TRAINING,
+         MONITOR,
+      };
+
+      struct Stream
+      {
+         StreamState state;
+         // All addresses are in cache lines
+         IntPtr start, end;
+         SInt32 direction;
+         UInt32 trained;
+         UInt64 lru;
+         Stream() : state(INVALID), start(0), end(0), direction(0), trained(0), lru(0) {}
+      };
+
+      const UInt32 m_num_streams;
+      const UInt32 m_train_window;
+      const bool m_stop_at_page;
+      const UInt32 m_cache_block_size;
+      std::vector<Stream> m_streams;
+      UInt64 m_lru_counter;
+
+      PrefetchThrottle m_throttle;
+
+      Stream& allocateStream();
+      bool samePage(IntPtr line_a, IntPtr line_b) const;
+};
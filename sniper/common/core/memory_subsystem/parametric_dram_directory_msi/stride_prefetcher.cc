@@ -0,0 +1,78 @@
+#include "stride_prefetcher.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+static const IntPtr PAGE_SIZE = 4096;
+static const IntPtr PAGE_MASK = ~(PAGE_SIZE-1);
+
+StridePrefetcher::StridePrefetcher(String configName, core_id_t core_id)
+   : m_table_size(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stride/table_size", core_id))
+   , m_confidence_threshold(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stride/confidence_threshold", core_id))
+   , m_confidence_max(2 * m_confidence_threshold)
+   , m_stop_at_page(Sim()->getCfg()->getBoolArray("perf_model/" + configName + "/prefetcher/stride/stop_at_page_boundary", core_id))
+   , m_table(m_table_size)
+   , m_throttle(configName, "stride", core_id,
+        Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stride/degree", core_id),
+        Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/stride/distance", core_id))
+{
+   LOG_ASSERT_ERROR(m_table_size > 0, "prefetcher/stride/table_size must be larger than zero");
+}
+
+std::vector<IntPtr>
+StridePrefetcher::getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id)
+{
+   std::vector<IntPtr> addresses;
+
+   // Direct-mapped, tagged with the full PC
+   TableEntry &entry = m_table[eip % m_table_size];
+
+   if (entry.eip != eip)
+   {
+      entry.eip = eip;
+      entry.last_address = current_address;
+      entry.stride = 0;
+      entry.confidence = 0;
+      return addresses;
+   }
+
+   SInt64 stride = current_address - entry.last_address;
+   entry.last_address = current_address;
+
+   if (stride == 0)
+      return addresses;
+
+   if (stride == entry.stride)
+   {
+      if (entry.confidence < m_confidence_max)
+         ++entry.confidence;
+   }
+   else if (entry.confidence > 0)
+   {
+      // Keep the old stride until confidence drops to zero to ride over irregular accesses
+      --entry.confidence;
+      return addresses;
+   }
+   else
+   {
+      entry.stride = stride;
+      return addresses;
+   }
+
+   if (entry.confidence < m_confidence_threshold)
+      return addresses;
+
+   UInt32 degree = m_throttle.getDegree();
+   UInt32 distance = m_throttle.getDistance();
+   // Prefetch the last <degree> strides of a window <distance> strides ahead
+   UInt32 start = distance > degree ? distance - degree : 0;
+   for(UInt32 i = 1; i <= degree; ++i)
+   {
+      IntPtr prefetch_address = current_address + (start + i) * entry.stride;
+      if (m_stop_at_page && ((prefetch_address & PAGE_MASK) != (current_address & PAGE_MASK)))
+         break;
+      addresses.push_back(prefetch_address);
+   }
+
+   return addresses;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "prefetcher.h"
+#include "prefetch_throttle.h"
+
+// PC-indexed stride prefetcher (reference prediction table, Chen and Baer).
+// Each load/store PC tracks its last address and stride; once the same stride
+// has been observed <confidence_threshold> times in a row, <degree> lines
+// ahead of the access are prefetched, <distance> strides into the future.
+class StridePrefetcher : public Prefetcher
+{
+   public:
+      StridePrefetcher(String configName, core_id_t core_id);
+      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, IntPtr eip, core_id_t core_id);
+
+      virtual void notifyPrefetchIssued() { m_throttle.notifyIssued(); }
+      virtual void notifyPrefetchHit(bool late) { m_throttle.notifyUseful(late); }
+      virtual void notifyPrefetchEvicted() { m_throttle.notifyEvicted(); }
+
+   private:
+      struct TableEntry
+      {
+         IntPtr eip;
+         IntPtr last_address;
+         SInt64 stride;
+         UInt32 confidence;
+         TableEntry() : eip(INVALID_ADDRESS), last_address(0), stride(0), confidence(0) {}
+      };
+
+      const UInt32 m_table_size;
+      const UInt32 m_confidence_threshold;
+      const UInt32 m_confidence_max;
+      const bool m_stop_at_page;
+      std::vector<TableEntry> m_table;
+
+      PrefetchThrottle m_throttle;
+};
@@ -170,6 +170,12 @@ void DramDirectoryCntlr::handleMsgFromL2Cache(core_id_t sender,
       processWbRepFromL2Cache(sender, shmem_msg);
       break;
 
+    case ShmemMsg::EVICT_SUPERBLOCK_REP:
+      MYLOG("EVICT SUPERBLOCK REP<%u @ %lx mask %x", sender, address,
+            shmem_msg->getBlockMask());
+      processEvictSuperblockRepFromL2Cache(sender, shmem_msg);
+      break;
+
     default:
       LOG_PRINT_ERROR("Unrecognized Shmem Msg Type: %u", shmem_msg_type);
       break;
@@ -1101,6 +1107,48 @@ void DramDirectoryCntlr::processWbRepFromL2Cache(core_id_t sender,
   MYLOG("End @ %lx", address);
 }
 
+void DramDirectoryCntlr::processEvictSuperblockRepFromL2Cache(
+    core_id_t sender, ShmemMsg* shmem_msg) {
+  IntPtr address   = shmem_msg->getAddress();
+  UInt8 block_mask = shmem_msg->getBlockMask();
+  UInt8 dirty_mask = shmem_msg->getDirtyMask();
+  Byte* data_buf   = shmem_msg->getDataBuf();
+
+  MYLOG("Start @ %lx", address);
+
+  LOG_ASSERT_ERROR(block_mask & 1,
+                   "Superblock eviction @%lx does not include its first line",
+                   address);
+
+  for (UInt32 i = 0; block_mask >> i; ++i) {
+    if (!((block_mask >> i) & 1)) continue;
+
+    IntPtr block_address = address + i * getCacheBlockSize();
+    bool dirty           = (dirty_mask >> i) & 1;
+
+    // The lookup for the first line was already modeled when the message
+    // arrived, the remaining lines have their own directory entries
+    if (i > 0) m_dram_directory_cache->getDirectoryEntry(block_address, true);
+
+    // Handle each line exactly like its own INV_REP or FLUSH_REP
+    ShmemMsg block_msg(dirty ? ShmemMsg::FLUSH_REP : ShmemMsg::INV_REP,
+                       shmem_msg->getSenderMemComponent(),
+                       shmem_msg->getReceiverMemComponent(),
+                       shmem_msg->getRequester(), block_address,
+                       dirty ? data_buf : NULL, dirty ? getCacheBlockSize() : 0,
+                       shmem_msg->getPerf());
+
+    if (dirty) {
+      processFlushRepFromL2Cache(sender, &block_msg);
+      data_buf += getCacheBlockSize();
+    } else {
+      processInvRepFromL2Cache(sender, &block_msg);
+    }
+  }
+
+  MYLOG("End @ %lx", address);
+}
+
 void DramDirectoryCntlr::sendDataToDram(IntPtr address, core_id_t requester,
                                         Byte* data_buf, SubsecondTime now) {
   MYLOG("Start @ %lx", address);
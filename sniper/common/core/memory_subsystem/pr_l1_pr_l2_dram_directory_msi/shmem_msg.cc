@@ -13,7 +13,9 @@ namespace PrL1PrL2DramDirectoryMSI
       m_address(INVALID_ADDRESS),
       m_data_buf(NULL),
       m_data_length(0),
-      m_perf(NULL)
+      m_perf(NULL),
+      m_block_mask(0),
+      m_dirty_mask(0)
    {}
 
    ShmemMsg::ShmemMsg(msg_t msg_type,
@@ -32,7 +34,9 @@ namespace PrL1PrL2DramDirectoryMSI
       m_address(address),
       m_data_buf(data_buf),
       m_data_length(data_length),
-      m_perf(perf)
+      m_perf(perf),
+      m_block_mask(0),
+      m_dirty_mask(0)
    {}
 
    ShmemMsg::ShmemMsg(ShmemMsg* shmem_msg) :
@@ -43,7 +47,9 @@ namespace PrL1PrL2DramDirectoryMSI
       m_address(shmem_msg->getAddress()),
       m_data_buf(shmem_msg->getDataBuf()),
       m_data_length(shmem_msg->getDataLength()),
-      m_perf(shmem_msg->getPerf())
+      m_perf(shmem_msg->getPerf()),
+      m_block_mask(shmem_msg->getBlockMask()),
+      m_dirty_mask(shmem_msg->getDirtyMask())
    {}
 
    ShmemMsg::~ShmemMsg()
@@ -109,6 +115,10 @@ namespace PrL1PrL2DramDirectoryMSI
             // msg_type + address + cache_block
             return (1 + sizeof(IntPtr) + m_data_length);
 
+         case EVICT_SUPERBLOCK_REP:
+            // msg_type + address + block and dirty masks + dirty cache_blocks
+            return (1 + sizeof(IntPtr) + 2 + m_data_length);
+
          default:
             LOG_PRINT_ERROR("Unrecognized Msg Type(%u)", m_msg_type);
             return 0;
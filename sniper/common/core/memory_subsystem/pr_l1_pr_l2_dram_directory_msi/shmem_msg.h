@@ -29,6 +29,7 @@ namespace PrL1PrL2DramDirectoryMSI
             INV_REP,
             FLUSH_REP,
             WB_REP,
+            EVICT_SUPERBLOCK_REP,   // INV_REP/FLUSH_REP for several blocks of one superblock
             NULLIFY_REQ,
             // Tag directory > DRAM
             DRAM_READ_REQ,
@@ -50,6 +51,10 @@ namespace PrL1PrL2DramDirectoryMSI
          Byte* m_data_buf;
          UInt32 m_data_length;
          ShmemPerf* m_perf;
+         // EVICT_SUPERBLOCK_REP only: bit i covers the line at m_address + i * block size,
+         // data_buf holds the dirty lines back to back in mask order
+         UInt8 m_block_mask;
+         UInt8 m_dirty_mask;
 
       public:
          ShmemMsg();
@@ -80,9 +85,12 @@ namespace PrL1PrL2DramDirectoryMSI
          Byte* getDataBuf() { return m_data_buf; }
          UInt32 getDataLength() { return m_data_length; }
          HitWhere::where_t getWhere() { return m_where; }
+         UInt8 getBlockMask() { return m_block_mask; }
+         UInt8 getDirtyMask() { return m_dirty_mask; }
 
          void setDataBuf(Byte* data_buf) { m_data_buf = data_buf; }
          void setWhere(HitWhere::where_t where) { m_where = where; }
+         void setBlockMask(UInt8 block_mask, UInt8 dirty_mask) { m_block_mask = block_mask; m_dirty_mask = dirty_mask; }
 
          ShmemPerf* getPerf() { return m_perf; }
 
@@ -2,27 +2,119 @@
 #define __ALLOCATOR_H
 
 #include "fixed_types.h"
-#include "FSBAllocator.hh"
+#include "lock.h"
+#include "log.h"
+#include "stats.h"
 
+#include <atomic>
+#include <vector>
 #include <typeinfo>
 #include <cxxabi.h>
+#include <cstdlib>
+#include <climits>
 
 // Pool allocator
 
 class Allocator
 {
-   private:
+   protected:
       struct DataElement
       {
-          Allocator *allocator;
+          union
+          {
+             Allocator *allocator;   // While allocated
+             DataElement *next;      // While on a free list
+          };
           char data[];
       };
+
+      static const unsigned MAX_THREAD_SLOTS = 64;
+      static const unsigned NO_SLOT = UINT_MAX;
+
+      // Slot in [0, MAX_THREAD_SLOTS) owned by the calling host thread, NO_SLOT when all slots are taken.
+      // When a thread exits, releaseSlot() is called on every allocator before its slot is handed out again.
+      static unsigned getThreadSlot()
+      {
+         static thread_local ThreadSlot thread_slot;
+         return thread_slot.slot;
+      }
+
+      // Called on the exiting thread itself: give back everything cached for <slot>
+      virtual void releaseSlot(unsigned slot) {}
+
+      void registerAllocator()
+      {
+         Registry &registry = getRegistry();
+         ScopedLock sl(registry.lock);
+         registry.allocators.push_back(this);
+      }
+
+      void unregisterAllocator()
+      {
+         Registry &registry = getRegistry();
+         ScopedLock sl(registry.lock);
+         for(std::vector<Allocator*>::iterator it = registry.allocators.begin(); it != registry.allocators.end(); ++it)
+            if (*it == this)
+            {
+               registry.allocators.erase(it);
+               break;
+            }
+      }
+
+   private:
+      struct Registry
+      {
+         Lock lock;
+         std::vector<Allocator*> allocators;
+         std::atomic<UInt64> slots_in_use;
+         Registry() : slots_in_use(0) {}
+      };
+
+      struct ThreadSlot
+      {
+         unsigned slot;
+         ThreadSlot() : slot(acquireSlot()) {}
+         ~ThreadSlot() { if (slot != NO_SLOT) releaseThreadSlot(slot); }
+      };
+
+      static Registry& getRegistry()
+      {
+         static Registry registry;
+         return registry;
+      }
+
+      static unsigned acquireSlot()
+      {
+         std::atomic<UInt64> &slots_in_use = getRegistry().slots_in_use;
+         UInt64 in_use = slots_in_use.load();
+         while(~in_use)
+         {
+            unsigned slot = __builtin_ctzll(~in_use);
+            if (slots_in_use.compare_exchange_weak(in_use, in_use | (UInt64(1) << slot)))
+               return slot;
+         }
+         return NO_SLOT;
+      }
+
+      static void releaseThreadSlot(unsigned slot)
+      {
+         Registry &registry = getRegistry();
+         {
+            ScopedLock sl(registry.lock);
+            for(std::vector<Allocator*>::iterator it = registry.allocators.begin(); it != registry.allocators.end(); ++it)
+               (*it)->releaseSlot(slot);
+         }
+         registry.slots_in_use.fetch_and(~(UInt64(1) << slot));
+      }
+
    public:
       virtual ~Allocator() {}
 
       virtual void *alloc(size_t bytes) = 0;
       virtual void _dealloc(void *ptr) = 0;
 
+      virtual void registerStats(String objectName, core_id_t core_id, String prefix) {}
+
       static void dealloc(void* ptr)
       {
          DataElement *elem = (DataElement*)(((char*)ptr) - sizeof(DataElement));
@@ -30,46 +122,212 @@ class Allocator
       }
 };
 
-template <typename T, unsigned MaxItems = 0> class TypedAllocator : public Allocator
+// Slab allocator with per-thread caches.
+//
+// Each host thread allocates from, and frees to, the cache of its thread slot
+// without locks or atomic read-modify-writes.  A cache that grows beyond
+// 2 * BATCH_ITEMS elements pushes BATCH_ITEMS of them onto a lock-free stack
+// shared by all threads; a thread whose cache runs empty takes over the whole
+// stack in one exchange, so elements are never popped one by one (no ABA).
+// Objects allocated by one thread and freed by another (in ROB-SMT,
+// simulate() can be called by any of the core's threads) thus find their way
+// back.  Only when both are empty is a new slab of SlabItems elements carved
+// up.  Caches of exiting threads are returned to the stack and their slots
+// are reused; threads that find no free slot share one extra cache under a
+// lock.  Counters are kept per cache and summed when statistics are read.
+template <typename T, unsigned SlabItems = 0> class TypedAllocator : public Allocator
 {
    private:
-      UInt64 m_items;
-      FSBAllocator_ElemAllocator<sizeof(DataElement) + sizeof(T), MaxItems, T> m_alloc;
+      static const size_t ELEMENT_SIZE = (sizeof(DataElement) + sizeof(T) + 15) & ~size_t(15);
+      static const unsigned SLAB_ITEMS = SlabItems ? SlabItems : 1024;
+      static const unsigned BATCH_ITEMS = 64;
+
+      struct ThreadCache
+      {
+         DataElement *head;
+         // Written only by the owning thread, atomic so they can be read for statistics
+         std::atomic<UInt64> allocs, frees, refills;
+         unsigned count;
+         char padding[64 - sizeof(DataElement*) - 3 * sizeof(std::atomic<UInt64>) - sizeof(unsigned)];   //< Avoid false sharing between threads
+      };
+      static_assert(sizeof(ThreadCache) == 64, "ThreadCache should fill one cache line");
+
+      ThreadCache m_caches[MAX_THREAD_SLOTS + 1];   //< The last one is used by threads without a slot, under m_unslotted_lock
+      std::atomic<DataElement*> m_free;             //< Lock-free stack of elements returned by the caches
+      Lock m_unslotted_lock;
+      Lock m_slab_lock;
+      std::vector<char*> m_slabs;                   //< Protected by m_slab_lock
+      UInt64 m_num_slabs;
+
+      static void increment(std::atomic<UInt64> &counter)
+      {
+         counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      }
+
+      UInt64 sum(std::atomic<UInt64> ThreadCache::*counter) const
+      {
+         UInt64 total = 0;
+         for(unsigned i = 0; i <= MAX_THREAD_SLOTS; ++i)
+            total += (m_caches[i].*counter).load(std::memory_order_relaxed);
+         return total;
+      }
+
+      static UInt64 getAllocs(String objectName, UInt32 index, String metricName, UInt64 arg)
+      {
+         return ((TypedAllocator*)arg)->sum(&ThreadCache::allocs);
+      }
 
-      // In ROB-SMT, DynamicMicroOps are allocated by their own thread but free'd in simulate() which can be called by anyone
-      Lock m_lock;
+      static UInt64 getRefills(String objectName, UInt32 index, String metricName, UInt64 arg)
+      {
+         return ((TypedAllocator*)arg)->sum(&ThreadCache::refills);
+      }
+
+      void push(DataElement *first, DataElement *last)
+      {
+         DataElement *head = m_free.load(std::memory_order_relaxed);
+         do
+            last->next = head;
+         while(!m_free.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+      }
+
+      void newSlab(ThreadCache &cache)
+      {
+         char *slab = (char*)aligned_alloc(16, SLAB_ITEMS * ELEMENT_SIZE);
+         LOG_ASSERT_ERROR(slab != NULL, "Cannot allocate slab of %u items of type %s", SLAB_ITEMS, typeid(T).name());
+         {
+            ScopedLock sl(m_slab_lock);
+            m_slabs.push_back(slab);
+            ++m_num_slabs;
+         }
+         for(unsigned i = SLAB_ITEMS; i > 0; --i)
+         {
+            DataElement *elem = (DataElement*)(slab + (i - 1) * ELEMENT_SIZE);
+            elem->next = cache.head;
+            cache.head = elem;
+         }
+         cache.count += SLAB_ITEMS;
+      }
+
+      void refill(ThreadCache &cache)
+      {
+         DataElement *elem = m_free.exchange(NULL, std::memory_order_acquire);
+         if (elem)
+         {
+            increment(cache.refills);
+            cache.head = elem;
+            for(; elem; elem = elem->next)
+               ++cache.count;
+         }
+         else
+            newSlab(cache);
+      }
+
+      void *allocFrom(ThreadCache &cache)
+      {
+         if (!cache.head)
+            refill(cache);
+         DataElement *elem = cache.head;
+         cache.head = elem->next;
+         --cache.count;
+         increment(cache.allocs);
+
+         elem->allocator = this;
+         return elem->data;
+      }
+
+      void deallocTo(ThreadCache &cache, DataElement *elem)
+      {
+         elem->next = cache.head;
+         cache.head = elem;
+         increment(cache.frees);
+         if (++cache.count > 2 * BATCH_ITEMS)
+         {
+            DataElement *first = cache.head, *last = first;
+            for(unsigned i = 1; i < BATCH_ITEMS; ++i)
+               last = last->next;
+            cache.head = last->next;
+            cache.count -= BATCH_ITEMS;
+            push(first, last);
+         }
+      }
+
+   protected:
+      virtual void releaseSlot(unsigned slot)
+      {
+         ThreadCache &cache = m_caches[slot];
+         if (cache.head)
+         {
+            DataElement *last = cache.head;
+            while(last->next)
+               last = last->next;
+            push(cache.head, last);
+            cache.head = NULL;
+            cache.count = 0;
+         }
+      }
 
    public:
       TypedAllocator()
-         : m_items(0)
-      {}
+         : m_free(NULL)
+         , m_num_slabs(0)
+      {
+         for(unsigned i = 0; i <= MAX_THREAD_SLOTS; ++i)
+         {
+            m_caches[i].head = NULL;
+            m_caches[i].count = 0;
+            m_caches[i].allocs = 0;
+            m_caches[i].frees = 0;
+            m_caches[i].refills = 0;
+         }
+         registerAllocator();
+      }
 
       virtual ~TypedAllocator()
       {
-         if (m_items)
+         unregisterAllocator();
+
+         UInt64 items = sum(&ThreadCache::allocs) - sum(&ThreadCache::frees);
+         if (items)
          {
             int status;
             char *nameoftype = abi::__cxa_demangle(typeid(T).name(), 0, 0, &status);
-            printf("[ALLOC] %" PRIu64 " items of type %s not freed\n", m_items, nameoftype);
+            printf("[ALLOC] %" PRIu64 " items of type %s not freed\n", items, nameoftype);
             free(nameoftype);
          }
+         for(std::vector<char*>::iterator it = m_slabs.begin(); it != m_slabs.end(); ++it)
+            free(*it);
+      }
+
+      virtual void registerStats(String objectName, core_id_t core_id, String prefix)
+      {
+         Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(objectName, core_id, prefix + "_allocs", getAllocs, (UInt64)this));
+         Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(objectName, core_id, prefix + "_refills", getRefills, (UInt64)this));
+         registerStatsMetric(objectName, core_id, prefix + "_slabs", &m_num_slabs);
       }
 
       virtual void* alloc(size_t bytes)
       {
-         ScopedLock sl(m_lock);
          //LOG_ASSERT_ERROR(bytes == sizeof(T), "");
-         ++m_items;
-         DataElement *elem = (DataElement *)m_alloc.allocate();
-         elem->allocator = this;
-         return elem->data;
+         unsigned slot = getThreadSlot();
+         if (slot == NO_SLOT)
+         {
+            ScopedLock sl(m_unslotted_lock);
+            return allocFrom(m_caches[MAX_THREAD_SLOTS]);
+         }
+         return allocFrom(m_caches[slot]);
       }
 
       virtual void _dealloc(void* ptr)
       {
-         ScopedLock sl(m_lock);
-         --m_items;
-         m_alloc.deallocate((T*)ptr);
+         DataElement *elem = (DataElement*)ptr;
+         unsigned slot = getThreadSlot();
+         if (slot == NO_SLOT)
+         {
+            ScopedLock sl(m_unslotted_lock);
+            deallocTo(m_caches[MAX_THREAD_SLOTS], elem);
+         }
+         else
+            deallocTo(m_caches[slot], elem);
       }
 };
 
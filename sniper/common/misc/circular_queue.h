@@ -3,6 +3,7 @@
 
 #include <assert.h>
 #include <string.h>
+#include <algorithm>
 
 template <class T> class CircularQueue
 {
@@ -34,9 +35,11 @@ template <class T> class CircularQueue
       CircularQueue(const CircularQueue &queue);
       ~CircularQueue();
       void push(const T& t);
+      void push(const T* items, UInt32 count);
       void pushCircular(const T& t);
       T& next(void);
       T pop(void);
+      UInt32 pop(T* items, UInt32 max_count);
       T& front(void);
       const T& front(void) const;
       T& back(void);
@@ -44,6 +47,7 @@ template <class T> class CircularQueue
       bool full(void) const;
       bool empty(void) const;
       UInt32 size(void) const;
+      UInt32 space(void) const { return m_size - 1 - size(); }
       iterator begin(void) { return iterator(*this, 0); }
       iterator end(void) { return iterator(*this, size()); }
       T& operator[](UInt32 idx) const { return m_queue[(m_last + idx) % m_size]; }
@@ -86,6 +90,20 @@ CircularQueue<T>::push(const T& t)
    m_first = (m_first + 1) % m_size;
 }
 
+template <class T>
+void
+CircularQueue<T>::push(const T* items, UInt32 count)
+{
+   assert(count <= space());
+   UInt32 first = m_first;
+   for(UInt32 i = 0; i < count; ++i)
+   {
+      m_queue[first] = items[i];
+      first = (first + 1) % m_size;
+   }
+   m_first = first;
+}
+
 template <class T>
 void
 CircularQueue<T>::pushCircular(const T& t)
@@ -115,6 +133,21 @@ CircularQueue<T>::pop()
    return m_queue[idx];
 }
 
+template <class T>
+UInt32
+CircularQueue<T>::pop(T* items, UInt32 max_count)
+{
+   UInt32 count = std::min(size(), max_count);
+   UInt32 last = m_last;
+   for(UInt32 i = 0; i < count; ++i)
+   {
+      items[i] = m_queue[last];
+      last = (last + 1) % m_size;
+   }
+   m_last = last;
+   return count;
+}
+
 template <class T>
 T &
 CircularQueue<T>::front()
@@ -21,9 +21,11 @@ template <class T> class MTCircularQueue : public CircularQueue<T>
       void push(const T& t);
       void push_wait(const T& t);
       void push_locked(const T& t);
+      void push_wait(const T* items, UInt32 count);
       T pop(void);
       T pop_wait(void);
       T pop_locked(void);
+      UInt32 pop(T* items, UInt32 max_count);
       void full_wait(void);
       void empty_wait(void);
       void full_wait_locked(void);
@@ -95,6 +97,25 @@ MTCircularQueue<T>::push_wait(const T& t)
 
 
 
+// Push a batch of items under a single lock acquisition, waiting for space as needed
+template <class T>
+void
+MTCircularQueue<T>::push_wait(const T* items, UInt32 count)
+{
+   ScopedLock sl(m_lock);
+   while(count)
+   {
+      full_wait_locked();
+      bool wasEmpty = CircularQueue<T>::empty();
+      UInt32 n = std::min(count, CircularQueue<T>::space());
+      CircularQueue<T>::push(items, n);
+      items += n;
+      count -= n;
+      if (wasEmpty)
+         m_empty.signal();
+   }
+}
+
 template <class T>
 T
 MTCircularQueue<T>::pop_locked()
@@ -126,4 +147,17 @@ MTCircularQueue<T>::pop_wait()
    return pop_locked();
 }
 
+// Pop up to <max_count> items under a single lock acquisition, returns the number of items popped
+template <class T>
+UInt32
+MTCircularQueue<T>::pop(T* items, UInt32 max_count)
+{
+   ScopedLock sl(m_lock);
+   bool wasFull = CircularQueue<T>::full();
+   UInt32 count = CircularQueue<T>::pop(items, max_count);
+   if (wasFull && count)
+      m_full.signal();
+   return count;
+}
+
 #endif //MT_CIRCULAR_QUEUE_H
@@ -2,6 +2,8 @@
 #include "branch_predictor.h"
 #include "one_bit_branch_predictor.h"
 #include "pentium_m_branch_predictor.h"
+#include "tage_sc_l_branch_predictor.h"
+#include "hashed_perceptron_branch_predictor.h"
 #include "config.hpp"
 #include "stats.h"
 
@@ -47,6 +49,14 @@ BranchPredictor* BranchPredictor::create(core_id_t core_id)
       {
          return new PentiumMBranchPredictor("branch_predictor", core_id);
       }
+      else if (type == "tage_sc_l")
+      {
+         return new TageScLBranchPredictor("branch_predictor", core_id);
+      }
+      else if (type == "perceptron")
+      {
+         return new HashedPerceptronBranchPredictor("branch_predictor", core_id);
+      }
       else
       {
          LOG_PRINT_ERROR("Invalid branch predictor type.");
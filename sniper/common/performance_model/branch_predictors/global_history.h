@@ -0,0 +1,75 @@
+#ifndef GLOBAL_HISTORY_H
+#define GLOBAL_HISTORY_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+#include <cstring>
+
+// Global branch outcome history, kept in a circular buffer so that pushing a
+// new outcome does not shift the whole history.  Bit 0 is the most recent outcome.
+class GlobalHistory
+{
+public:
+   static const UInt32 MAX_LENGTH = 4096;
+
+   GlobalHistory()
+      : m_ptr(0)
+   {
+      memset(m_bits, 0, sizeof(m_bits));
+   }
+
+   void push(bool taken)
+   {
+      m_ptr = (m_ptr - 1) & (MAX_LENGTH - 1);
+      m_bits[m_ptr] = taken;
+   }
+
+   UInt8 operator[](UInt32 idx) const { return m_bits[(m_ptr + idx) & (MAX_LENGTH - 1)]; }
+
+private:
+   UInt8 m_bits[MAX_LENGTH];
+   UInt32 m_ptr;
+};
+
+// The <length> most recent history bits, XOR-folded into <width> bits.
+// Updated incrementally after every GlobalHistory::push, so hashing long
+// histories into table indices costs a few operations per branch.
+class FoldedHistory
+{
+public:
+   FoldedHistory()
+      : m_value(0)
+      , m_length(0)
+      , m_width(1)
+      , m_outpoint(0)
+   {}
+
+   void init(UInt32 length, UInt32 width)
+   {
+      LOG_ASSERT_ERROR(length < GlobalHistory::MAX_LENGTH, "History length %u too long", length);
+      LOG_ASSERT_ERROR(width > 0 && width < 32, "Invalid folded history width %u", width);
+      m_value = 0;
+      m_length = length;
+      m_width = width;
+      m_outpoint = length % width;
+   }
+
+   void update(const GlobalHistory &history)
+   {
+      m_value = (m_value << 1) ^ history[0];
+      m_value ^= history[m_length] << m_outpoint;
+      m_value ^= m_value >> m_width;
+      m_value &= (1u << m_width) - 1;
+   }
+
+   UInt32 get() const { return m_value; }
+
+private:
+   UInt32 m_value;
+   UInt32 m_length;
+   UInt32 m_width;
+   UInt32 m_outpoint;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "simulator.h"
+#include "hashed_perceptron_branch_predictor.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <cmath>
+#include <cstdlib>
+
+HashedPerceptronBranchPredictor::HashedPerceptronBranchPredictor(String name, core_id_t core_id)
+   : BranchPredictor(name, core_id)
+   , m_num_tables(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/perceptron/num_tables", core_id))
+   , m_log_entries(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/perceptron/log_entries", core_id))
+   , m_theta(UInt32(1.93 * m_num_tables + 14))
+   , m_theta_ctr(0)
+   , m_last_ip(INVALID_ADDRESS)
+   , m_sum(0)
+{
+   UInt32 min_history = Sim()->getCfg()->getIntArray("perf_model/branch_predictor/perceptron/min_history", core_id);
+   UInt32 max_history = Sim()->getCfg()->getIntArray("perf_model/branch_predictor/perceptron/max_history", core_id);
+
+   LOG_ASSERT_ERROR(m_num_tables >= 3 && m_num_tables <= MAX_TABLES, "Perceptron needs between 3 and %u tables", MAX_TABLES);
+   LOG_ASSERT_ERROR(min_history >= 1 && min_history < max_history, "Invalid perceptron history lengths %u-%u", min_history, max_history);
+
+   for(UInt32 i = 1; i < m_num_tables; ++i)
+   {
+      UInt32 length = UInt32(min_history * pow(double(max_history) / min_history, double(i - 1) / (m_num_tables - 2)) + 0.5);
+      m_fold[i].init(length, m_log_entries);
+   }
+
+   m_weights = new SInt8[m_num_tables << m_log_entries];
+   memset(m_weights, 0, sizeof(SInt8) * (m_num_tables << m_log_entries));
+
+   m_storage_bits = (UInt64(m_num_tables) << m_log_entries) * 8 + max_history;
+   registerStatsMetric(name, core_id, "storage-bits", &m_storage_bits);
+}
+
+HashedPerceptronBranchPredictor::~HashedPerceptronBranchPredictor()
+{
+   delete [] m_weights;
+}
+
+bool HashedPerceptronBranchPredictor::predict(IntPtr ip, IntPtr target)
+{
+   m_last_ip = ip;
+
+   m_sum = 0;
+   for(UInt32 i = 0; i < m_num_tables; ++i)
+   {
+      m_index[i] = (ip ^ (ip >> (m_log_entries - i % m_log_entries)) ^ m_fold[i].get()) & ((1 << m_log_entries) - 1);
+      m_sum += m_weights[(i << m_log_entries) + m_index[i]];
+   }
+
+   return m_sum >= 0;
+}
+
+void HashedPerceptronBranchPredictor::update(bool predicted, bool actual, IntPtr ip, IntPtr target)
+{
+   updateCounters(predicted, actual);
+
+   if (ip != m_last_ip)
+      predict(ip, target);
+
+   bool prediction = m_sum >= 0;
+   if (prediction != actual || std::abs(m_sum) <= m_theta)
+   {
+      for(UInt32 i = 0; i < m_num_tables; ++i)
+      {
+         SInt8 &weight = m_weights[(i << m_log_entries) + m_index[i]];
+         if (actual && weight < 127)
+            ++weight;
+         else if (!actual && weight > -128)
+            --weight;
+      }
+
+      // Adaptive training threshold (O-GEHL)
+      if (prediction != actual)
+      {
+         if (++m_theta_ctr >= 127)
+         {
+            ++m_theta;
+            m_theta_ctr = 0;
+         }
+      }
+      else
+      {
+         if (--m_theta_ctr <= -128)
+         {
+            if (m_theta > 1)
+               --m_theta;
+            m_theta_ctr = 0;
+         }
+      }
+   }
+
+   m_history.push(actual);
+   for(UInt32 i = 1; i < m_num_tables; ++i)
+      m_fold[i].update(m_history);
+
+   m_last_ip = INVALID_ADDRESS;
+}
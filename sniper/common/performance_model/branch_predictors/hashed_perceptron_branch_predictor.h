@@ -0,0 +1,44 @@
+#ifndef HASHED_PERCEPTRON_BRANCH_PREDICTOR_H
+#define HASHED_PERCEPTRON_BRANCH_PREDICTOR_H
+
+#include "branch_predictor.h"
+#include "global_history.h"
+
+// Hashed perceptron (Tarjan and Skadron): each table holds 8-bit weights and is
+// indexed by the branch address hashed with a global history prefix of its
+// own length, geometrically increasing from table to table.  The prediction
+// is the sign of the sum of the selected weights.  Table 0 ignores history
+// and acts as the per-branch bias.  Training uses the adaptive threshold from
+// O-GEHL.
+class HashedPerceptronBranchPredictor : public BranchPredictor
+{
+public:
+   HashedPerceptronBranchPredictor(String name, core_id_t core_id);
+   ~HashedPerceptronBranchPredictor();
+
+   bool predict(IntPtr ip, IntPtr target);
+   void update(bool predicted, bool actual, IntPtr ip, IntPtr target);
+
+private:
+   static const UInt32 MAX_TABLES = 32;
+
+   const UInt32 m_num_tables;
+   const UInt32 m_log_entries;
+
+   SInt8 *m_weights;
+
+   GlobalHistory m_history;
+   FoldedHistory m_fold[MAX_TABLES];
+
+   SInt32 m_theta;
+   SInt32 m_theta_ctr;
+
+   // State of the last prediction, consumed by update()
+   IntPtr m_last_ip;
+   UInt32 m_index[MAX_TABLES];
+   SInt32 m_sum;
+
+   UInt64 m_storage_bits;
+};
+
+#endif
@@ -0,0 +1,368 @@
+#include "simulator.h"
+#include "tage_sc_l_branch_predictor.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <cmath>
+#include <cstdlib>
+
+// History lengths of the statistical corrector tables, table 0 is a per-branch bias
+static const UInt32 SC_HISTORY_LENGTHS[] = { 0, 4, 10, 24 };
+
+TageScLBranchPredictor::TageScLBranchPredictor(String name, core_id_t core_id)
+   : BranchPredictor(name, core_id)
+   , m_num_tables(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/num_tables", core_id))
+   , m_log_entries(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/log_entries", core_id))
+   , m_tag_bits(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/tag_bits", core_id))
+   , m_log_bimodal_entries(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/log_bimodal_entries", core_id))
+   , m_log_sc_entries(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/log_sc_entries", core_id))
+   , m_log_loop_entries(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/log_loop_entries", core_id))
+   , m_path(0)
+   , m_use_alt_on_na(0)
+   , m_sc_threshold(35)
+   , m_sc_threshold_ctr(0)
+   , m_tick(0)
+   , m_seed(core_id)
+   , m_last_ip(INVALID_ADDRESS)
+   , m_tagged_provided(0)
+   , m_sc_overrides(0)
+   , m_loop_overrides(0)
+{
+   UInt32 min_history = Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/min_history", core_id);
+   UInt32 max_history = Sim()->getCfg()->getIntArray("perf_model/branch_predictor/tage_sc_l/max_history", core_id);
+
+   LOG_ASSERT_ERROR(m_num_tables >= 2 && m_num_tables <= MAX_TABLES, "TAGE needs between 2 and %u tagged tables", MAX_TABLES);
+   LOG_ASSERT_ERROR(m_tag_bits >= 4 && m_tag_bits <= 16, "TAGE tag width must be between 4 and 16 bits");
+   LOG_ASSERT_ERROR(min_history >= 1 && min_history < max_history, "Invalid TAGE history lengths %u-%u", min_history, max_history);
+   LOG_ASSERT_ERROR(m_log_loop_entries == 0 || m_log_loop_entries >= 2, "Loop predictor needs at least %u entries", LOOP_WAYS);
+
+   // Geometric series of history lengths
+   for(UInt32 i = 0; i < m_num_tables; ++i)
+   {
+      m_history_lengths[i] = UInt32(min_history * pow(double(max_history) / min_history, double(i) / (m_num_tables - 1)) + 0.5);
+      m_fold_index[i].init(m_history_lengths[i], m_log_entries);
+      m_fold_tag[0][i].init(m_history_lengths[i], m_tag_bits);
+      m_fold_tag[1][i].init(m_history_lengths[i], m_tag_bits - 1);
+   }
+   for(UInt32 j = 1; j < NUM_SC_TABLES; ++j)
+      m_fold_sc[j].init(SC_HISTORY_LENGTHS[j], m_log_sc_entries);
+
+   m_bimodal = new SInt8[1 << m_log_bimodal_entries];
+   m_tagged = new TaggedEntry[m_num_tables << m_log_entries];
+   m_sc = new SInt8[NUM_SC_TABLES << m_log_sc_entries];
+   m_loop = m_log_loop_entries ? new LoopEntry[1 << m_log_loop_entries] : NULL;
+
+   memset(m_bimodal, 0, sizeof(SInt8) << m_log_bimodal_entries);
+   memset(m_tagged, 0, sizeof(TaggedEntry) * (m_num_tables << m_log_entries));
+   memset(m_sc, 0, sizeof(SInt8) * (NUM_SC_TABLES << m_log_sc_entries));
+   if (m_loop)
+      memset(m_loop, 0, sizeof(LoopEntry) << m_log_loop_entries);
+
+   // Modeled storage: tagged entries hold a tag, 3-bit counter and 2-bit usefulness,
+   // SC counters are 6 bits, loop entries have 14-bit tags and iteration counts
+   m_storage_bits = (UInt64(m_num_tables) << m_log_entries) * (m_tag_bits + 3 + 2)
+                  + (UInt64(1) << m_log_bimodal_entries) * 2
+                  + (UInt64(NUM_SC_TABLES) << m_log_sc_entries) * 6
+                  + (m_log_loop_entries ? (UInt64(1) << m_log_loop_entries) * (3 * 14 + 2 + 8 + 1) : 0)
+                  + max_history + 16;
+
+   registerStatsMetric(name, core_id, "storage-bits", &m_storage_bits);
+   registerStatsMetric(name, core_id, "tagged-provided", &m_tagged_provided);
+   registerStatsMetric(name, core_id, "sc-overrides", &m_sc_overrides);
+   registerStatsMetric(name, core_id, "loop-overrides", &m_loop_overrides);
+}
+
+TageScLBranchPredictor::~TageScLBranchPredictor()
+{
+   delete [] m_bimodal;
+   delete [] m_tagged;
+   delete [] m_sc;
+   delete [] m_loop;
+}
+
+bool TageScLBranchPredictor::predict(IntPtr ip, IntPtr target)
+{
+   m_last_ip = ip;
+
+   // TAGE: the hitting table with the longest history provides the prediction
+   m_bimodal_index = (ip ^ (ip >> m_log_bimodal_entries)) & ((1 << m_log_bimodal_entries) - 1);
+   m_provider = -1;
+   m_alt_provider = -1;
+   for(SInt32 i = m_num_tables - 1; i >= 0; --i)
+   {
+      UInt32 path = m_path & ((1 << std::min(m_history_lengths[i], 16u)) - 1);
+      m_index[i] = (ip ^ (ip >> (std::abs(SInt32(m_log_entries) - i) + 1)) ^ m_fold_index[i].get() ^ path ^ (path >> (i % 4 + 1)))
+                 & ((1 << m_log_entries) - 1);
+      m_tag[i] = (ip ^ m_fold_tag[0][i].get() ^ (m_fold_tag[1][i].get() << 1)) & ((1 << m_tag_bits) - 1);
+
+      if (getEntry(i).tag == m_tag[i])
+      {
+         if (m_provider < 0)
+            m_provider = i;
+         else if (m_alt_provider < 0)
+            m_alt_provider = i;
+      }
+   }
+
+   bool bimodal_pred = m_bimodal[m_bimodal_index] >= 0;
+   m_alt_pred = m_alt_provider >= 0 ? getEntry(m_alt_provider).ctr >= 0 : bimodal_pred;
+   SInt32 tage_confidence = 1;
+   if (m_provider >= 0)
+   {
+      const TaggedEntry &entry = getEntry(m_provider);
+      m_provider_pred = entry.ctr >= 0;
+      // Newly allocated entries are often worse than the alternate prediction
+      bool weak_new = (entry.ctr == 0 || entry.ctr == -1) && entry.u == 0;
+      m_tage_pred = (weak_new && m_use_alt_on_na >= 0) ? m_alt_pred : m_provider_pred;
+      tage_confidence = std::abs(2 * entry.ctr + 1);
+   }
+   else
+   {
+      m_provider_pred = bimodal_pred;
+      m_tage_pred = bimodal_pred;
+   }
+
+   // Statistical corrector, indexed with the TAGE prediction so it learns when TAGE is wrong
+   m_sc_sum = (m_tage_pred ? 1 : -1) * 8 * tage_confidence;
+   for(UInt32 j = 0; j < NUM_SC_TABLES; ++j)
+   {
+      m_sc_index[j] = (ip ^ (ip >> m_log_sc_entries) ^ (m_fold_sc[j].get() << 1) ^ m_tage_pred) & ((1 << m_log_sc_entries) - 1);
+      m_sc_sum += 2 * m_sc[(j << m_log_sc_entries) + m_sc_index[j]] + 1;
+   }
+   m_sc_pred = m_sc_sum >= 0;
+
+   // Loop predictor
+   m_loop_way = -1;
+   m_loop_valid = false;
+   if (m_loop)
+   {
+      m_loop_set = ip & ((1 << (m_log_loop_entries - 2)) - 1);
+      m_loop_tag = (ip >> (m_log_loop_entries - 2)) & 0x3fff;
+      for(UInt32 w = 0; w < LOOP_WAYS; ++w)
+      {
+         const LoopEntry &entry = m_loop[m_loop_set * LOOP_WAYS + w];
+         if (entry.age > 0 && entry.tag == m_loop_tag)
+         {
+            m_loop_way = w;
+            m_loop_valid = entry.confidence == 3;
+            m_loop_pred = (entry.current_iter + 1 == entry.past_iter) ? !entry.dir : entry.dir;
+            break;
+         }
+      }
+   }
+
+   if (m_loop_valid)
+      return m_loop_pred;
+   else
+      return m_sc_pred;
+}
+
+void TageScLBranchPredictor::update(bool predicted, bool actual, IntPtr ip, IntPtr target)
+{
+   updateCounters(predicted, actual);
+
+   if (ip != m_last_ip)
+      predict(ip, target);
+
+   if (m_provider >= 0)
+      ++m_tagged_provided;
+   if (m_loop_valid)
+   {
+      if (m_loop_pred != m_tage_pred)
+         ++m_loop_overrides;
+   }
+   else if (m_sc_pred != m_tage_pred)
+      ++m_sc_overrides;
+
+   updateLoop(actual);
+   updateStatisticalCorrector(actual);
+   updateTage(actual);
+   updateHistories(actual, ip);
+
+   m_last_ip = INVALID_ADDRESS;
+}
+
+void TageScLBranchPredictor::updateLoop(bool actual)
+{
+   if (!m_loop)
+      return;
+
+   if (m_loop_way >= 0)
+   {
+      LoopEntry &entry = m_loop[m_loop_set * LOOP_WAYS + m_loop_way];
+      if (m_loop_valid)
+      {
+         if (m_loop_pred != actual)
+         {
+            // Not a loop with a constant trip count after all, free the entry
+            memset(&entry, 0, sizeof(entry));
+            return;
+         }
+         if (m_loop_pred != m_tage_pred && entry.age < 255)
+            ++entry.age;
+      }
+
+      entry.current_iter = (entry.current_iter + 1) & 0x3fff;
+      if (entry.current_iter == 0)
+      {
+         // Trip count too large to track
+         memset(&entry, 0, sizeof(entry));
+         return;
+      }
+      if (actual != entry.dir)
+      {
+         if (entry.current_iter == entry.past_iter)
+         {
+            if (entry.confidence < 3)
+               ++entry.confidence;
+         }
+         else
+         {
+            entry.past_iter = entry.current_iter;
+            entry.confidence = 0;
+         }
+         entry.current_iter = 0;
+      }
+   }
+   else if (m_tage_pred != actual)
+   {
+      // A mispredicted branch may be a loop exit: try to allocate, assuming the body goes the other way
+      LoopEntry &entry = m_loop[m_loop_set * LOOP_WAYS + random() % LOOP_WAYS];
+      if (entry.age == 0)
+      {
+         entry.tag = m_loop_tag;
+         entry.past_iter = 0;
+         entry.current_iter = 0;
+         entry.confidence = 0;
+         entry.age = 7;
+         entry.dir = !actual;
+      }
+      else
+         --entry.age;
+   }
+}
+
+void TageScLBranchPredictor::updateStatisticalCorrector(bool actual)
+{
+   if (m_sc_pred != actual || std::abs(m_sc_sum) < m_sc_threshold)
+   {
+      for(UInt32 j = 0; j < NUM_SC_TABLES; ++j)
+      {
+         SInt8 &ctr = m_sc[(j << m_log_sc_entries) + m_sc_index[j]];
+         if (actual && ctr < 31)
+            ++ctr;
+         else if (!actual && ctr > -32)
+            --ctr;
+      }
+   }
+
+   // Adaptive training threshold (O-GEHL)
+   if (m_sc_pred != actual)
+   {
+      if (++m_sc_threshold_ctr >= 63)
+      {
+         ++m_sc_threshold;
+         m_sc_threshold_ctr = 0;
+      }
+   }
+   else if (std::abs(m_sc_sum) < m_sc_threshold)
+   {
+      if (--m_sc_threshold_ctr <= -64)
+      {
+         if (m_sc_threshold > 1)
+            --m_sc_threshold;
+         m_sc_threshold_ctr = 0;
+      }
+   }
+}
+
+void TageScLBranchPredictor::updateTage(bool actual)
+{
+   if (m_provider >= 0)
+   {
+      TaggedEntry &entry = getEntry(m_provider);
+      bool weak_new = (entry.ctr == 0 || entry.ctr == -1) && entry.u == 0;
+
+      if (weak_new)
+      {
+         if (m_provider_pred != m_alt_pred)
+         {
+            if (m_alt_pred == actual && m_use_alt_on_na < 7)
+               ++m_use_alt_on_na;
+            else if (m_alt_pred != actual && m_use_alt_on_na > -8)
+               --m_use_alt_on_na;
+         }
+         // The provider is not trusted yet, keep training the alternate prediction
+         SInt8 &alt_ctr = m_alt_provider >= 0 ? getEntry(m_alt_provider).ctr : m_bimodal[m_bimodal_index];
+         SInt8 alt_max = m_alt_provider >= 0 ? 3 : 1;
+         if (actual && alt_ctr < alt_max)
+            ++alt_ctr;
+         else if (!actual && alt_ctr > -alt_max - 1)
+            --alt_ctr;
+      }
+
+      if (actual && entry.ctr < 3)
+         ++entry.ctr;
+      else if (!actual && entry.ctr > -4)
+         --entry.ctr;
+
+      if (m_provider_pred != m_alt_pred)
+      {
+         if (m_provider_pred == actual && entry.u < 3)
+            ++entry.u;
+         else if (m_provider_pred != actual && entry.u > 0)
+            --entry.u;
+      }
+   }
+   else
+   {
+      SInt8 &ctr = m_bimodal[m_bimodal_index];
+      if (actual && ctr < 1)
+         ++ctr;
+      else if (!actual && ctr > -2)
+         --ctr;
+   }
+
+   // On a misprediction, allocate an entry in a table with a longer history
+   if (m_tage_pred != actual && m_provider < SInt32(m_num_tables) - 1)
+   {
+      UInt32 start = m_provider + 1;
+      if (start + 1 < m_num_tables && (random() & 1))
+         ++start;
+
+      bool allocated = false;
+      for(UInt32 i = start; i < m_num_tables && !allocated; ++i)
+      {
+         TaggedEntry &entry = getEntry(i);
+         if (entry.u == 0)
+         {
+            entry.tag = m_tag[i];
+            entry.ctr = actual ? 0 : -1;
+            allocated = true;
+         }
+      }
+      if (!allocated)
+         for(UInt32 i = start; i < m_num_tables; ++i)
+            if (getEntry(i).u > 0)
+               --getEntry(i).u;
+   }
+
+   // Periodically age usefulness so stale entries can be replaced
+   if ((++m_tick & ((1 << 19) - 1)) == 0)
+      for(UInt32 i = 0; i < (m_num_tables << m_log_entries); ++i)
+         m_tagged[i].u >>= 1;
+}
+
+void TageScLBranchPredictor::updateHistories(bool actual, IntPtr ip)
+{
+   m_history.push(actual);
+   for(UInt32 i = 0; i < m_num_tables; ++i)
+   {
+      m_fold_index[i].update(m_history);
+      m_fold_tag[0][i].update(m_history);
+      m_fold_tag[1][i].update(m_history);
+   }
+   for(UInt32 j = 1; j < NUM_SC_TABLES; ++j)
+      m_fold_sc[j].update(m_history);
+   m_path = ((m_path << 1) ^ ((ip ^ (ip >> 2)) & 1)) & 0xffff;
+}
@@ -0,0 +1,104 @@
+#ifndef TAGE_SC_L_BRANCH_PREDICTOR_H
+#define TAGE_SC_L_BRANCH_PREDICTOR_H
+
+#include "branch_predictor.h"
+#include "global_history.h"
+
+// TAGE-SC-L (Seznec, CBP 2016): a bimodal base predictor and a set of tagged
+// tables indexed with geometrically increasing global history lengths, backed
+// by a statistical corrector that can revert low-confidence TAGE predictions
+// and a loop predictor for loops with a constant trip count.
+//
+// All tables are allocated once as flat arrays of small packed entries.
+// predict() keeps the indices it computed so update() does not rehash.
+class TageScLBranchPredictor : public BranchPredictor
+{
+public:
+   TageScLBranchPredictor(String name, core_id_t core_id);
+   ~TageScLBranchPredictor();
+
+   bool predict(IntPtr ip, IntPtr target);
+   void update(bool predicted, bool actual, IntPtr ip, IntPtr target);
+
+private:
+   static const UInt32 MAX_TABLES = 16;
+   static const UInt32 NUM_SC_TABLES = 4;
+   static const UInt32 LOOP_WAYS = 4;
+
+   struct TaggedEntry
+   {
+      UInt16 tag;
+      SInt8 ctr;     // 3-bit signed counter
+      UInt8 u;       // 2-bit usefulness
+   };
+
+   struct LoopEntry
+   {
+      UInt16 tag;
+      UInt16 past_iter;
+      UInt16 current_iter;
+      UInt8 confidence;
+      UInt8 age;
+      bool dir;      // Direction of the loop body, the exit goes the other way
+   };
+
+   const UInt32 m_num_tables;
+   const UInt32 m_log_entries;
+   const UInt32 m_tag_bits;
+   const UInt32 m_log_bimodal_entries;
+   const UInt32 m_log_sc_entries;
+   const UInt32 m_log_loop_entries;
+
+   UInt32 m_history_lengths[MAX_TABLES];
+
+   SInt8 *m_bimodal;
+   TaggedEntry *m_tagged;
+   SInt8 *m_sc;
+   LoopEntry *m_loop;
+
+   GlobalHistory m_history;
+   UInt32 m_path;
+   FoldedHistory m_fold_index[MAX_TABLES];
+   FoldedHistory m_fold_tag[2][MAX_TABLES];
+   FoldedHistory m_fold_sc[NUM_SC_TABLES];
+
+   SInt32 m_use_alt_on_na;
+   SInt32 m_sc_threshold;
+   SInt32 m_sc_threshold_ctr;
+   UInt32 m_tick;
+   UInt32 m_seed;
+
+   // State of the last prediction, consumed by update()
+   IntPtr m_last_ip;
+   UInt32 m_bimodal_index;
+   UInt32 m_index[MAX_TABLES];
+   UInt16 m_tag[MAX_TABLES];
+   SInt32 m_provider;
+   SInt32 m_alt_provider;
+   bool m_provider_pred;
+   bool m_alt_pred;
+   bool m_tage_pred;
+   UInt32 m_sc_index[NUM_SC_TABLES];
+   SInt32 m_sc_sum;
+   bool m_sc_pred;
+   UInt32 m_loop_set;
+   SInt32 m_loop_way;
+   UInt16 m_loop_tag;
+   bool m_loop_valid;
+   bool m_loop_pred;
+
+   UInt64 m_storage_bits;
+   UInt64 m_tagged_provided;
+   UInt64 m_sc_overrides;
+   UInt64 m_loop_overrides;
+
+   TaggedEntry& getEntry(UInt32 table) { return m_tagged[(table << m_log_entries) + m_index[table]]; }
+   UInt32 random() { m_seed = m_seed * 1103515245 + 12345; return m_seed >> 16; }
+
+   void updateLoop(bool actual);
+   void updateStatisticalCorrector(bool actual);
+   void updateTage(bool actual);
+   void updateHistories(bool actual, IntPtr ip);
+};
+
+#endif
@@ -15,8 +15,12 @@ FastforwardPerformanceModel::FastforwardPerformanceModel(Core *core, Performance
    , m_branch_misprediction_penalty(core->getDvfsDomain(), Sim()->getCfg()->getIntArray("perf_model/branch_predictor/mispredict_penalty", core->getId()))
    , m_cpi(SubsecondTime::Zero())
    , m_fastforwarded_time(SubsecondTime::Zero())
+   , m_fastforwarded_instructions(0)
+   , m_warmup_instructions(0)
 {
    registerStatsMetric("fastforward_performance_model", core->getId(), "fastforwarded_time", &m_fastforwarded_time);
+   registerStatsMetric("fastforward_performance_model", core->getId(), "fastforwarded_instructions", &m_fastforwarded_instructions);
+   registerStatsMetric("fastforward_performance_model", core->getId(), "warmup_instructions", &m_warmup_instructions);
    registerStatsMetric("performance_model", core->getId(), "cpiFastforwardTime", &m_fastforwarded_time);
 
    registerStatsMetric("fastforward_timer", core->getId(), "cpiBase", &m_cpiBase);
@@ -59,20 +63,26 @@ FastforwardPerformanceModel::notifyElapsedTimeUpdate()
 void
 FastforwardPerformanceModel::countInstructions(IntPtr address, UInt32 count)
 {
+   if (InstMode::isWarmup(Sim()->getInstrumentationMode()))
+      m_warmup_instructions += count;
+   else
+      m_fastforwarded_instructions += count;
+
    incrementElapsedTime(count * m_cpi, m_cpiBase);
 }
 
 void
 FastforwardPerformanceModel::handleMemoryLatency(SubsecondTime latency, HitWhere::where_t hit_where)
 {
-   if (m_include_memory_latency)
+   // Functional warming has no timing model, time only advances at the fast-forward CPI
+   if (m_include_memory_latency && Sim()->getInstrumentationMode() != InstMode::FUNCTIONAL)
       incrementElapsedTime(latency, m_cpiDataCache[hit_where]);
 }
 
 void
 FastforwardPerformanceModel::handleBranchMispredict()
 {
-   if (m_include_branch_mispredict)
+   if (m_include_branch_mispredict && Sim()->getInstrumentationMode() != InstMode::FUNCTIONAL)
       incrementElapsedTime(m_branch_misprediction_penalty.getLatency(), m_cpiBranchPredictor);
 }
 
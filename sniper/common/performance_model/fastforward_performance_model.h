@@ -14,6 +14,8 @@ class FastforwardPerformanceModel
 
       SubsecondTime m_cpi;
       SubsecondTime m_fastforwarded_time;
+      UInt64 m_fastforwarded_instructions;
+      UInt64 m_warmup_instructions;
 
       SubsecondTime m_cpiBase;
       SubsecondTime m_cpiBranchPredictor;
@@ -5,6 +5,7 @@
 #include "instruction_tracer_print.h"
 #include "loop_tracer.h"
 #include "loop_profiler.h"
+#include "pc_profiler.h"
 
 void
 InstructionTracer::init()
@@ -30,6 +31,8 @@ InstructionTracer::create(const Core *core)
       return new LoopTracer(core);
    else if (type == "loop_profiler")
       return new LoopProfiler(core);
+   else if (type == "pc_profiler")
+      return new PcProfiler(core);
    else
       LOG_PRINT_ERROR("Unknown instruction tracer type %s", type.c_str());
 }
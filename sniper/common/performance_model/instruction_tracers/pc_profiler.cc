@@ -0,0 +1,339 @@
+#include "pc_profiler.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "core.h"
+#include "thread.h"
+#include "hooks_manager.h"
+#include "dynamic_micro_op.h"
+#include "instruction.h"
+#include "hit_where.h"
+#include "stats.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <set>
+
+PcProfiler::PcProfiler(const Core *core)
+   : m_core(core)
+   , m_pc_mask(Sim()->getCfg()->getInt("instruction_tracer/pc_profiler/pc_table_size") - 1)
+   , m_loop_mask(Sim()->getCfg()->getInt("instruction_tracer/pc_profiler/loop_table_size") - 1)
+   , m_sample_interval(Sim()->getCfg()->getInt("instruction_tracer/pc_profiler/stack_sample_interval"))
+   , m_top(Sim()->getCfg()->getInt("instruction_tracer/pc_profiler/top"))
+   , m_pc_current(NULL)
+   , m_loop_current(NULL)
+   , m_loop_begin(0)
+   , m_loop_end(0)
+   , m_eip_last(0)
+   , m_sample_countdown(m_sample_interval)
+   , m_instructions(0)
+   , m_spills(0)
+   , m_stack_samples(0)
+{
+   LOG_ASSERT_ERROR(isPower2(m_pc_mask + 1), "instruction_tracer/pc_profiler/pc_table_size must be a power of 2");
+   LOG_ASSERT_ERROR(isPower2(m_loop_mask + 1), "instruction_tracer/pc_profiler/loop_table_size must be a power of 2");
+
+   PcEntry pc_empty = { 0, Counters() };
+   m_pcs.resize(m_pc_mask + 1, pc_empty);
+   LoopEntry loop_empty = { 0, 0, 0, Counters() };
+   m_loops.resize(m_loop_mask + 1, loop_empty);
+
+   registerStatsMetric("pc_profiler", core->getId(), "instructions", &m_instructions);
+   registerStatsMetric("pc_profiler", core->getId(), "spills", &m_spills);
+   registerStatsMetric("pc_profiler", core->getId(), "stack_samples", &m_stack_samples);
+
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, hookPreStatWrite, (UInt64)this);
+}
+
+PcProfiler::~PcProfiler()
+{
+}
+
+void
+PcProfiler::traceInstruction(const DynamicMicroOp *uop, uop_times_t *times)
+{
+   const MicroOp *micro_op = uop->getMicroOp();
+
+   if (micro_op->isFirst())
+   {
+      // Ignore dynamic instructions
+      if (!micro_op->getInstruction())
+      {
+         m_pc_current = NULL;
+         return;
+      }
+
+      newInstruction(micro_op->getInstruction()->getAddress());
+
+      if (uop->getICacheHitWhere() != HitWhere::L1I)
+      {
+         ++m_pc_current->icache_misses;
+         ++m_sample.icache_misses;
+         if (m_loop_current)
+            ++m_loop_current->icache_misses;
+      }
+   }
+
+   if (!m_pc_current)
+      return;
+
+   if (micro_op->isLoad() || micro_op->isStore())
+   {
+      HitWhere::where_t where = uop->getDCacheHitWhere();
+      if (where != HitWhere::L1_OWN && where != HitWhere::UNKNOWN && where != HitWhere::PREDICATE_FALSE)
+      {
+         UInt64 dram = (where == HitWhere::DRAM || where == HitWhere::DRAM_LOCAL || where == HitWhere::DRAM_REMOTE) ? 1 : 0;
+         UInt64 latency = (micro_op->isLoad() && times) ? (times->done - times->issue).getFS() : 0;
+
+         ++m_pc_current->dcache_misses;
+         m_pc_current->dram_accesses += dram;
+         m_pc_current->load_latency += latency;
+         ++m_sample.dcache_misses;
+         m_sample.dram_accesses += dram;
+         m_sample.load_latency += latency;
+         if (m_loop_current)
+         {
+            ++m_loop_current->dcache_misses;
+            m_loop_current->dram_accesses += dram;
+            m_loop_current->load_latency += latency;
+         }
+      }
+   }
+}
+
+void
+PcProfiler::newInstruction(IntPtr eip)
+{
+   ++m_instructions;
+
+   PcEntry &pc = m_pcs[(eip ^ (eip >> 16)) & m_pc_mask];
+   if (pc.eip != eip)
+   {
+      if (pc.counters.instructions)
+      {
+         ScopedLock sl(m_lock);
+         m_pc_spill.push_back(pc);
+         ++m_spills;
+         if (m_pc_spill.size() >= SPILL_MAX)
+            foldSpills();
+      }
+      pc.eip = eip;
+      pc.counters.clear();
+   }
+   m_pc_current = &pc.counters;
+   ++m_pc_current->instructions;
+
+   // Backwards jump: (re)enter the loop spanning [eip, m_eip_last]
+   UInt64 size = m_eip_last - eip;
+   if (eip < m_eip_last && size < 1000)
+   {
+      LoopEntry &loop = m_loops[(eip ^ (eip >> 12) ^ (size << 4)) & m_loop_mask];
+      if (loop.eip != eip || loop.size != size)
+      {
+         if (loop.iterations)
+         {
+            ScopedLock sl(m_lock);
+            m_loop_spill.push_back(loop);
+            ++m_spills;
+            if (m_loop_spill.size() >= SPILL_MAX)
+               foldSpills();
+         }
+         loop.eip = eip;
+         loop.size = size;
+         loop.iterations = 0;
+         loop.counters.clear();
+      }
+      ++loop.iterations;
+      m_loop_current = &loop.counters;
+      m_loop_begin = eip;
+      m_loop_end = eip + size;
+   }
+   else if (eip < m_loop_begin || eip > m_loop_end)
+   {
+      // Left the innermost loop we know of
+      m_loop_current = NULL;
+   }
+   if (m_loop_current)
+      ++m_loop_current->instructions;
+
+   m_eip_last = eip;
+
+   ++m_sample.instructions;
+   if (m_sample_interval && --m_sample_countdown == 0)
+   {
+      sampleCallStack();
+      m_sample_countdown = m_sample_interval;
+   }
+}
+
+void
+PcProfiler::sampleCallStack()
+{
+   Thread *thread = m_core->getThread();
+   if (thread && thread->getRoutineTracer())
+   {
+      CallStack stack = thread->getRoutineTracer()->getCallStackCopy();
+      if (stack.size())
+      {
+         ScopedLock sl(m_lock);
+         m_stacks[stack].add(m_sample);
+         ++m_stack_samples;
+      }
+   }
+   m_sample.clear();
+}
+
+void
+PcProfiler::foldSpills()
+{
+   // Caller holds m_lock
+   for(auto it = m_pc_spill.begin(); it != m_pc_spill.end(); ++it)
+      m_pc_merged[it->eip].add(it->counters);
+   m_pc_spill.clear();
+
+   for(auto it = m_loop_spill.begin(); it != m_loop_spill.end(); ++it)
+   {
+      auto key = std::make_pair(it->eip, it->size);
+      if (m_loop_merged.count(key))
+      {
+         m_loop_merged[key].iterations += it->iterations;
+         m_loop_merged[key].counters.add(it->counters);
+      }
+      else
+         m_loop_merged[key] = *it;
+   }
+   m_loop_spill.clear();
+}
+
+static const char* routineName(IntPtr eip)
+{
+   const RoutineTracer::Routine *rtn = Sim()->getRoutineTracer() ? Sim()->getRoutineTracer()->getRoutineInfo(eip) : NULL;
+   return rtn ? rtn->m_name : "(unknown)";
+}
+
+void
+PcProfiler::writeRows(FILE *fp, const char *title, Rows &rows, UInt32 top, UInt64 total)
+{
+   // Keep the <top> rows with the most instructions, and the <top> rows with the most L1-D misses
+   std::set<size_t> selected;
+   std::vector<size_t> order(rows.size());
+   for(size_t i = 0; i < rows.size(); ++i)
+      order[i] = i;
+   std::sort(order.begin(), order.end(), [&rows](size_t a, size_t b) { return rows[a].second.instructions > rows[b].second.instructions; });
+   selected.insert(order.begin(), order.begin() + std::min(order.size(), size_t(top)));
+   std::sort(order.begin(), order.end(), [&rows](size_t a, size_t b) { return rows[a].second.dcache_misses > rows[b].second.dcache_misses; });
+   for(size_t i = 0; i < std::min(order.size(), size_t(top)) && rows[order[i]].second.dcache_misses; ++i)
+      selected.insert(order[i]);
+
+   order.assign(selected.begin(), selected.end());
+   std::sort(order.begin(), order.end(), [&rows](size_t a, size_t b) { return rows[a].second.instructions > rows[b].second.instructions; });
+
+   fprintf(fp, "\n# %s\n", title);
+   fprintf(fp, "%14s %7s %14s %14s %14s %16s  %s\n", "instructions", "%", "dcache-misses", "dram-accesses", "icache-misses", "load-latency-ns", "location");
+   for(auto it = order.begin(); it != order.end(); ++it)
+   {
+      const Counters &c = rows[*it].second;
+      fprintf(fp, "%14" PRIu64 " %6.2f%% %14" PRIu64 " %14" PRIu64 " %14" PRIu64 " %16" PRIu64 "  %s\n",
+         c.instructions, total ? 100. * c.instructions / total : 0., c.dcache_misses, c.dram_accesses, c.icache_misses,
+         c.load_latency / 1000000, rows[*it].first.c_str());
+   }
+}
+
+void
+PcProfiler::writeProfile()
+{
+   ScopedLock sl(m_lock);
+
+   foldSpills();
+
+   // Merge the live tables with everything that was spilled so far
+   std::unordered_map<IntPtr, Counters> pcs(m_pc_merged);
+   for(auto it = m_pcs.begin(); it != m_pcs.end(); ++it)
+      if (it->counters.instructions)
+         pcs[it->eip].add(it->counters);
+
+   auto loops(m_loop_merged);
+   for(auto it = m_loops.begin(); it != m_loops.end(); ++it)
+   {
+      if (it->iterations)
+      {
+         auto key = std::make_pair(it->eip, it->size);
+         if (loops.count(key))
+         {
+            loops[key].iterations += it->iterations;
+            loops[key].counters.add(it->counters);
+         }
+         else
+            loops[key] = *it;
+      }
+   }
+
+   // Function profile from the call stack samples: self (top of stack) and inclusive (anywhere on the stack)
+   std::unordered_map<IntPtr, Counters> self, inclusive;
+   UInt64 sampled = 0;
+   for(auto it = m_stacks.begin(); it != m_stacks.end(); ++it)
+   {
+      self[it->first.back()].add(it->second);
+      std::set<IntPtr> seen(it->first.begin(), it->first.end());
+      for(auto jt = seen.begin(); jt != seen.end(); ++jt)
+         inclusive[*jt].add(it->second);
+      sampled += it->second.instructions;
+   }
+
+   String filename = Sim()->getConfig()->formatOutputFileName("sim.pcprofile." + itostr(m_core->getId()));
+   FILE *fp = fopen(filename.c_str(), "w");
+   LOG_ASSERT_ERROR(fp, "Cannot open %s", filename.c_str());
+
+   fprintf(fp, "# Core %d: %" PRIu64 " instructions, %" PRIu64 " table spills, %" PRIu64 " call stack samples\n", m_core->getId(), m_instructions, m_spills, m_stack_samples);
+
+   char buffer[1024];
+   Rows rows;
+
+   for(auto it = pcs.begin(); it != pcs.end(); ++it)
+   {
+      snprintf(buffer, sizeof(buffer), "%" PRIxPTR, it->first);
+      rows.push_back(std::make_pair(String(buffer), it->second));
+   }
+   writeRows(fp, "Instructions", rows, m_top, m_instructions);
+
+   rows.clear();
+   for(auto it = loops.begin(); it != loops.end(); ++it)
+   {
+      snprintf(buffer, sizeof(buffer), "%" PRIxPTR "..%" PRIxPTR " (%" PRIu64 " iterations)", it->second.eip, it->second.eip + it->second.size, it->second.iterations);
+      rows.push_back(std::make_pair(String(buffer), it->second.counters));
+   }
+   writeRows(fp, "Loops", rows, m_top, m_instructions);
+
+   if (m_stacks.size())
+   {
+      rows.clear();
+      for(auto it = self.begin(); it != self.end(); ++it)
+      {
+         snprintf(buffer, sizeof(buffer), "%" PRIxPTR " %s", it->first, routineName(it->first));
+         rows.push_back(std::make_pair(String(buffer), it->second));
+      }
+      writeRows(fp, "Functions, self (sampled)", rows, m_top, sampled);
+
+      rows.clear();
+      for(auto it = inclusive.begin(); it != inclusive.end(); ++it)
+      {
+         snprintf(buffer, sizeof(buffer), "%" PRIxPTR " %s", it->first, routineName(it->first));
+         rows.push_back(std::make_pair(String(buffer), it->second));
+      }
+      writeRows(fp, "Functions, inclusive (sampled)", rows, m_top, sampled);
+
+      rows.clear();
+      for(auto it = m_stacks.begin(); it != m_stacks.end(); ++it)
+      {
+         String stack;
+         for(auto jt = it->first.begin(); jt != it->first.end(); ++jt)
+         {
+            snprintf(buffer, sizeof(buffer), "%s%" PRIxPTR, jt == it->first.begin() ? "" : ":", *jt);
+            stack += buffer;
+         }
+         rows.push_back(std::make_pair(stack + " " + routineName(it->first.back()), it->second));
+      }
+      writeRows(fp, "Call stacks (sampled)", rows, m_top, sampled);
+   }
+
+   fclose(fp);
+}
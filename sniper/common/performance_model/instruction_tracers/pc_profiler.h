@@ -0,0 +1,101 @@
+#ifndef __PC_PROFILER_H
+#define __PC_PROFILER_H
+
+#include "instruction_tracer.h"
+#include "routine_tracer.h"
+#include "lock.h"
+
+#include <vector>
+#include <unordered_map>
+
+// Low-overhead profile of hot instructions, loops and call stacks, cheap enough to leave enabled.
+// While simulating, counts go into fixed-size direct-mapped tables: an entry that conflicts with
+// a new PC or loop is moved to a spill list as-is.  The call stack (as maintained by the routine
+// tracer) is only captured once every stack_sample_interval instructions, and gets attributed
+// everything that was counted since the previous sample.  Merging, sorting and symbol lookup
+// are done when statistics are written, results go to sim.pcprofile.<core>.
+
+class PcProfiler : public InstructionTracer
+{
+   private:
+      struct Counters
+      {
+         UInt64 instructions;
+         UInt64 dcache_misses;   // Memory accesses not serviced by the L1-D
+         UInt64 dram_accesses;   // Memory accesses serviced by (local or remote) DRAM
+         UInt64 icache_misses;
+         UInt64 load_latency;    // Sum of load issue-to-completion times in fs (ROB model only)
+
+         Counters() { clear(); }
+         void clear() { instructions = dcache_misses = dram_accesses = icache_misses = load_latency = 0; }
+         void add(const Counters &c)
+         {
+            instructions += c.instructions; dcache_misses += c.dcache_misses; dram_accesses += c.dram_accesses;
+            icache_misses += c.icache_misses; load_latency += c.load_latency;
+         }
+      };
+
+      struct PcEntry
+      {
+         IntPtr eip;
+         Counters counters;
+      };
+
+      struct LoopEntry
+      {
+         IntPtr eip;
+         UInt64 size;
+         UInt64 iterations;
+         Counters counters;
+      };
+
+      // Once the spill lists reach this size they are folded into the merged maps
+      static const size_t SPILL_MAX = 1 << 20;
+
+      const Core *m_core;
+      const UInt64 m_pc_mask;
+      const UInt64 m_loop_mask;
+      const UInt64 m_sample_interval;
+      const UInt32 m_top;
+
+      std::vector<PcEntry> m_pcs;
+      std::vector<LoopEntry> m_loops;
+
+      std::vector<PcEntry> m_pc_spill;
+      std::vector<LoopEntry> m_loop_spill;
+      std::unordered_map<IntPtr, Counters> m_pc_merged;
+      std::unordered_map<std::pair<IntPtr, UInt64>, LoopEntry, boost::hash<std::pair<IntPtr, UInt64> > > m_loop_merged;
+      std::unordered_map<CallStack, Counters> m_stacks;
+
+      // Entries the micro-ops of the current instruction are attributed to
+      Counters *m_pc_current;
+      Counters *m_loop_current;
+      IntPtr m_loop_begin, m_loop_end;
+      IntPtr m_eip_last;
+
+      Counters m_sample;
+      UInt64 m_sample_countdown;
+
+      UInt64 m_instructions;
+      UInt64 m_spills;
+      UInt64 m_stack_samples;
+
+      Lock m_lock;
+
+      void newInstruction(IntPtr eip);
+      void sampleCallStack();
+      void foldSpills();
+
+      typedef std::vector<std::pair<String, Counters> > Rows;
+      static void writeRows(FILE *fp, const char *title, Rows &rows, UInt32 top, UInt64 total);
+      void writeProfile();
+      static SInt64 hookPreStatWrite(UInt64 self, UInt64 prefix) { ((PcProfiler*)self)->writeProfile(); return 0; }
+
+   public:
+      PcProfiler(const Core *core);
+      virtual ~PcProfiler();
+
+      virtual void traceInstruction(const DynamicMicroOp *uop, uop_times_t *times);
+};
+
+#endif // __PC_PROFILER_H
@@ -89,6 +89,7 @@ PerformanceModel::PerformanceModel(Core *core)
    registerStatsMetric("performance_model", core->getId(), "cpiSyncDvfsTransition", &m_cpiSyncDvfsTransition);
 
    registerStatsMetric("performance_model", core->getId(), "cpiRecv", &m_cpiRecv);
+   m_dynins_alloc->registerStats("performance_model", core->getId(), "dynins");
 }
 
 PerformanceModel::~PerformanceModel()
@@ -200,6 +201,22 @@ void PerformanceModel::queueInstruction(DynamicInstruction *ins)
    #endif
 }
 
+void PerformanceModel::queueInstructions(DynamicInstruction* const* ins, UInt32 count)
+{
+   if (m_fastforward || !m_enabled)
+   {
+      for(UInt32 i = 0; i < count; ++i)
+         delete ins[i];
+      return;
+   }
+
+   #ifdef ENABLE_PERF_MODEL_OWN_THREAD
+      m_instruction_queue.push_wait(ins, count);
+   #else
+      m_instruction_queue.push(ins, count);
+   #endif
+}
+
 void PerformanceModel::handleIdleInstruction(PseudoInstruction *instruction)
 {
    // If fast-forwarding without detailed synchronization, our fast-forwarding IPC
@@ -301,16 +318,18 @@ void PerformanceModel::iterate()
          sched_yield();
       #endif
 
-      DynamicInstruction *ins = m_instruction_queue.front();
-
-      LOG_ASSERT_ERROR(!ins->instruction->isIdle(), "Idle instructions should not make it here!");
+      // Take a whole run of instructions off the queue at once
+      DynamicInstruction *batch[MAX_BATCH_SIZE];
+      UInt32 count = m_instruction_queue.pop(batch, MAX_BATCH_SIZE);
 
       if (!m_fastforward && m_enabled)
-         handleInstruction(ins);
+         handleInstructions(batch, count);
 
-      delete ins;
-
-      m_instruction_queue.pop();
+      for(UInt32 i = 0; i < count; ++i)
+      {
+         LOG_ASSERT_ERROR(!batch[i]->instruction->isIdle(), "Idle instructions should not make it here!");
+         delete batch[i];
+      }
    }
 
    synchronize();
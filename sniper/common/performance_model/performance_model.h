@@ -28,6 +28,8 @@ public:
    virtual ~PerformanceModel();
 
    void queueInstruction(DynamicInstruction *i);
+   // Queue a run of instructions, usually one basic block, with a single queue operation
+   void queueInstructions(DynamicInstruction* const* ins, UInt32 count);
    void queuePseudoInstruction(PseudoInstruction *i);
    void handleIdleInstruction(PseudoInstruction *i);
    void iterate();
@@ -83,6 +85,9 @@ public:
          disableDetailedModel();
    }
 
+   // Maximum number of instructions iterate() hands to the model at once
+   static const UInt32 MAX_BATCH_SIZE = 64;
+
 protected:
    friend class SpawnInstruction;
    friend class FastforwardPerformanceModel;
@@ -103,6 +108,12 @@ private:
 
    // Simulate a single instruction
    virtual void handleInstruction(DynamicInstruction *instruction) = 0;
+   // Simulate a run of instructions, models can override this to avoid a virtual call per instruction
+   virtual void handleInstructions(DynamicInstruction* const* instructions, UInt32 count)
+   {
+      for(UInt32 i = 0; i < count; ++i)
+         handleInstruction(instructions[i]);
+   }
 
    // When time is jumped ahead outside of control of the performance model (synchronization instructions, etc.)
    // notify it here. This may be used to synchronize internal time or to flush various instruction queues
@@ -37,6 +37,11 @@ class CoreModel
       virtual unsigned int getAluLatency(const MicroOp *uop) const = 0;
       virtual unsigned int getBypassLatency(const DynamicMicroOp *uop) const = 0;
       virtual unsigned int getLongestLatency() const = 0;
+
+      // Macro-fusion: can the (execute microOp of a) flag-setting instruction fuse with a following conditional branch at all,
+      // and can it fuse with this particular branch.  Cores that do not implement macro-fusion keep the default.
+      virtual bool isMacroFusionCandidate(const MicroOp *uop) const { return false; }
+      virtual bool canMacroFuse(const MicroOp *uop, const MicroOp *branch) const { return false; }
 };
 
 template <typename T> class BaseCoreModel : public CoreModel
@@ -190,3 +190,46 @@ DynamicMicroOp* CoreModelNehalem::createDynamicMicroOp(Allocator *alloc, const M
    info->uop_alu = DynamicMicroOpNehalem::getAlu(uop);
    return info;
 }
+
+bool CoreModelNehalem::isMacroFusionCandidate(const MicroOp *uop) const
+{
+   switch(uop->getInstructionOpcode())
+   {
+      case XED_ICLASS_CMP:
+      case XED_ICLASS_TEST:
+         // No fusion of compares between memory and an immediate
+         if (uop->intraInstructionDependencies > 0 && uop->getSourceRegistersLength() == 0)
+            return false;
+         return true;
+      default:
+         return false;
+   }
+}
+
+bool CoreModelNehalem::canMacroFuse(const MicroOp *uop, const MicroOp *branch) const
+{
+   switch(branch->getInstructionOpcode())
+   {
+      // TEST fuses with all conditional branches, CMP only with those looking at CF and/or ZF, SF and OF
+      case XED_ICLASS_JO:
+      case XED_ICLASS_JNO:
+      case XED_ICLASS_JS:
+      case XED_ICLASS_JNS:
+      case XED_ICLASS_JP:
+      case XED_ICLASS_JNP:
+         return uop->getInstructionOpcode() == XED_ICLASS_TEST;
+      case XED_ICLASS_JB:
+      case XED_ICLASS_JNB:
+      case XED_ICLASS_JZ:
+      case XED_ICLASS_JNZ:
+      case XED_ICLASS_JBE:
+      case XED_ICLASS_JNBE:
+      case XED_ICLASS_JL:
+      case XED_ICLASS_JNL:
+      case XED_ICLASS_JLE:
+      case XED_ICLASS_JNLE:
+         return true;
+      default:
+         return false;
+   }
+}
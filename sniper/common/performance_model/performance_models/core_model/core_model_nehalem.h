@@ -22,6 +22,9 @@ class CoreModelNehalem : public BaseCoreModel<DynamicMicroOpNehalem>
       virtual unsigned int getBypassLatency(const DynamicMicroOp *uop) const;
       virtual unsigned int getLongestLatency() const;
       virtual unsigned int getLongLatencyCutoff() const { return m_lll_cutoff; }
+
+      virtual bool isMacroFusionCandidate(const MicroOp *uop) const;
+      virtual bool canMacroFuse(const MicroOp *uop, const MicroOp *branch) const;
 };
 
 #endif // __CORE_MODEL_NEHALEM
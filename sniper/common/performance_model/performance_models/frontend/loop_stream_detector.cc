@@ -0,0 +1,71 @@
+#include "loop_stream_detector.h"
+#include "stats.h"
+
+LoopStreamDetector::LoopStreamDetector(core_id_t core_id, UInt32 size)
+   : m_size(size)
+   , m_instructions(0)
+   , m_loops(0)
+{
+   reset();
+
+   registerStatsMetric("lsd", core_id, "instructions", &m_instructions);
+   registerStatsMetric("lsd", core_id, "loops", &m_loops);
+}
+
+void
+LoopStreamDetector::reset()
+{
+   m_loop_start = 0;
+   m_loop_branch = 0;
+   m_loop_uops = 0;
+   m_iterations = 0;
+   m_streaming = false;
+}
+
+bool
+LoopStreamDetector::access(IntPtr eip, UInt32 num_uops, bool is_branch, bool taken, IntPtr target, bool mispredicted)
+{
+   // The instruction that locks in the loop still comes from the decoders, everything after it is streamed
+   bool streamed = m_streaming;
+   if (streamed)
+      ++m_instructions;
+
+   m_loop_uops += num_uops;
+
+   if (is_branch && taken)
+   {
+      if (eip == m_loop_branch && target == m_loop_start && m_loop_uops <= m_size)
+      {
+         // Another iteration of the same loop
+         if (++m_iterations == LOCK_ITERATIONS)
+         {
+            m_streaming = true;
+            ++m_loops;
+         }
+      }
+      else if (target <= eip)
+      {
+         // Backward branch: candidate for a new loop
+         reset();
+         m_loop_start = target;
+         m_loop_branch = eip;
+      }
+      else
+      {
+         // Forward branch leaving the loop body
+         reset();
+      }
+      m_loop_uops = 0;
+   }
+   else if (is_branch && eip == m_loop_branch)
+   {
+      // Loop exit
+      reset();
+   }
+
+   // Recovering from a misprediction starts over from the decoders
+   if (mispredicted)
+      reset();
+
+   return streamed;
+}
@@ -0,0 +1,37 @@
+#ifndef __LOOP_STREAM_DETECTOR_H
+#define __LOOP_STREAM_DETECTOR_H
+
+#include "fixed_types.h"
+
+// Loop stream detector: a loop of at most <size> micro-ops, closed by a taken backward branch, that has been
+// seen iterating twice in a row is locked in, after which its micro-ops are streamed from the LSD without
+// fetching or decoding.  Streaming stops when the loop branch is not taken, when any other branch
+// is taken, or on a branch misprediction.
+
+class LoopStreamDetector
+{
+   private:
+      // Back-to-back iterations with the same branch and target before the loop is locked in
+      static const UInt32 LOCK_ITERATIONS = 2;
+
+      const UInt32 m_size;
+
+      IntPtr m_loop_start;
+      IntPtr m_loop_branch;
+      UInt32 m_loop_uops;      // Micro-ops seen since entering the current iteration
+      UInt32 m_iterations;
+      bool m_streaming;
+
+      UInt64 m_instructions;
+      UInt64 m_loops;
+
+      void reset();
+
+   public:
+      LoopStreamDetector(core_id_t core_id, UInt32 size);
+
+      // Called for every instruction in program order, returns true when it was delivered by the LSD
+      bool access(IntPtr eip, UInt32 num_uops, bool is_branch, bool taken, IntPtr target, bool mispredicted);
+};
+
+#endif // __LOOP_STREAM_DETECTOR_H
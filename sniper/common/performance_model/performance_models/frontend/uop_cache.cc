@@ -0,0 +1,49 @@
+#include "uop_cache.h"
+#include "stats.h"
+#include "log.h"
+#include "utils.h"
+
+UopCache::UopCache(core_id_t core_id, UInt32 num_sets, UInt32 associativity, UInt32 window_size)
+   : m_num_sets(num_sets)
+   , m_associativity(associativity)
+   , m_window_shift(floorLog2(window_size))
+   , m_tags(num_sets * associativity, IntPtr(-1))
+   , m_last_window(IntPtr(-1))
+   , m_last_hit(false)
+   , m_hits(0)
+   , m_misses(0)
+{
+   LOG_ASSERT_ERROR(isPower2(window_size), "uop_cache/window_size must be a power of two");
+   LOG_ASSERT_ERROR(associativity > 0, "uop_cache/associativity must be larger than zero");
+
+   registerStatsMetric("uop_cache", core_id, "hits", &m_hits);
+   registerStatsMetric("uop_cache", core_id, "misses", &m_misses);
+}
+
+bool
+UopCache::access(IntPtr eip)
+{
+   IntPtr window = eip >> m_window_shift;
+
+   if (window != m_last_window)
+   {
+      m_last_window = window;
+
+      IntPtr *set = &m_tags[(window % m_num_sets) * m_associativity];
+      UInt32 way = 0;
+      while(way < m_associativity - 1 && set[way] != window)
+         ++way;
+      m_last_hit = set[way] == window;
+
+      // Move to the MRU position, on a miss this evicts the LRU way
+      for( ; way > 0; --way)
+         set[way] = set[way - 1];
+      set[0] = window;
+   }
+
+   if (m_last_hit)
+      ++m_hits;
+   else
+      ++m_misses;
+   return m_last_hit;
+}
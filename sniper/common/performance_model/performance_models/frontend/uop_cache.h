@@ -0,0 +1,37 @@
+#ifndef __UOP_CACHE_H
+#define __UOP_CACHE_H
+
+#include "fixed_types.h"
+
+#include <vector>
+
+// Decoded micro-op cache: holds the micro-ops of aligned code windows (32 bytes on Sandy Bridge and later),
+// set-associative with LRU replacement.  Only presence of a window is modeled, not how many micro-ops it holds.
+// Instructions that hit are delivered without going through the legacy decoders, a missing window is filled
+// once it has been decoded.
+
+class UopCache
+{
+   private:
+      const UInt32 m_num_sets;
+      const UInt32 m_associativity;
+      const UInt32 m_window_shift;
+
+      // m_num_sets x m_associativity tags, most recently used first
+      std::vector<IntPtr> m_tags;
+
+      // Consecutive instructions from the same window share a single lookup
+      IntPtr m_last_window;
+      bool m_last_hit;
+
+      UInt64 m_hits;
+      UInt64 m_misses;
+
+   public:
+      UopCache(core_id_t core_id, UInt32 num_sets, UInt32 associativity, UInt32 window_size);
+
+      // Returns true when the instruction at eip is delivered from the uop cache
+      bool access(IntPtr eip);
+};
+
+#endif // __UOP_CACHE_H
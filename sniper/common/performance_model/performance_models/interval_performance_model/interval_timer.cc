@@ -224,6 +224,7 @@ boost::tuple<uint64_t,uint64_t> IntervalTimer::simulate(const std::vector<Dynami
 
 boost::tuple<uint64_t, uint64_t> IntervalTimer::dispatchWindow() {
    uint64_t instructions_executed = 0;
+   uint64_t instructions_fused = 0;
    uint64_t latency = 0;
    uint64_t micro_ops_executed = 0;
 
@@ -247,6 +248,8 @@ boost::tuple<uint64_t, uint64_t> IntervalTimer::dispatchWindow() {
       if (micro_op.getDynMicroOp()->isLast())
       {
          instructions_executed++;
+         // A macro-fused pair takes a single dispatch slot, but completes two instructions
+         instructions_fused += micro_op.getDynMicroOp()->getNumRetiredInstructions() - 1;
       }
 
       m_core->getPerformanceModel()->traceInstruction(micro_op.getDynMicroOp(), NULL);
@@ -304,7 +307,7 @@ boost::tuple<uint64_t, uint64_t> IntervalTimer::dispatchWindow() {
       m_cpiBaseStopDispatch[continue_dispatching] += 1;
    }
 
-   return boost::tuple<uint64_t,uint64_t>(instructions_executed, latency);
+   return boost::tuple<uint64_t,uint64_t>(instructions_executed + instructions_fused, latency);
 }
 
 uint32_t IntervalTimer::calculateCurrentDispatchRate() {
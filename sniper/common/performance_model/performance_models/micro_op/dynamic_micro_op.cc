@@ -29,6 +29,8 @@ DynamicMicroOp::DynamicMicroOp(const MicroOp *uop, const CoreModel *core_model,
 
    this->m_forceLongLatencyLoad = false;
 
+   this->m_legacyDecoded = true;
+
    for(uint32_t i = 0 ; i < MAXIMUM_NUMBER_OF_DEPENDENCIES; i++)
       this->dependencies[i] = -1;
 
@@ -56,6 +56,9 @@ class DynamicMicroOp
 
       bool m_forceLongLatencyLoad;
 
+      /** Delivered by the legacy decoders, rather than from the uop cache or loop stream detector */
+      bool m_legacyDecoded;
+
       /** These first/last flags are needed in case of squashing, as long as squashed uop doesn't go to rob
           and we can't use first/last flags of m_uop in such a cases.*/
       /** This microOp is the first microOp of the instruction. */
@@ -111,6 +114,9 @@ class DynamicMicroOp
       void setLast(bool _last) { last = _last; }
       bool isLast() const { return last; }
 
+      /** Number of instructions that complete when this microOp commits: a macro-fused pair counts as two */
+      uint32_t getNumRetiredInstructions() const { return last ? (m_uop->isMacroFused() ? 2 : 1) : 0; }
+
       bool isBranchTaken() const { LOG_ASSERT_ERROR(m_uop->isBranch(), "Expected a branch instruction."); return this->branchTaken; }
       void setBranchTaken(bool _branch_taken) { LOG_ASSERT_ERROR(m_uop->isBranch(), "Expected a branch instruction."); branchTaken = _branch_taken; }
       bool isBranchMispredicted() const { LOG_ASSERT_ERROR(m_uop->isBranch(), "Expected a branch instruction."); return this->branchMispredicted; }
@@ -137,6 +143,9 @@ class DynamicMicroOp
       uint32_t getICacheLatency() const { return iCacheLatency; }
       void setICacheLatency(uint32_t _latency) { iCacheLatency = _latency; };
 
+      bool isLegacyDecoded() const { return m_legacyDecoded; }
+      void setLegacyDecoded(bool legacyDecoded) { m_legacyDecoded = legacyDecoded; }
+
 
       void setAddress(const Memory::Access& loadAccess) { this->address = loadAccess; }
       const Memory::Access& getAddress(void) const { return this->address; }
@@ -10,30 +10,30 @@ extern "C" {
 }
 
 
-void InstructionDecoder::addSrcs(std::set<xed_reg_enum_t> regs, MicroOp * currentMicroOp) {
-   for(std::set<xed_reg_enum_t>::iterator it = regs.begin(); it != regs.end(); ++it)
+void InstructionDecoder::addSrcs(const std::set<xed_reg_enum_t> &regs, MicroOp * currentMicroOp) {
+   for(std::set<xed_reg_enum_t>::const_iterator it = regs.begin(); it != regs.end(); ++it)
       if (*it != XED_REG_INVALID) {
          xed_reg_enum_t reg = xed_get_largest_enclosing_register(*it);
          if (reg == XED_REG_EIP || reg == XED_REG_RIP) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addSourceRegister(reg, String(xed_reg_enum_t2str(reg)));
+         currentMicroOp->addSourceRegister(reg);
       }
 }
 
-void InstructionDecoder::addAddrs(std::set<xed_reg_enum_t> regs, MicroOp * currentMicroOp) {
-   for(std::set<xed_reg_enum_t>::iterator it = regs.begin(); it != regs.end(); ++it)
+void InstructionDecoder::addAddrs(const std::set<xed_reg_enum_t> &regs, MicroOp * currentMicroOp) {
+   for(std::set<xed_reg_enum_t>::const_iterator it = regs.begin(); it != regs.end(); ++it)
       if (*it != XED_REG_INVALID) {
          xed_reg_enum_t reg = xed_get_largest_enclosing_register(*it);
          if (reg == XED_REG_EIP || reg == XED_REG_RIP) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addAddressRegister(reg, String(xed_reg_enum_t2str(reg)));
+         currentMicroOp->addAddressRegister(reg);
       }
 }
 
-void InstructionDecoder::addDsts(std::set<xed_reg_enum_t> regs, MicroOp * currentMicroOp) {
-   for(std::set<xed_reg_enum_t>::iterator it = regs.begin(); it != regs.end(); ++it)
+void InstructionDecoder::addDsts(const std::set<xed_reg_enum_t> &regs, MicroOp * currentMicroOp) {
+   for(std::set<xed_reg_enum_t>::const_iterator it = regs.begin(); it != regs.end(); ++it)
       if (*it != XED_REG_INVALID) {
          xed_reg_enum_t reg = xed_get_largest_enclosing_register(*it);
          if (reg == XED_REG_EIP || reg == XED_REG_RIP) continue; // eip/rip is known at decode time, shouldn't be a dependency
-         currentMicroOp->addDestinationRegister(reg, String(xed_reg_enum_t2str(reg)));
+         currentMicroOp->addDestinationRegister(reg);
       }
 }
 
@@ -294,6 +294,10 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address, co
          addSrcs(regs_src, currentMicroOp);
          addDsts(regs_dst, currentMicroOp);
 
+         // Load-op instructions: the load and execute microops can be dispatched as one (micro-fusion)
+         if (numLoads == 1)
+            currentMicroOp->setMicroFused(true);
+
          if (xed_decoded_inst_get_iclass(ins) == XED_ICLASS_MFENCE
             || xed_decoded_inst_get_iclass(ins) == XED_ICLASS_LFENCE
             || xed_decoded_inst_get_iclass(ins) == XED_ICLASS_SFENCE
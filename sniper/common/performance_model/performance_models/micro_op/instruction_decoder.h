@@ -15,9 +15,9 @@ class MicroOp;
 
 class InstructionDecoder {
 private:
-   static void addSrcs(std::set<xed_reg_enum_t> regs, MicroOp *uop);
-   static void addAddrs(std::set<xed_reg_enum_t> regs, MicroOp *uop);
-   static void addDsts(std::set<xed_reg_enum_t> regs, MicroOp *uop);
+   static void addSrcs(const std::set<xed_reg_enum_t> &regs, MicroOp *uop);
+   static void addAddrs(const std::set<xed_reg_enum_t> &regs, MicroOp *uop);
+   static void addDsts(const std::set<xed_reg_enum_t> &regs, MicroOp *uop);
    static unsigned int getNumExecs(const xed_decoded_inst_t *ins, int numLoads, int numStores);
 public:
    static const std::vector<const MicroOp*>* decode(IntPtr address, const xed_decoded_inst_t *ins, Instruction *ins_ptr);
@@ -46,6 +46,9 @@ MicroOp::MicroOp()
 
    this->branch = false;
 
+   this->micro_fused = false;
+   this->macro_fused = false;
+
    this->m_membar = false;
    this->is_x87 = false;
    this->operand_size = 0;
@@ -119,6 +122,25 @@ void MicroOp::makeDynamic(const String& instructionOpcodeName, uint32_t execLate
    this->setTypes();
 }
 
+void MicroOp::makeMacroFused(const MicroOp& branch) {
+   // Called on a copy of the execute microOp of a flag-setting instruction,
+   // which then also takes over the conditional branch that follows it
+   this->branch = true;
+   this->macro_fused = true;
+   this->last = true;
+   for(uint32_t i = 0; i < branch.getSourceRegistersLength(); ++i)
+   {
+      xed_reg_enum_t reg = branch.getSourceRegister(i);
+      bool produced = false;
+      for(uint32_t j = 0; j < this->getDestinationRegistersLength(); ++j)
+         if (this->getDestinationRegister(j) == reg)
+            produced = true;
+      if (!produced)
+         this->addSourceRegister(reg);
+   }
+   this->setTypes();
+}
+
 
 MicroOp::uop_subtype_t MicroOp::getSubtype_Exec(const MicroOp& uop)
 {
@@ -354,13 +376,13 @@ const String& MicroOp::getSourceRegisterName(uint32_t index) const {
 }
 #endif
 
-void MicroOp::addSourceRegister(xed_reg_enum_t registerId, const String& registerName) {
+void MicroOp::addSourceRegister(xed_reg_enum_t registerId) {
    VERIFY_MICROOP();
    assert(sourceRegistersLength < MAXIMUM_NUMBER_OF_SOURCE_REGISTERS);
 // assert(registerId >= 0 && registerId < TOTAL_NUM_REGISTERS);
    sourceRegisters[sourceRegistersLength] = registerId;
 #ifdef ENABLE_MICROOP_STRINGS
-   sourceRegisterNames[sourceRegistersLength] = registerName;
+   sourceRegisterNames[sourceRegistersLength] = xed_reg_enum_t2str(registerId);
 #endif
    sourceRegistersLength++;
 }
@@ -384,13 +406,13 @@ const String& MicroOp::getAddressRegisterName(uint32_t index) const {
 }
 #endif
 
-void MicroOp::addAddressRegister(xed_reg_enum_t registerId, const String& registerName) {
+void MicroOp::addAddressRegister(xed_reg_enum_t registerId) {
    VERIFY_MICROOP();
    assert(addressRegistersLength < MAXIMUM_NUMBER_OF_ADDRESS_REGISTERS);
 // assert(registerId >= 0 && registerId < TOTAL_NUM_REGISTERS);
    addressRegisters[addressRegistersLength] = registerId;
 #ifdef ENABLE_MICROOP_STRINGS
-   addressRegisterNames[addressRegistersLength] = registerName;
+   addressRegisterNames[addressRegistersLength] = xed_reg_enum_t2str(registerId);
 #endif
    addressRegistersLength++;
 }
@@ -414,13 +436,13 @@ const String& MicroOp::getDestinationRegisterName(uint32_t index) const {
 }
 #endif
 
-void MicroOp::addDestinationRegister(xed_reg_enum_t registerId, const String& registerName) {
+void MicroOp::addDestinationRegister(xed_reg_enum_t registerId) {
    VERIFY_MICROOP();
    assert(destinationRegistersLength < MAXIMUM_NUMBER_OF_DESTINATION_REGISTERS);
 // assert(registerId >= 0 && registerId < TOTAL_NUM_REGISTERS);
    destinationRegisters[destinationRegistersLength] = registerId;
 #ifdef ENABLE_MICROOP_STRINGS
-   destinationRegisterNames[destinationRegistersLength] = registerName;
+   destinationRegisterNames[destinationRegistersLength] = xed_reg_enum_t2str(registerId);
 #endif
    destinationRegistersLength++;
 }
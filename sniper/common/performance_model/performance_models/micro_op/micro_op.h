@@ -119,6 +119,11 @@ struct MicroOp
    /** Is this instruction a branch ? */
    bool branch;
 
+   /** Is this the execute microOp of a load-op instruction, which can share its dispatch slot with the load (micro-fusion) ? */
+   bool micro_fused;
+   /** Does this microOp combine a flag-setting instruction with the conditional branch that follows it (macro-fusion) ? */
+   bool macro_fused;
+
    /** Debug info about the microOperation. */
 #ifdef ENABLE_MICROOP_STRINGS
    String debugInfo;
@@ -133,6 +138,7 @@ struct MicroOp
    void makeExecute(uint32_t offset, uint32_t num_loads, xed_iclass_enum_t instructionOpcode, const String& instructionOpcodeName, bool isBranch);
    void makeStore(uint32_t offset, uint32_t num_execute, xed_iclass_enum_t instructionOpcode, const String& instructionOpcodeName, uint16_t mem_size);
    void makeDynamic(const String& instructionOpcodeName, uint32_t execLatency);
+   void makeMacroFused(const MicroOp& branch);
 
    static uop_subtype_t getSubtype_Exec(const MicroOp& uop);
    static uop_subtype_t getSubtype(const MicroOp& uop);
@@ -163,15 +169,15 @@ struct MicroOp
 
    uint32_t getSourceRegistersLength() const;
    xed_reg_enum_t getSourceRegister(uint32_t index) const;
-   void addSourceRegister(xed_reg_enum_t registerId, const String& registerName);
+   void addSourceRegister(xed_reg_enum_t registerId);
 
    uint32_t getAddressRegistersLength() const;
    xed_reg_enum_t getAddressRegister(uint32_t index) const;
-   void addAddressRegister(xed_reg_enum_t registerId, const String& registerName);
+   void addAddressRegister(xed_reg_enum_t registerId);
 
    uint32_t getDestinationRegistersLength() const;
    xed_reg_enum_t getDestinationRegister(uint32_t index) const;
-   void addDestinationRegister(xed_reg_enum_t registerId, const String& registerName);
+   void addDestinationRegister(xed_reg_enum_t registerId);
 
 #ifdef ENABLE_MICROOP_STRINGS
    const String& getSourceRegisterName(uint32_t index) const;
@@ -184,6 +190,10 @@ struct MicroOp
 
    bool isBranch() const { return this->branch; }
 
+   bool isMicroFused() const { return this->micro_fused; }
+   void setMicroFused(bool micro_fused) { this->micro_fused = micro_fused; }
+   bool isMacroFused() const { return this->macro_fused; }
+
    bool isInterrupt() const { return this->interrupt; }
    void setInterrupt(bool interrupt) { this->interrupt = interrupt; }
 
@@ -11,6 +11,8 @@
 #include "allocator.h"
 #include "config.hpp"
 #include "dynamic_instruction.h"
+#include "uop_cache.h"
+#include "loop_stream_detector.h"
 
 #include <cstdio>
 #include <algorithm>
@@ -24,6 +26,11 @@ MicroOpPerformanceModel::MicroOpPerformanceModel(Core *core, bool issue_memops)
     , m_core_model(CoreModel::getCoreModel(Sim()->getCfg()->getStringArray("perf_model/core/core_model", core->getId())))
     , m_allocator(m_core_model->createDMOAllocator())
     , m_issue_memops(issue_memops)
+    , m_macro_fusion(Sim()->getCfg()->getBoolArray("perf_model/core/frontend/macro_fusion", core->getId()))
+    , m_fusion_next_eip(0)
+    , m_macro_fused(0)
+    , m_uop_cache(NULL)
+    , m_lsd(NULL)
     , m_dyninsn_count(0)
     , m_dyninsn_cost(0)
     , m_dyninsn_zero_count(0)
@@ -31,6 +38,17 @@ MicroOpPerformanceModel::MicroOpPerformanceModel(Core *core, bool issue_memops)
    registerStatsMetric("performance_model", core->getId(), "dyninsn_count", &m_dyninsn_count);
    registerStatsMetric("performance_model", core->getId(), "dyninsn_cost", &m_dyninsn_cost);
    registerStatsMetric("performance_model", core->getId(), "dyninsn_zero_count", &m_dyninsn_zero_count);
+   m_allocator->registerStats("performance_model", core->getId(), "dmo");
+   registerStatsMetric("performance_model", core->getId(), "macro_fused", &m_macro_fused);
+
+   UInt32 uop_cache_sets = Sim()->getCfg()->getIntArray("perf_model/core/frontend/uop_cache/sets", core->getId());
+   if (uop_cache_sets)
+      m_uop_cache = new UopCache(core->getId(), uop_cache_sets,
+                                 Sim()->getCfg()->getIntArray("perf_model/core/frontend/uop_cache/associativity", core->getId()),
+                                 Sim()->getCfg()->getIntArray("perf_model/core/frontend/uop_cache/window_size", core->getId()));
+   UInt32 lsd_size = Sim()->getCfg()->getIntArray("perf_model/core/frontend/lsd/size", core->getId());
+   if (lsd_size)
+      m_lsd = new LoopStreamDetector(core->getId(), lsd_size);
 #if DEBUG_DYN_INSN_LOG
    String filename;
    filename = "sim.dyninsn_log." + itostr(core->getId());
@@ -103,7 +121,13 @@ MicroOpPerformanceModel::~MicroOpPerformanceModel()
 #if DEBUG_CYCLE_COUNT_LOG
    std::fclose(m_cycle_log);
 #endif
+   if (m_uop_cache)
+      delete m_uop_cache;
+   if (m_lsd)
+      delete m_lsd;
    delete m_allocator;
+   for(std::unordered_map<MicroOpPair, MicroOp*, boost::hash<MicroOpPair> >::iterator it = m_fused_uops.begin(); it != m_fused_uops.end(); ++it)
+      delete it->second;
 }
 
 void MicroOpPerformanceModel::doSquashing(std::vector<DynamicMicroOp*> &current_uops, uint32_t first_squashed)
@@ -337,10 +361,10 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
    assert(num_writes_done == num_stores);
 
    SubsecondTime insn_cost = SubsecondTime::Zero();
+   bool is_mispredict = false;
 
    if (dynins->instruction->getType() == INST_BRANCH)
    {
-      bool is_mispredict;
       dynins->getBranchCost(getCore(), &is_mispredict);
 
       // Set whether the branch was mispredicted or not
@@ -377,6 +401,27 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
    #endif
    }
 
+   // Find out where the front end delivers this instruction's micro-ops from
+   if ((m_lsd || m_uop_cache) && m_current_uops.size() > 0)
+   {
+      bool is_branch = dynins->instruction->getType() == INST_BRANCH;
+      bool streamed = m_lsd && m_lsd->access(dynins->eip, m_current_uops.size(), is_branch, is_branch && dynins->branch_info.taken, dynins->branch_info.target, is_mispredict);
+      bool cached = !streamed && m_uop_cache && m_uop_cache->access(dynins->eip);
+      if (streamed || cached)
+         for(size_t m = 0; m < m_current_uops.size(); ++m)
+            m_current_uops[m]->setLegacyDecoded(false);
+   }
+
+   // Macro-fusion: a held back flag-setting instruction either fuses with this one, or goes into the timing model by itself
+   if (m_fusion_pending.size() && !macroFuse(dynins, insn_period))
+      flushFusionPending();
+   if (m_macro_fusion && m_fusion_pending.empty() && isMacroFusionCandidate(num_loads, num_stores, exec_base_index))
+   {
+      m_fusion_pending.swap(m_current_uops);
+      m_fusion_next_eip = dynins->eip + dynins->instruction->getSize();
+      return;
+   }
+
    // Insert an instruction into the interval model to indicate that time has passed
    uint32_t new_num_insns = 0;
    ComponentTime new_latency(m_elapsed_time.getLatencyGenerator()); // Get a new, empty holder for latency
@@ -565,3 +610,77 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
    fprintf(m_cycle_log, "[%s] latency=%d\n", itostr(m_elapsed_time).c_str(), itostr(new_latency.getElapsedTime()).c_str());
 #endif
 }
+
+bool MicroOpPerformanceModel::isMacroFusionCandidate(size_t num_loads, size_t num_stores, size_t exec_base_index) const
+{
+   // A single execute micro-op, optionally preceded by one load
+   return num_stores == 0 && num_loads <= 1
+      && exec_base_index != SIZE_MAX && exec_base_index == m_current_uops.size() - 1
+      && m_core_model->isMacroFusionCandidate(m_current_uops[exec_base_index]->getMicroOp());
+}
+
+bool MicroOpPerformanceModel::macroFuse(DynamicInstruction *dynins, ComponentPeriod period)
+{
+   if (m_current_uops.size() != 1 || dynins->eip != m_fusion_next_eip)
+      return false;
+
+   DynamicMicroOp *uop = m_fusion_pending.back();
+   DynamicMicroOp *branch = m_current_uops[0];
+   if (!branch->getMicroOp()->isBranch() || !m_core_model->canMacroFuse(uop->getMicroOp(), branch->getMicroOp()))
+      return false;
+
+   DynamicMicroOp *fused = m_core_model->createDynamicMicroOp(m_allocator, getMacroFusedMicroOp(uop->getMicroOp(), branch->getMicroOp()), period);
+   fused->setFirst(uop->isFirst());
+   fused->setLegacyDecoded(uop->isLegacyDecoded());
+   fused->setBranchMispredicted(branch->isBranchMispredicted());
+   fused->setBranchTaken(branch->isBranchTaken());
+   fused->setBranchTarget(branch->getBranchTarget());
+
+   // The I-cache access is charged to the first micro-op of the pair, keep the slowest of both instructions' fetches
+   DynamicMicroOp *fetch = uop->isFirst() ? uop : m_fusion_pending[0];
+   if (branch->getICacheLatency() > fetch->getICacheLatency())
+   {
+      fetch->setICacheHitWhere(branch->getICacheHitWhere());
+      fetch->setICacheLatency(branch->getICacheLatency());
+   }
+   if (uop->isFirst())
+   {
+      fused->setICacheHitWhere(uop->getICacheHitWhere());
+      fused->setICacheLatency(uop->getICacheLatency());
+   }
+
+   delete uop;
+   delete branch;
+   m_fusion_pending.back() = fused;
+   m_current_uops.swap(m_fusion_pending);
+   m_fusion_pending.clear();
+
+   ++m_macro_fused;
+   return true;
+}
+
+void MicroOpPerformanceModel::flushFusionPending()
+{
+   uint32_t new_num_insns;
+   uint64_t new_latency_cycles;
+   boost::tie(new_num_insns, new_latency_cycles) = simulate(m_fusion_pending);
+   m_fusion_pending.clear();
+
+   ComponentTime new_latency(m_elapsed_time.getLatencyGenerator());
+   new_latency.addCycleLatency(new_latency_cycles);
+   m_instruction_count += new_num_insns;
+   m_elapsed_time.addLatency(new_latency);
+}
+
+const MicroOp* MicroOpPerformanceModel::getMacroFusedMicroOp(const MicroOp *uop, const MicroOp *branch)
+{
+   MicroOpPair key(uop, branch);
+   std::unordered_map<MicroOpPair, MicroOp*, boost::hash<MicroOpPair> >::iterator it = m_fused_uops.find(key);
+   if (it != m_fused_uops.end())
+      return it->second;
+
+   MicroOp *fused = new MicroOp(*uop);
+   fused->makeMacroFused(*branch);
+   m_fused_uops[key] = fused;
+   return fused;
+}
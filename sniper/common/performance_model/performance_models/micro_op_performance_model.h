@@ -8,12 +8,17 @@
 #include "subsecond_time.h"
 #include "dynamic_micro_op.h"
 
+#include <unordered_map>
+#include <boost/functional/hash.hpp>
+
 #define DEBUG_INSN_LOG 0
 #define DEBUG_DYN_INSN_LOG 0
 #define DEBUG_CYCLE_COUNT_LOG 0
 
 class CoreModel;
 class Allocator;
+class UopCache;
+class LoopStreamDetector;
 
 class MicroOpPerformanceModel : public PerformanceModel
 {
@@ -30,6 +35,19 @@ protected:
 
 private:
    void handleInstruction(DynamicInstruction *instruction);
+   void handleInstructions(DynamicInstruction* const* instructions, UInt32 count)
+   {
+      for(UInt32 i = 0; i < count; ++i)
+         MicroOpPerformanceModel::handleInstruction(instructions[i]);
+      // Do not hold on to micro-ops beyond the end of a batch
+      if (m_fusion_pending.size())
+         flushFusionPending();
+   }
+
+   bool isMacroFusionCandidate(size_t num_loads, size_t num_stores, size_t exec_base_index) const;
+   bool macroFuse(DynamicInstruction *dynins, ComponentPeriod period);
+   void flushFusionPending();
+   const MicroOp* getMacroFusedMicroOp(const MicroOp *uop, const MicroOp *branch);
 
    static MicroOp* m_serialize_uop;
    static MicroOp* m_mfence_uop;
@@ -45,6 +63,19 @@ private:
    std::vector<IntPtr> m_cache_lines_read;
    std::vector<IntPtr> m_cache_lines_written;
 
+   // Macro-fusion: the micro-ops of a flag-setting instruction are held back
+   // until we know whether it is followed by a conditional branch it can fuse with
+   const bool m_macro_fusion;
+   std::vector<DynamicMicroOp*> m_fusion_pending;
+   IntPtr m_fusion_next_eip;
+   typedef std::pair<const MicroOp*, const MicroOp*> MicroOpPair;
+   std::unordered_map<MicroOpPair, MicroOp*, boost::hash<MicroOpPair> > m_fused_uops;
+   UInt64 m_macro_fused;
+
+   // Front-end structures that deliver micro-ops without going through the legacy decoders (NULL when disabled)
+   UopCache *m_uop_cache;
+   LoopStreamDetector *m_lsd;
+
    UInt64 m_dyninsn_count;
    UInt64 m_dyninsn_cost;
    UInt64 m_dyninsn_zero_count;
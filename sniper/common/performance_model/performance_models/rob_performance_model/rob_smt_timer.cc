@@ -1070,8 +1070,7 @@ SubsecondTime RobSmtTimer::doCommit()
          };
          thread->core->getPerformanceModel()->traceInstruction(entry->uop, &times);
 
-         if (entry->uop->isLast())
-            thread->instrs++;
+         thread->instrs += entry->uop->getNumRetiredInstructions();
 
          entry->free();
          thread->rob.pop();
@@ -37,8 +37,12 @@ RobTimer::RobTimer(
       , m_store_to_load_forwarding(Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/store_to_load_forwarding", core->getId()))
       , m_no_address_disambiguation(!Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/address_disambiguation", core->getId()))
       , inorder(Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/in_order", core->getId()))
+      , m_decode_width(Sim()->getCfg()->getIntArray("perf_model/core/frontend/decode_width", core->getId()))
+      , m_micro_fusion(Sim()->getCfg()->getBoolArray("perf_model/core/frontend/micro_fusion", core->getId()))
       , m_core(core)
       , rob(window_size + 255)
+      , m_dependant_links((window_size + 255) * MAXIMUM_NUMBER_OF_DEPENDENCIES)
+      , m_free_dependant_link(0)
       , m_num_in_rob(0)
       , m_rs_entries_used(0)
       , m_rob_contention(
@@ -60,6 +64,8 @@ RobTimer::RobTimer(
       , m_cpiCurrentFrontEndStall(NULL)
       , m_mlp_histogram(Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/mlp_histogram", core->getId()))
 {
+   for(UInt32 i = 0; i < m_dependant_links.size(); ++i)
+      m_dependant_links[i].next = i + 1 < m_dependant_links.size() ? i + 1 : NO_LINK;
 
    registerStatsMetric("rob_timer", core->getId(), "time_skipped", &time_skipped);
 
@@ -191,52 +197,41 @@ void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
    uop = _uop;
    uop->setSequenceNumber(sequenceNumber);
 
-   addressProducers.clear();
+   numAddressProducers = 0;
 
-   numInlineDependants = 0;
-   vectorDependants = NULL;
+   firstDependant = NO_LINK;
+   lastDependant = NO_LINK;
 }
 
 void RobTimer::RobEntry::free()
 {
    delete uop;
-   if (vectorDependants)
-      delete vectorDependants;
 }
 
-void RobTimer::RobEntry::addDependant(RobTimer::RobEntry* dep)
+void RobTimer::addDependant(RobEntry *producer, RobEntry *dependant)
 {
-   if (numInlineDependants < MAX_INLINE_DEPENDANTS)
-   {
-      inlineDependants[numInlineDependants++] = dep;
-   }
+   UInt32 link = m_free_dependant_link;
+   LOG_ASSERT_ERROR(link != NO_LINK, "Dependant link pool exhausted");
+   m_free_dependant_link = m_dependant_links[link].next;
+
+   m_dependant_links[link].sequenceNumber = dependant->uop->getSequenceNumber();
+   m_dependant_links[link].next = NO_LINK;
+   if (producer->firstDependant == NO_LINK)
+      producer->firstDependant = link;
    else
-   {
-      if (vectorDependants == NULL)
-      {
-         vectorDependants = new std::vector<RobEntry*>();
-      }
-      vectorDependants->push_back(dep);
-   }
+      m_dependant_links[producer->lastDependant].next = link;
+   producer->lastDependant = link;
 }
 
-uint64_t RobTimer::RobEntry::getNumDependants() const
+void RobTimer::freeEntry(RobEntry *entry)
 {
-   return numInlineDependants + (vectorDependants ? vectorDependants->size() : 0);
-}
-
-RobTimer::RobEntry* RobTimer::RobEntry::getDependant(size_t idx) const
-{
-   if (idx < MAX_INLINE_DEPENDANTS)
-   {
-      LOG_ASSERT_ERROR(idx < numInlineDependants, "Invalid idx %d", idx);
-      return inlineDependants[idx];
-   }
-   else
+   // Return the whole dependants list to the pool at once
+   if (entry->firstDependant != NO_LINK)
    {
-      LOG_ASSERT_ERROR(idx - MAX_INLINE_DEPENDANTS < vectorDependants->size(), "Invalid idx %d", idx);
-      return (*vectorDependants)[idx - MAX_INLINE_DEPENDANTS];
+      m_dependant_links[entry->lastDependant].next = m_free_dependant_link;
+      m_free_dependant_link = entry->firstDependant;
    }
+   entry->free();
 }
 
 RobTimer::RobEntry *RobTimer::findEntryBySequenceNumber(UInt64 sequenceNumber)
@@ -328,7 +323,7 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
          }
          else
          {
-            prodEntry->addDependant(entry);
+            addDependant(prodEntry, entry);
          }
       }
 
@@ -340,8 +335,8 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
          {
             RobEntry *prodEntry = this->findEntryBySequenceNumber(entry->getAddressProducer(i));
             bool found = false;
-            for(unsigned int j = 0; j < prodEntry->getNumDependants(); ++j)
-               if (prodEntry->getDependant(j) == entry)
+            for(UInt32 link = prodEntry->firstDependant; link != NO_LINK; link = m_dependant_links[link].next)
+               if (m_dependant_links[link].sequenceNumber == entry->uop->getSequenceNumber())
                {
                   found = true;
                   break;
@@ -442,7 +437,8 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
 
    if (frontend_stalled_until <= now)
    {
-      uint32_t instrs_dispatched = 0, uops_dispatched = 0;
+      uint32_t instrs_dispatched = 0, uops_dispatched = 0, instrs_decoded = 0;
+      bool load_dispatched = false;
 
       while(m_num_in_rob < windowSize)
       {
@@ -450,8 +446,15 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
          RobEntry *entry = &rob.at(m_num_in_rob);
          DynamicMicroOp &uop = *entry->uop;
 
+         // A micro-fused execute uop shares the dispatch slot of the load that came right before it
+         bool fused_slot = m_micro_fusion && load_dispatched && uop.getMicroOp()->isMicroFused();
+
          // Dispatch up to 4 instructions
-         if (uops_dispatched == dispatchWidth)
+         if (uops_dispatched == dispatchWidth && !fused_slot)
+            break;
+
+         // Instructions that do not come from the uop cache or loop stream detector are limited by the number of decoders
+         if (m_decode_width && uop.isFirst() && uop.isLegacyDecoded() && instrs_decoded == m_decode_width)
             break;
 
          // This is actually in the decode stage, there's a buffer between decode and dispatch
@@ -495,9 +498,13 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
          ++m_num_in_rob;
          ++m_rs_entries_used;
 
-         uops_dispatched++;
+         if (!fused_slot)
+            uops_dispatched++;
          if (uop.isLast())
             instrs_dispatched++;
+         if (uop.isFirst() && uop.isLegacyDecoded())
+            instrs_decoded++;
+         load_dispatched = uop.getMicroOp()->isLoad();
 
          // If uop is already ready, we may need to issue it in the following cycle
          entry->ready = std::max(entry->ready, (now + 1ul).getElapsedTime());
@@ -636,9 +643,9 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
       std::cout<<"ISSUE    "<<entry->uop->getMicroOp()->toShortString()<<"   latency="<<uop.getExecLatency()<<std::endl;
    #endif
 
-   for(size_t idx = 0; idx < entry->getNumDependants(); ++idx)
+   for(UInt32 link = entry->firstDependant; link != NO_LINK; link = m_dependant_links[link].next)
    {
-      RobEntry *depEntry = entry->getDependant(idx);
+      RobEntry *depEntry = this->findEntryBySequenceNumber(m_dependant_links[link].sequenceNumber);
       LOG_ASSERT_ERROR(depEntry->uop->getDependenciesLength()> 0, "??");
 
       // Remove uop from dependency list and update readyMax
@@ -849,10 +856,9 @@ SubsecondTime RobTimer::doCommit(uint64_t& instructionsExecuted)
       };
       m_core->getPerformanceModel()->traceInstruction(entry->uop, &times);
 
-      if (entry->uop->isLast())
-         instructionsExecuted++;
+      instructionsExecuted += entry->uop->getNumRetiredInstructions();
 
-      entry->free();
+      freeEntry(entry);
       rob.pop();
       m_num_in_rob--;
 
@@ -895,7 +901,8 @@ void RobTimer::execute(uint64_t& instructionsExecuted, SubsecondTime& latency)
 
 
    // Model dispatch, issue and commit stages
-   // Decode stage is not modeled, assumes the decoders can keep up with (up to) dispatchWidth uops per cycle
+   // Decode stage is not modeled, assumes the decoders can keep up with (up to) dispatchWidth uops per cycle,
+   // except for an optional limit on the number of instructions going through the legacy decoders (perf_model/core/frontend/decode_width)
 
    SubsecondTime next_dispatch = doDispatch(&cpiComponent);
    SubsecondTime next_issue    = doIssue();
@@ -14,26 +14,39 @@
 class RobTimer
 {
 private:
+   // Dependants are kept as singly-linked lists of sequence numbers, threaded
+   // through one pool that is allocated up front.  A consumer links itself to
+   // each producer at most once per dependency, so MAXIMUM_NUMBER_OF_DEPENDENCIES
+   // links for every ROB slot is expected to suffice; running out of links is
+   // caught by a LOG_ASSERT_ERROR in addDependant().
+   static const UInt32 NO_LINK = UINT32_MAX;
+
+   struct DependantLink
+   {
+      UInt64 sequenceNumber;
+      UInt32 next;
+   };
+
    class RobEntry
    {
       private:
-         static const size_t MAX_INLINE_DEPENDANTS = 8;
-         size_t numInlineDependants;
-         RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
-         std::vector<RobEntry*> *vectorDependants;
-         std::vector<uint64_t> addressProducers;
+         UInt32 numAddressProducers;
+         UInt64 addressProducers[MAXIMUM_NUMBER_OF_ADDRESS_REGISTERS];
 
       public:
          void init(DynamicMicroOp *uop, UInt64 sequenceNumber);
          void free();
 
-         void addDependant(RobEntry* dep);
-         uint64_t getNumDependants() const;
-         RobEntry* getDependant(size_t idx) const;
+         void addAddressProducer(UInt64 sequenceNumber)
+         {
+            LOG_ASSERT_ERROR(numAddressProducers < MAXIMUM_NUMBER_OF_ADDRESS_REGISTERS, "Too many address producers");
+            addressProducers[numAddressProducers++] = sequenceNumber;
+         }
+         UInt64 getNumAddressProducers() const { return numAddressProducers; }
+         UInt64 getAddressProducer(size_t idx) const { return addressProducers[idx]; }
 
-         void addAddressProducer(UInt64 sequenceNumber) { addressProducers.push_back(sequenceNumber); }
-         UInt64 getNumAddressProducers() const { return addressProducers.size(); }
-         UInt64 getAddressProducer(size_t idx) const { return addressProducers.at(idx); }
+         UInt32 firstDependant;  // Index into RobTimer::m_dependant_links, or NO_LINK
+         UInt32 lastDependant;
 
          DynamicMicroOp *uop;
          SubsecondTime dispatched;
@@ -53,11 +66,15 @@ private:
    const bool m_store_to_load_forwarding;
    const bool m_no_address_disambiguation;
    const bool inorder;
+   const uint64_t m_decode_width;
+   const bool m_micro_fusion;
 
    Core *m_core;
 
    typedef CircularQueue<RobEntry> Rob;
    Rob rob;
+   std::vector<DependantLink> m_dependant_links;
+   UInt32 m_free_dependant_link;
    uint64_t m_num_in_rob;
    uint64_t m_rs_entries_used;
    RobContention *m_rob_contention;
@@ -136,6 +153,8 @@ private:
    std::vector<SubsecondTime> m_outstandingLoadsAll;
 
    RobEntry *findEntryBySequenceNumber(UInt64 sequenceNumber);
+   void addDependant(RobEntry *producer, RobEntry *dependant);
+   void freeEntry(RobEntry *entry);
    SubsecondTime* findCpiComponent();
    void countOutstandingMemop(SubsecondTime time);
    void printRob();
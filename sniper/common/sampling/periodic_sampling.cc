@@ -19,6 +19,8 @@ PeriodicSampling::PeriodicSampling(SamplingManager *sampling_manager)
    // Duration of a cache warmup interval
    , m_warmup_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/periodic/warmup_interval")))
    , m_detailed_warmup_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/periodic/detailed_warmup_interval")))
+   // Instrumentation mode used during the warmup interval (cache_only or functional)
+   , m_warmup_mode(InstMode::fromString(Sim()->getCfg()->getString("sampling/periodic/warmup_mode")))
    // Whether to simulate synchronization during fast-forward (true, our method), or fast-forward using a per-core CPI that contains sync (false, COTSon method)
    , m_detailed_sync(Sim()->getCfg()->getBool("sampling/periodic/detailed_sync"))
    // Whether to randomly place the detailed interval inside the cycle (default: at the start)
@@ -29,6 +31,7 @@ PeriodicSampling::PeriodicSampling(SamplingManager *sampling_manager)
    , m_historic_cpi_intervals(Sim()->getConfig()->getApplicationCores(), NULL)
    , m_dispatch_width(Sim()->getCfg()->getInt("perf_model/core/interval_timer/dispatch_width"))
 {
+   LOG_ASSERT_ERROR(InstMode::isWarmup(m_warmup_mode), "sampling/periodic/warmup_mode must be cache_only or functional");
    LOG_ASSERT_ERROR(m_fastforward_sync_interval > SubsecondTime::Zero() && m_fastforward_sync_interval <= std::max(m_fastforward_interval, m_warmup_interval), "fastforward_sync_interval must be between 0 and max(fastforward_interval, warmup_interval)");
 
    UInt32 num_intervals = Sim()->getCfg()->getInt("sampling/periodic/num_historic_cpi_intervals");
@@ -166,7 +169,7 @@ PeriodicSampling::stepFastForward(SubsecondTime time, bool in_warmup)
         m_warmup_time_remaining = SubsecondTime::Zero();
       else
         m_warmup_time_remaining -= time_to_warmup;
-      m_sampling_manager->enableFastForward(time + time_to_warmup, true, m_detailed_sync);
+      m_sampling_manager->enableFastForward(time + time_to_warmup, true, m_detailed_sync, m_warmup_mode);
       return false;
    }
    else
@@ -5,6 +5,7 @@
 #include "sampling_algorithm.h"
 #include "circular_queue.h"
 #include "random.h"
+#include "inst_mode.h"
 
 #include <vector>
 
@@ -16,6 +17,7 @@ class PeriodicSampling : public SamplingAlgorithm
       SubsecondTime m_fastforward_sync_interval;
       SubsecondTime m_warmup_interval;
       SubsecondTime m_detailed_warmup_interval;
+      InstMode::inst_mode_t m_warmup_mode;
 
       bool m_detailed_sync;
 
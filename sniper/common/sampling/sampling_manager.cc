@@ -112,8 +112,10 @@ SamplingManager::disableFastForward()
 }
 
 void
-SamplingManager::enableFastForward(SubsecondTime until, bool warmup, bool detailed_sync)
+SamplingManager::enableFastForward(SubsecondTime until, bool warmup, bool detailed_sync, InstMode::inst_mode_t warmup_mode)
 {
+   LOG_ASSERT_ERROR(InstMode::isWarmup(warmup_mode), "Invalid warmup mode %s", inst_mode_names[warmup_mode]);
+
    m_fastforward = true;
    m_warmup = warmup;
    // Approximate time we want to leave fastforward mode
@@ -132,7 +134,7 @@ SamplingManager::enableFastForward(SubsecondTime until, bool warmup, bool detail
       Sim()->getClockSkewMinimizationServer()->setFastForward(true, barrier_next);
 
    if (m_warmup)
-      this->setInstrumentationMode(InstMode::CACHE_ONLY);
+      this->setInstrumentationMode(warmup_mode);
    else
       this->setInstrumentationMode(InstMode::FAST_FORWARD);
 
@@ -46,7 +46,7 @@ class SamplingManager
       ~SamplingManager();
 
       // To be called by SamplingAlgorithm
-      void enableFastForward(SubsecondTime until, bool warmup, bool detailed_sync);
+      void enableFastForward(SubsecondTime until, bool warmup, bool detailed_sync, InstMode::inst_mode_t warmup_mode = InstMode::CACHE_ONLY);
       void disableFastForward();
 
       SamplingProvider* getSamplingProvider() { return m_sampling_provider; };
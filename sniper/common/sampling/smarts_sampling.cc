@@ -0,0 +1,210 @@
+#include "smarts_sampling.h"
+#include "sampling_manager.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "fastforward_performance_model.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <cmath>
+
+SmartsSampling::SmartsSampling(SamplingManager *sampling_manager)
+   : SamplingAlgorithm(sampling_manager)
+   // Duration of a detailed measurement unit
+   , m_detailed_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/smarts/detailed_interval")))
+   // Detailed warmup before each measurement unit, not included in the sample
+   , m_detailed_warmup_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/smarts/detailed_warmup_interval")))
+   // Functional warming between measurement units, determines the sampling rate
+   , m_functional_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/smarts/functional_interval")))
+   , m_functional_interval_min(m_functional_interval)
+   , m_functional_interval_max(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/smarts/functional_interval_max")))
+   // Time between core synchronizations in fast-forward mode
+   , m_fastforward_sync_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/smarts/fastforward_sync_interval")))
+   , m_warmup_mode(InstMode::fromString(Sim()->getCfg()->getString("sampling/smarts/warmup_mode")))
+   , m_detailed_sync(Sim()->getCfg()->getBool("sampling/smarts/detailed_sync"))
+   , m_z_score(Sim()->getCfg()->getFloat("sampling/smarts/z_score"))
+   , m_target_error(Sim()->getCfg()->getFloat("sampling/smarts/target_error"))
+   , m_min_samples(Sim()->getCfg()->getInt("sampling/smarts/min_samples"))
+   , m_started(false)
+   , m_phase(PHASE_DETAILED_WARMUP)
+   , m_phase_start(SubsecondTime::Zero())
+   , m_fastforward_time_remaining(SubsecondTime::Zero())
+   , m_target_reached(false)
+   , m_units(0)
+   , m_target_units(0)
+   , m_core_samples(Sim()->getConfig()->getApplicationCores())
+   , m_dispatch_width(Sim()->getCfg()->getInt("perf_model/core/interval_timer/dispatch_width"))
+{
+   String on_target = Sim()->getCfg()->getString("sampling/smarts/on_target");
+   if (on_target == "stop")
+      m_adapt = false;
+   else if (on_target == "adapt")
+      m_adapt = true;
+   else
+      LOG_PRINT_ERROR("Invalid sampling/smarts/on_target value %s, expected stop or adapt", on_target.c_str());
+
+   LOG_ASSERT_ERROR(m_detailed_interval > SubsecondTime::Zero(), "sampling/smarts/detailed_interval must be larger than zero");
+   LOG_ASSERT_ERROR(m_functional_interval > SubsecondTime::Zero(), "sampling/smarts/functional_interval must be larger than zero");
+   LOG_ASSERT_ERROR(m_functional_interval_max >= m_functional_interval, "sampling/smarts/functional_interval_max must be at least functional_interval");
+   LOG_ASSERT_ERROR(m_fastforward_sync_interval > SubsecondTime::Zero() && m_fastforward_sync_interval <= m_functional_interval, "fastforward_sync_interval must be between 0 and functional_interval");
+   LOG_ASSERT_ERROR(InstMode::isWarmup(m_warmup_mode), "sampling/smarts/warmup_mode must be cache_only or functional");
+   LOG_ASSERT_ERROR(m_target_error > 0, "sampling/smarts/target_error must be larger than zero");
+   LOG_ASSERT_ERROR(m_min_samples >= 2, "sampling/smarts/min_samples must be at least 2");
+
+   registerStatsMetric("sampling", 0, "units", &m_units);
+   registerStatsMetric("sampling", 0, "target_units", &m_target_units);
+   registerStatsMetric("sampling", 0, "functional_interval", &m_functional_interval);
+   for(UInt32 core_id = 0; core_id < m_core_samples.size(); ++core_id)
+   {
+      registerStatsMetric("smarts", core_id, "samples", &m_core_samples[core_id].samples);
+      registerStatsMetric("smarts", core_id, "cpi_mean", &m_core_samples[core_id].cpi_mean);
+      registerStatsMetric("smarts", core_id, "cpi_error", &m_core_samples[core_id].cpi_error);
+   }
+}
+
+void
+SmartsSampling::callbackDetailed(SubsecondTime time)
+{
+   if (!m_started)
+   {
+      m_started = true;
+      m_phase = PHASE_DETAILED_WARMUP;
+      m_phase_start = time;
+   }
+
+   if (m_phase == PHASE_DETAILED_WARMUP && time >= m_phase_start + m_detailed_warmup_interval)
+   {
+      // Warmup done, start measuring from here
+      m_sampling_manager->resetCoreHistoricCPIs();
+      m_phase = PHASE_MEASURE;
+      m_phase_start = time;
+   }
+   else if (m_phase == PHASE_MEASURE && time >= m_phase_start + m_detailed_interval)
+   {
+      addSamples();
+      ++m_units;
+
+      bool reached = targetReached();
+      if (reached && !m_target_reached)
+      {
+         m_target_reached = true;
+         m_target_units = m_units;
+         printf("[SMARTS] Target error of %.1f%% reached after %" PRIu64 " units%s\n", 100 * m_target_error, m_units, m_adapt ? "" : ", stopping detailed sampling");
+      }
+
+      if (m_adapt)
+      {
+         // Sample less often while the error bound holds, more often again when it doesn't
+         if (reached)
+            m_functional_interval = std::min(m_functional_interval * 2, m_functional_interval_max);
+         else
+            m_functional_interval = std::max(m_functional_interval / 2, m_functional_interval_min);
+      }
+
+      startFastForward(time);
+   }
+}
+
+void
+SmartsSampling::callbackFastForward(SubsecondTime time, bool in_warmup)
+{
+   bool done = stepFastForward(time);
+   if (done)
+   {
+      m_sampling_manager->disableFastForward();
+      m_phase = PHASE_DETAILED_WARMUP;
+      m_phase_start = time;
+   }
+}
+
+void
+SmartsSampling::addSamples()
+{
+   for(UInt32 core_id = 0; core_id < m_core_samples.size(); ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      CoreSamples &s = m_core_samples[core_id];
+
+      // Only use this unit if the core was executing instructions for at least 20% of the time
+      SubsecondTime cpi = m_sampling_manager->getCoreHistoricCPI(core, m_detailed_sync, m_detailed_interval / 5);
+      if (cpi != SubsecondTime::Zero() && cpi != SubsecondTime::MaxTime())
+      {
+         double x = cpi.getFS();
+         s.samples++;
+         s.sum += x;
+         s.sum_squares += x * x;
+
+         double mean = s.sum / s.samples;
+         s.cpi_mean = SubsecondTime::FS(UInt64(mean));
+         if (s.samples > 1)
+         {
+            double variance = std::max(0., (s.sum_squares - s.samples * mean * mean) / (s.samples - 1));
+            s.cpi_error = SubsecondTime::FS(UInt64(m_z_score * sqrt(variance / s.samples)));
+         }
+      }
+
+      // Fast-forward using the estimated CPI
+      if (s.samples)
+      {
+         SubsecondTime period = core->getDvfsDomain()->getPeriod();
+         SubsecondTime cpi_ffwd = s.cpi_mean;
+         SubsecondTime min_cpi = period / m_dispatch_width;
+         if (cpi_ffwd < min_cpi)
+            cpi_ffwd = min_cpi; // max. m_dispatch_width IPC
+         else if (cpi_ffwd > period * 100)
+            cpi_ffwd = period * 100; // min. .01 IPC
+         core->getPerformanceModel()->getFastforwardPerformanceModel()->setCurrentCPI(cpi_ffwd);
+      }
+   }
+}
+
+bool
+SmartsSampling::targetReached() const
+{
+   bool any = false;
+   for(UInt32 core_id = 0; core_id < m_core_samples.size(); ++core_id)
+   {
+      const CoreSamples &s = m_core_samples[core_id];
+      // Cores that never ran do not contribute to the error
+      if (s.samples == 0)
+         continue;
+      if (s.samples < m_min_samples)
+         return false;
+      if (s.cpi_error.getFS() > m_target_error * s.cpi_mean.getFS())
+         return false;
+      any = true;
+   }
+   return any;
+}
+
+void
+SmartsSampling::startFastForward(SubsecondTime time)
+{
+   m_phase = PHASE_FASTFORWARD;
+   if (m_target_reached && !m_adapt)
+      m_fastforward_time_remaining = SubsecondTime::MaxTime();
+   else
+      m_fastforward_time_remaining = m_functional_interval;
+
+   bool done = stepFastForward(time);
+   LOG_ASSERT_ERROR(done == false, "No fastforwarding to be done");
+}
+
+bool
+SmartsSampling::stepFastForward(SubsecondTime time)
+{
+   if (m_fastforward_time_remaining > SubsecondTime::Zero())
+   {
+      SubsecondTime time_to_fastforward = std::min(m_fastforward_time_remaining, m_fastforward_sync_interval);
+      m_fastforward_time_remaining -= time_to_fastforward;
+      // Once sampling has stopped, no state needs to be kept warm anymore
+      bool warmup = !(m_target_reached && !m_adapt);
+      m_sampling_manager->enableFastForward(time + time_to_fastforward, warmup, m_detailed_sync, m_warmup_mode);
+      return false;
+   }
+   else
+   {
+      return true;
+   }
+}
@@ -0,0 +1,76 @@
+#ifndef __SMARTS_SAMPLING
+#define __SMARTS_SAMPLING
+
+#include "fixed_types.h"
+#include "sampling_algorithm.h"
+#include "inst_mode.h"
+
+#include <vector>
+
+// SMARTS-style statistical sampling (Wunderlich et al., ISCA 2003):
+// short detailed measurement units, each preceded by a bit of detailed warmup,
+// separated by long stretches of functional warming.  After every unit the running
+// CPI mean and its confidence interval are updated per core.  Once every core has
+// reached the target relative error, sampling either stops (plain fast-forward
+// using the estimated CPI) or adapts by lowering the sampling rate.
+
+class SmartsSampling : public SamplingAlgorithm
+{
+   protected:
+      enum phase_t {
+         PHASE_DETAILED_WARMUP,
+         PHASE_MEASURE,
+         PHASE_FASTFORWARD,
+      };
+
+      struct CoreSamples
+      {
+         UInt64 samples;
+         double sum;
+         double sum_squares;
+         SubsecondTime cpi_mean;
+         SubsecondTime cpi_error;   // Confidence interval half-width
+
+         CoreSamples() : samples(0), sum(0), sum_squares(0), cpi_mean(SubsecondTime::Zero()), cpi_error(SubsecondTime::Zero()) {}
+      };
+
+      SubsecondTime m_detailed_interval;
+      SubsecondTime m_detailed_warmup_interval;
+      SubsecondTime m_functional_interval;
+      SubsecondTime m_functional_interval_min;
+      SubsecondTime m_functional_interval_max;
+      SubsecondTime m_fastforward_sync_interval;
+      InstMode::inst_mode_t m_warmup_mode;
+      bool m_detailed_sync;
+
+      const double m_z_score;
+      const double m_target_error;
+      const UInt64 m_min_samples;
+      bool m_adapt;
+
+      bool m_started;
+      phase_t m_phase;
+      SubsecondTime m_phase_start;
+      SubsecondTime m_fastforward_time_remaining;
+
+      bool m_target_reached;
+      UInt64 m_units;
+      UInt64 m_target_units;
+
+      std::vector<CoreSamples> m_core_samples;
+
+      int m_dispatch_width;
+
+      void addSamples();
+      bool targetReached() const;
+      void startFastForward(SubsecondTime time);
+      bool stepFastForward(SubsecondTime time);
+
+   public:
+      SmartsSampling(SamplingManager *sampling_manager);
+
+      virtual void callbackDetailed(SubsecondTime now);
+      virtual void callbackFastForward(SubsecondTime now, bool in_warmup);
+};
+
+#endif /* __SMARTS_SAMPLING */
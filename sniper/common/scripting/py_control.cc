@@ -29,6 +29,7 @@ setInstrumentationMode(PyObject *self, PyObject *args)
       case SIM_OPT_INSTRUMENT_DETAILED:
       case SIM_OPT_INSTRUMENT_WARMUP:
       case SIM_OPT_INSTRUMENT_FASTFORWARD:
+      case SIM_OPT_INSTRUMENT_FUNCTIONAL:
          Sim()->getMagicServer()->Magic_unlocked(INVALID_CORE_ID, INVALID_THREAD_ID, SIM_CMD_INSTRUMENT_MODE, mode, 0);
          break;
       default:
@@ -94,4 +95,9 @@ void HooksPy::PyControl::setup(void)
       PyObject_SetAttrString(pModule, "FASTFORWARD", pGlobalConst);
       Py_DECREF(pGlobalConst);
    }
+   {
+      PyObject *pGlobalConst = PyInt_FromLong(SIM_OPT_INSTRUMENT_FUNCTIONAL);
+      PyObject_SetAttrString(pModule, "FUNCTIONAL", pGlobalConst);
+      Py_DECREF(pGlobalConst);
+   }
 }
@@ -22,9 +22,12 @@ FastForwardPerformanceManager::create(void)
 
 FastForwardPerformanceManager::FastForwardPerformanceManager()
    : m_sync_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("perf_model/fast_forward/oneipc/interval")))
+   , m_issue_rate(Sim()->getCfg()->getFloat("perf_model/fast_forward/oneipc/issue_rate"))
    , m_enabled(false)
    , m_target_sync_time(SubsecondTime::Zero())
 {
+   LOG_ASSERT_ERROR(m_issue_rate > 0, "perf_model/fast_forward/oneipc/issue_rate must be larger than zero");
+
    Sim()->getHooksManager()->registerHook(HookType::HOOK_INSTR_COUNT, FastForwardPerformanceManager::hook_instr_count, (UInt64)this);
    Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, FastForwardPerformanceManager::hook_periodic, (UInt64)this);
 }
@@ -126,8 +129,9 @@ FastForwardPerformanceManager::recalibrateInstructionsCallback(core_id_t core_id
    }
    else
    {
-      // One IPC
-      SubsecondTime cpi = Sim()->getCoreManager()->getCoreFromID(core_id)->getDvfsDomain()->getPeriod();
+      // Fixed issue rate, one IPC by default
+      SubsecondTime period = Sim()->getCoreManager()->getCoreFromID(core_id)->getDvfsDomain()->getPeriod();
+      SubsecondTime cpi = m_issue_rate == 1 ? period : SubsecondTime::FSfromFloat(period.getFS() / m_issue_rate);
       UInt64 ninstrs = SubsecondTime::divideRounded(m_target_sync_time - now, cpi);
 
       core->getPerformanceModel()->getFastforwardPerformanceModel()->setCurrentCPI(cpi);
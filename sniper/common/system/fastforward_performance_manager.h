@@ -20,6 +20,7 @@ class FastForwardPerformanceManager
 
    private:
       const SubsecondTime m_sync_interval;
+      const float m_issue_rate;
       bool m_enabled;
       SubsecondTime m_target_sync_time;
 
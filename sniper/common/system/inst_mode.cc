@@ -2,7 +2,7 @@
 #include "inst_mode.h"
 
 const char * inst_mode_names[] = {
-   "INVALID", "DETAILED", "CACHE_ONLY", "FAST_FORWARD"
+   "INVALID", "DETAILED", "CACHE_ONLY", "FAST_FORWARD", "FUNCTIONAL"
 };
 
 // Instrumentation modes
@@ -29,6 +29,8 @@ InstMode::fromString(const String str)
       return DETAILED;
    else if (str == "fast_forward")
       return FAST_FORWARD;
+   else if (str == "functional")
+      return FUNCTIONAL;
    else
       LOG_PRINT_ERROR("Invalid instrumentation mode %s", str.c_str());
 }
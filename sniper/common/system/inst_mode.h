@@ -7,11 +7,17 @@ class InstMode
 {
    public:
       enum inst_mode_t {
-         INVALID = 0, DETAILED, CACHE_ONLY, FAST_FORWARD
+         INVALID = 0, DETAILED, CACHE_ONLY, FAST_FORWARD,
+         // Like CACHE_ONLY, but without any timing or cache statistics: caches, TLBs and
+         // branch predictors are updated functionally while time advances at the fast-forward CPI
+         FUNCTIONAL
       };
       static inst_mode_t inst_mode_init, inst_mode_roi, inst_mode_end;
       static inst_mode_t fromString(const String str);
 
+      // Modes in which caches, TLBs and branch predictors are kept warm
+      static bool isWarmup(inst_mode_t mode) { return mode == CACHE_ONLY || mode == FUNCTIONAL; }
+
    private:
       static inst_mode_t inst_mode;
       static void updateInstrumentationMode();
@@ -248,6 +248,9 @@ UInt64 MagicServer::setInstrumentationMode(UInt64 sim_api_opt)
    case SIM_OPT_INSTRUMENT_FASTFORWARD:
       inst_mode = InstMode::FAST_FORWARD;
       break;
+   case SIM_OPT_INSTRUMENT_FUNCTIONAL:
+      inst_mode = InstMode::FUNCTIONAL;
+      break;
    default:
       LOG_PRINT_ERROR("Unexpected magic instrument opt type: %lx.", sim_api_opt);
    }
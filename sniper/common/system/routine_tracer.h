@@ -35,6 +35,7 @@ class RoutineTracerThread
       void routineAssert(IntPtr eip, IntPtr esp);
 
       const CallStack& getCallStack() const { return m_stack; }
+      CallStack getCallStackCopy() { ScopedLock sl(m_lock); return m_stack; }
 
    protected:
       Lock m_lock;
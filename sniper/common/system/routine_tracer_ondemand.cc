@@ -66,5 +66,6 @@ bool RoutineTracerOndemand::RtnMaster::hasRoutine(IntPtr eip)
 RoutineTracer::Routine* RoutineTracerOndemand::RtnMaster::getRoutine(IntPtr eip)
 {
    ScopedLock sl(m_lock);
-   return m_routines[eip];
+   auto it = m_routines.find(eip);
+   return it == m_routines.end() ? NULL : it->second;
 }
@@ -18,6 +18,7 @@ class RoutineTracerOndemand
             virtual void addRoutine(IntPtr eip, const char *name, const char *imgname, IntPtr offset, int column, int line, const char *filename);
             virtual bool hasRoutine(IntPtr eip);
             RoutineTracer::Routine* getRoutine(IntPtr eip);
+            virtual const Routine* getRoutineInfo(IntPtr eip) { return getRoutine(eip); }
 
          private:
             static SInt64 signalHandler(UInt64, UInt64);
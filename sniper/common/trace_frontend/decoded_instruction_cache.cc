@@ -0,0 +1,113 @@
+#include "decoded_instruction_cache.h"
+#include "instruction.h"
+#include "micro_op.h"
+#include "stats.h"
+#include "log.h"
+
+#include <cstring>
+
+DecodedInstructionCache::DecodedInstructionCache(UInt32 num_buckets_log2)
+   : m_num_buckets_log2(num_buckets_log2)
+   , m_num_buckets(UInt64(1) << num_buckets_log2)
+   , m_buckets(new std::atomic<Entry*>[m_num_buckets])
+   , m_decodes(0)
+   , m_shared_hits(0)
+   , m_insert_races(0)
+{
+   for(UInt64 i = 0; i < m_num_buckets; ++i)
+      m_buckets[i].store(NULL, std::memory_order_relaxed);
+
+   registerStatsMetric("decode-cache", 0, "decodes", &m_decodes);
+   registerStatsMetric("decode-cache", 0, "shared-hits", &m_shared_hits);
+   registerStatsMetric("decode-cache", 0, "insert-races", &m_insert_races);
+}
+
+DecodedInstructionCache::~DecodedInstructionCache()
+{
+   for(UInt64 i = 0; i < m_num_buckets; ++i)
+   {
+      Entry *entry = m_buckets[i].load(std::memory_order_relaxed);
+      while (entry)
+      {
+         Entry *next = entry->next;
+         deleteInstruction(entry->instruction);
+         delete entry;
+         entry = next;
+      }
+   }
+   delete [] m_buckets;
+}
+
+std::atomic<DecodedInstructionCache::Entry*>&
+DecodedInstructionCache::getBucket(IntPtr address) const
+{
+   // Fibonacci hashing, the upper bits (address space) and lower bits (PC) both matter
+   UInt64 hash = UInt64(address) * 0x9e3779b97f4a7c15ULL;
+   return m_buckets[hash >> (64 - m_num_buckets_log2)];
+}
+
+const DecodedInstructionCache::Entry*
+DecodedInstructionCache::findInChain(const Entry *entry, IntPtr address, const uint8_t *bytes, UInt32 size)
+{
+   for( ; entry; entry = entry->next)
+      if (entry->address == address && entry->size == size && memcmp(entry->bytes, bytes, size) == 0)
+         return entry;
+   return NULL;
+}
+
+void
+DecodedInstructionCache::deleteInstruction(Instruction *instruction)
+{
+   const std::vector<const MicroOp*> *uops = instruction->getMicroOps();
+   if (uops)
+   {
+      for(std::vector<const MicroOp*>::const_iterator it = uops->begin(); it != uops->end(); ++it)
+         delete *it;
+      delete uops;
+   }
+   delete instruction;
+}
+
+Instruction*
+DecodedInstructionCache::find(IntPtr address, const uint8_t *bytes, UInt32 size)
+{
+   const Entry *entry = findInChain(getBucket(address).load(std::memory_order_acquire), address, bytes, size);
+   if (entry)
+   {
+      __sync_fetch_and_add(&m_shared_hits, 1);
+      return entry->instruction;
+   }
+   return NULL;
+}
+
+Instruction*
+DecodedInstructionCache::insert(IntPtr address, const uint8_t *bytes, UInt32 size, Instruction *instruction)
+{
+   LOG_ASSERT_ERROR(size <= sizeof(Entry::bytes), "Instruction @ %lx too long (%u bytes)", address, size);
+
+   Entry *entry = new Entry();
+   entry->address = address;
+   entry->size = size;
+   memcpy(entry->bytes, bytes, size);
+   entry->instruction = instruction;
+
+   std::atomic<Entry*> &bucket = getBucket(address);
+   Entry *head = bucket.load(std::memory_order_acquire);
+   do
+   {
+      // Another thread may have inserted the same instruction since we last looked
+      const Entry *existing = findInChain(head, address, bytes, size);
+      if (existing)
+      {
+         __sync_fetch_and_add(&m_insert_races, 1);
+         deleteInstruction(instruction);
+         delete entry;
+         return existing->instruction;
+      }
+      entry->next = head;
+   }
+   while (!bucket.compare_exchange_weak(head, entry, std::memory_order_release, std::memory_order_acquire));
+
+   __sync_fetch_and_add(&m_decodes, 1);
+   return instruction;
+}
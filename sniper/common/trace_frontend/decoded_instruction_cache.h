@@ -0,0 +1,53 @@
+#ifndef __DECODED_INSTRUCTION_CACHE_H
+#define __DECODED_INSTRUCTION_CACHE_H
+
+#include "fixed_types.h"
+
+#include <atomic>
+
+class Instruction;
+
+// Process-wide cache of decoded static instructions, shared by all TraceThreads.
+//
+// Without it, every thread running the same binary decodes each instruction
+// again and keeps its own Instruction and MicroOp copies.  Entries are keyed
+// on the physical instruction address, which includes the address space, and
+// on the instruction bytes, so different processes or rewritten code never
+// share an entry.  Entries are never removed.  Lookups only follow pointers,
+// inserts publish a fully built entry with a compare-and-swap on the bucket
+// head, so the cache needs no lock.
+class DecodedInstructionCache
+{
+   private:
+      struct Entry
+      {
+         IntPtr address;
+         UInt32 size;
+         uint8_t bytes[16];
+         Instruction *instruction;
+         Entry *next;
+      };
+
+      const UInt32 m_num_buckets_log2;
+      const UInt64 m_num_buckets;
+      std::atomic<Entry*> *m_buckets;
+
+      UInt64 m_decodes;       //< Instructions inserted into the cache
+      UInt64 m_shared_hits;   //< Lookups served by an instruction another thread decoded
+      UInt64 m_insert_races;  //< Instructions decoded by two threads at once, the loser was discarded
+
+      std::atomic<Entry*>& getBucket(IntPtr address) const;
+      static const Entry* findInChain(const Entry *entry, IntPtr address, const uint8_t *bytes, UInt32 size);
+      static void deleteInstruction(Instruction *instruction);
+
+   public:
+      DecodedInstructionCache(UInt32 num_buckets_log2 = 18);
+      ~DecodedInstructionCache();
+
+      Instruction* find(IntPtr address, const uint8_t *bytes, UInt32 size);
+      // Returns the cached instruction for this key: <instruction> itself, or the copy
+      // another thread inserted first, in which case <instruction> is deleted
+      Instruction* insert(IntPtr address, const uint8_t *bytes, UInt32 size, Instruction *instruction);
+};
+
+#endif // __DECODED_INSTRUCTION_CACHE_H
@@ -90,6 +90,7 @@ thread_id_t TraceManager::newThread(app_id_t app_id, bool first, bool init_fifo,
    assert(static_cast<decltype(app_id)>(m_num_apps) > app_id);
 
    String tracefile = "", responsefile = "";
+   UInt64 start_instruction = 0, num_instructions = 0;
    int thread_num;
    if (first)
    {
@@ -104,6 +105,10 @@ thread_id_t TraceManager::newThread(app_id_t app_id, bool first, bool init_fifo,
          tracefile = m_tracefiles[app_id];
          if (m_responsefiles.size())
             responsefile = m_responsefiles[app_id];
+         // Optionally simulate only a segment of the main thread's trace.
+         // Threads created later are not positioned, they always replay their trace from the start.
+         start_instruction = Sim()->getCfg()->getIntArray("traceinput/start_instruction", app_id);
+         num_instructions = Sim()->getCfg()->getIntArray("traceinput/num_instructions", app_id);
       }
    }
    else
@@ -121,7 +126,7 @@ thread_id_t TraceManager::newThread(app_id_t app_id, bool first, bool init_fifo,
 
    m_num_threads_running++;
    Thread *thread = Sim()->getThreadManager()->createThread(app_id, creator_thread_id);
-   TraceThread *tthread = new TraceThread(thread, time, tracefile, responsefile, app_id, init_fifo /*cleaup*/);
+   TraceThread *tthread = new TraceThread(thread, time, tracefile, responsefile, app_id, init_fifo /*cleaup*/, start_instruction, num_instructions);
    m_threads.push_back(tthread);
 
    if (spawn)
@@ -5,6 +5,7 @@
 #include "semaphore.h"
 #include "core.h" // for lock_signal_t and mem_op_t
 #include "_thread.h"
+#include "decoded_instruction_cache.h"
 
 #include <vector>
 
@@ -52,6 +53,7 @@ class TraceManager
       std::vector<String> m_responsefiles;
       String m_trace_prefix;
       Lock m_lock;
+      DecodedInstructionCache m_decoded_instruction_cache;
 
       String getFifoName(app_id_t app_id, UInt64 thread_num, bool response, bool create);
       thread_id_t newThread(app_id_t app_id, bool first, bool init_fifo, bool spawn, SubsecondTime time, thread_id_t creator_thread_id);
@@ -78,6 +80,8 @@ class TraceManager
 
       UInt64 getProgressExpect();
       UInt64 getProgressValue();
+
+      DecodedInstructionCache* getDecodedInstructionCache() { return &m_decoded_instruction_cache; }
 };
 
 #endif // __TRACE_MANAGER_H
@@ -29,7 +29,7 @@ extern "C" {
 }
 #endif
 
-TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup)
+TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup, UInt64 start_instruction, UInt64 num_instructions)
    : m__thread(NULL)
    , m_thread(thread)
    , m_time_start(time_start)
@@ -38,6 +38,7 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_address_randomization(Sim()->getCfg()->getBool("traceinput/address_randomization"))
    , m_appid_from_coreid(Sim()->getCfg()->getString("scheduler/type") == "sequential" ? true : false)
    , m_stop(false)
+   , m_memory_only(Sim()->getCfg()->getBool("traceinput/memory_only"))
    , m_bbv_base(0)
    , m_bbv_count(0)
    , m_bbv_last(0)
@@ -49,6 +50,10 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_blocked(false)
    , m_cleanup(cleanup)
    , m_started(false)
+   , m_start_instruction(start_instruction)
+   , m_num_instructions(num_instructions)
+   , m_num_pending(0)
+   , m_pending_prfmdl(NULL)
    , m_stopped(false)
 {
    m_trace.setHandleInstructionCountFunc(TraceThread::__handleInstructionCountFunc, this);
@@ -63,6 +68,7 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    m_trace.setHandleForkFunc(TraceThread::__handleForkFunc, this);
    if (Sim()->getRoutineTracer())
       m_trace.setHandleRoutineFunc(TraceThread::__handleRoutineChangeFunc, TraceThread::__handleRoutineAnnounceFunc, this);
+   m_trace.setReadAhead(Sim()->getCfg()->getInt("traceinput/read_ahead"));
 
    if (m_address_randomization)
    {
@@ -95,6 +101,7 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
 TraceThread::~TraceThread()
 {
    delete m__thread;
+   m_memops.forEach([](uint64_t addr, const MemoryOperands *memops) { delete memops; });
    if (m_cleanup)
    {
       unlink(m_tracefile.c_str());
@@ -203,6 +210,8 @@ void TraceThread::handleOutputFunc(uint8_t fd, const uint8_t *data, uint32_t siz
 
 uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *data, uint32_t size)
 {
+   flushInstructions();
+
    // We may have been blocked in a system call, if we start executing instructions again that means we're continuing
    if (m_blocked)
    {
@@ -238,27 +247,33 @@ uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *
 
 int32_t TraceThread::handleNewThreadFunc()
 {
+   flushInstructions();
    return Sim()->getTraceManager()->createThread(m_app_id, getCurrentTime(), m_thread->getId());
 }
 
 int32_t TraceThread::handleForkFunc()
 {
+   flushInstructions();
    return Sim()->getTraceManager()->createApplication(getCurrentTime(), m_thread->getId());
 }
 
 int32_t TraceThread::handleJoinFunc(int32_t join_thread_id)
 {
+   flushInstructions();
    Sim()->getThreadManager()->joinThread(m_thread->getId(), join_thread_id);
    return 0;
 }
 
 uint64_t TraceThread::handleMagicFunc(uint64_t a, uint64_t b, uint64_t c)
 {
+   flushInstructions();
    return handleMagicInstruction(m_thread->getId(), a, b, c);
 }
 
 void TraceThread::handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
 {
+   flushInstructions();
+
    switch(event)
    {
       case Sift::RoutineEnter:
@@ -277,6 +292,8 @@ void TraceThread::handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t ei
 
 bool TraceThread::handleEmuFunc(Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuReply &res)
 {
+   flushInstructions();
+
    // We may have been blocked in a system call, if we start executing instructions again that means we're continuing
    if (m_blocked)
    {
@@ -424,6 +441,8 @@ Instruction* TraceThread::decode(Sift::Instruction &inst)
 
 Sift::Mode TraceThread::handleInstructionCountFunc(uint32_t icount)
 {
+   flushInstructions();
+
    if (!m_started)
    {
       // Received first instruction, let TraceManager know our SIFT connection is up and running
@@ -462,6 +481,7 @@ Sift::Mode TraceThread::handleInstructionCountFunc(uint32_t icount)
       case InstMode::FAST_FORWARD:
          return Sift::ModeIcount;
       case InstMode::CACHE_ONLY:
+      case InstMode::FUNCTIONAL:
          return Sift::ModeMemory;
       case InstMode::DETAILED:
          return Sift::ModeDetailed;
@@ -484,11 +504,16 @@ void TraceThread::handleCacheOnlyFunc(uint8_t icount, Sift::CacheOnlyType type,
    if (icount)
       core->countInstructions(0, icount);
 
+   // Functional warming updates cache contents without counting the accesses
+   const Core::MemModeled modeled = Sim()->getInstrumentationMode() == InstMode::FUNCTIONAL ? Core::MEM_MODELED_WARMUP : Core::MEM_MODELED_COUNT;
+
    switch(type)
    {
       case Sift::CacheOnlyBranchTaken:
       case Sift::CacheOnlyBranchNotTaken:
       {
+         if (m_memory_only)
+            break;
          bool taken = (type == Sift::CacheOnlyBranchTaken);
          bool mispredict = core->accessBranchPredictor(va2pa(eip), taken, va2pa(address));
          if (mispredict)
@@ -504,31 +529,61 @@ void TraceThread::handleCacheOnlyFunc(uint8_t icount, Sift::CacheOnlyType type,
                va2pa(address),
                NULL,
                4,
-               Core::MEM_MODELED_COUNT,
+               modeled,
                va2pa(eip));
          break;
 
       case Sift::CacheOnlyMemIcache:
          if (Sim()->getConfig()->getEnableICacheModeling())
-            core->readInstructionMemory(va2pa(eip), address);
+            core->readInstructionMemory(va2pa(eip), address, modeled == Core::MEM_MODELED_WARMUP ? Core::MEM_MODELED_WARMUP : Core::MEM_MODELED_COUNT_TLBTIME);
          break;
    }
 }
 
+const TraceThread::MemoryOperands* TraceThread::getMemoryOperands(const Sift::StaticInstruction *sinst)
+{
+   const MemoryOperands* &memops = m_memops[sinst->addr];
+   if (memops)
+      return memops;
+
+   const xed_decoded_inst_t &xed_inst = sinst->xed_inst;
+   MemoryOperands *ops = new MemoryOperands();
+   ops->is_atomic_update = xed_operand_values_get_atomic(xed_decoded_inst_operands_const(&xed_inst));
+   ops->is_prefetch = xed_decoded_inst_is_prefetch(&xed_inst);
+   ops->num_operands = 0;
+
+   // Ignore memory-referencing operands in NOP instructions
+   if (!xed_decoded_inst_get_attribute(&xed_inst, XED_ATTRIBUTE_NOP))
+   {
+      ops->num_operands = xed_decoded_inst_number_of_memory_operands(&xed_inst);
+      LOG_ASSERT_ERROR(ops->num_operands <= MemoryOperands::MAX_OPERANDS, "Too many memory operands (%d)", ops->num_operands);
+      for(uint32_t mem_idx = 0; mem_idx < ops->num_operands; ++mem_idx)
+      {
+         ops->operands[mem_idx].is_read = xed_decoded_inst_mem_read(&xed_inst, mem_idx);
+         ops->operands[mem_idx].is_write = xed_decoded_inst_mem_written(&xed_inst, mem_idx);
+         ops->operands[mem_idx].size = xed_decoded_inst_get_memory_operand_length(&xed_inst, mem_idx);
+      }
+   }
+
+   memops = ops;
+   return memops;
+}
+
 void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size)
 {
-   const xed_decoded_inst_t &xed_inst = inst.sinst->xed_inst;
+   // Functional warming updates cache contents without counting the accesses
+   const Core::MemModeled modeled = Sim()->getInstrumentationMode() == InstMode::FUNCTIONAL ? Core::MEM_MODELED_WARMUP : Core::MEM_MODELED_COUNT;
 
    // Warmup instruction caches
 
    if (do_icache_warmup && Sim()->getConfig()->getEnableICacheModeling())
    {
-      core->readInstructionMemory(va2pa(icache_warmup_addr), icache_warmup_size);
+      core->readInstructionMemory(va2pa(icache_warmup_addr), icache_warmup_size, modeled == Core::MEM_MODELED_WARMUP ? Core::MEM_MODELED_WARMUP : Core::MEM_MODELED_COUNT_TLBTIME);
    }
 
    // Warmup branch predictor
 
-   if (inst.is_branch)
+   if (inst.is_branch && !m_memory_only)
    {
       bool mispredict = core->accessBranchPredictor(va2pa(inst.sinst->addr), inst.taken, va2pa(next_inst.sinst->addr));
       if (mispredict)
@@ -539,57 +594,54 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
 
    if (inst.executed)
    {
-      const bool is_atomic_update = xed_operand_values_get_atomic(xed_decoded_inst_operands_const(&xed_inst));
-      const bool is_prefetch = xed_decoded_inst_is_prefetch(&xed_inst);
+      const MemoryOperands *memops = getMemoryOperands(inst.sinst);
+      for(uint32_t mem_idx = 0; mem_idx < memops->num_operands; ++mem_idx)
+      {
+         if (memops->operands[mem_idx].is_read)
+         {
+            LOG_ASSERT_ERROR(mem_idx < inst.num_addresses, "Did not receive enough data addresses");
+
+            bool no_mapping = false;
+            UInt64 pa = va2pa(inst.addresses[mem_idx], memops->is_prefetch ? &no_mapping : NULL);
+            if (no_mapping)
+               continue;
+
+            core->accessMemory(
+                  /*(is_atomic_update) ? Core::LOCK :*/ Core::NONE,
+                  (memops->is_atomic_update) ? Core::READ_EX : Core::READ,
+                  pa,
+                  NULL,
+                  memops->operands[mem_idx].size,
+                  modeled,
+                  va2pa(inst.sinst->addr));
+         }
+      }
 
-      // Ignore memory-referencing operands in NOP instructions
-      if (!xed_decoded_inst_get_attribute(&xed_inst, XED_ATTRIBUTE_NOP))
+      for(uint32_t mem_idx = 0; mem_idx < memops->num_operands; ++mem_idx)
       {
-         for(uint32_t mem_idx = 0; mem_idx < xed_decoded_inst_number_of_memory_operands(&xed_inst); ++mem_idx)
+         if (memops->operands[mem_idx].is_write)
          {
-            if (xed_decoded_inst_mem_read(&xed_inst, mem_idx))
-            {
-               LOG_ASSERT_ERROR(mem_idx < inst.num_addresses, "Did not receive enough data addresses");
+            LOG_ASSERT_ERROR(mem_idx < inst.num_addresses, "Did not receive enough data addresses");
 
-               bool no_mapping = false;
-               UInt64 pa = va2pa(inst.addresses[mem_idx], is_prefetch ? &no_mapping : NULL);
-               if (no_mapping)
-                  continue;
+            bool no_mapping = false;
+            UInt64 pa = va2pa(inst.addresses[mem_idx], memops->is_prefetch ? &no_mapping : NULL);
+            if (no_mapping)
+               continue;
 
+            if (memops->is_atomic_update)
+            {
+               if (modeled != Core::MEM_MODELED_WARMUP)
+                  core->logMemoryHit(false, Core::WRITE, pa, modeled, va2pa(inst.sinst->addr));
+            }
+            else
                core->accessMemory(
-                     /*(is_atomic_update) ? Core::LOCK :*/ Core::NONE,
-                     (is_atomic_update) ? Core::READ_EX : Core::READ,
+                     /*(is_atomic_update) ? Core::UNLOCK :*/ Core::NONE,
+                     Core::WRITE,
                      pa,
                      NULL,
-                     xed_decoded_inst_get_memory_operand_length(&xed_inst, mem_idx),
-                     Core::MEM_MODELED_COUNT,
+                     memops->operands[mem_idx].size,
+                     modeled,
                      va2pa(inst.sinst->addr));
-            }
-         }
-
-         for(uint32_t mem_idx = 0; mem_idx < xed_decoded_inst_number_of_memory_operands(&xed_inst); ++mem_idx)
-         {
-            if (xed_decoded_inst_mem_written(&xed_inst, mem_idx))
-            {
-               LOG_ASSERT_ERROR(mem_idx < inst.num_addresses, "Did not receive enough data addresses");
-
-               bool no_mapping = false;
-               UInt64 pa = va2pa(inst.addresses[mem_idx], is_prefetch ? &no_mapping : NULL);
-               if (no_mapping)
-                  continue;
-
-               if (is_atomic_update)
-                  core->logMemoryHit(false, Core::WRITE, pa, Core::MEM_MODELED_COUNT, va2pa(inst.sinst->addr));
-               else
-                  core->accessMemory(
-                        /*(is_atomic_update) ? Core::UNLOCK :*/ Core::NONE,
-                        Core::WRITE,
-                        pa,
-                        NULL,
-                        xed_decoded_inst_get_memory_operand_length(&xed_inst, mem_idx),
-                        Core::MEM_MODELED_COUNT,
-                        va2pa(inst.sinst->addr));
-            }
          }
       }
    }
@@ -601,9 +653,16 @@ void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, Sift::Instr
 
    // Set up instruction
 
-   if (m_icache.count(inst.sinst->addr) == 0)
-      m_icache[inst.sinst->addr] = decode(inst);
-   Instruction *ins = m_icache[inst.sinst->addr];
+   Instruction* &ins = m_icache[inst.sinst->addr];
+   if (!ins)
+   {
+      // Other threads running the same code may have decoded this instruction already
+      DecodedInstructionCache *decoded_cache = Sim()->getTraceManager()->getDecodedInstructionCache();
+      IntPtr pa = va2pa(inst.sinst->addr);
+      ins = decoded_cache->find(pa, inst.sinst->data, inst.sinst->size);
+      if (!ins)
+         ins = decoded_cache->insert(pa, inst.sinst->data, inst.sinst->size, decode(inst));
+   }
    DynamicInstruction *dynins = prfmdl->createDynamicInstruction(ins, va2pa(inst.sinst->addr));
 
    // Add dynamic instruction info
@@ -635,13 +694,28 @@ void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, Sift::Instr
       }
    }
 
-   // Push instruction
+   // Push instruction, the performance model simulates a whole basic block at a time
 
-   prfmdl->queueInstruction(dynins);
+   if (m_num_pending && prfmdl != m_pending_prfmdl)
+      flushInstructions();
 
-   // simulate
+   m_pending[m_num_pending++] = dynins;
+   m_pending_prfmdl = prfmdl;
 
-   prfmdl->iterate();
+   if (inst.is_branch || m_num_pending == MAX_PENDING_INSTRUCTIONS)
+      flushInstructions();
+}
+
+void TraceThread::flushInstructions()
+{
+   // Any callback from the SIFT reader happens after the instructions we are holding,
+   // so they must reach the performance model (and be simulated) first
+   if (m_num_pending)
+   {
+      m_pending_prfmdl->queueInstructions(m_pending, m_num_pending);
+      m_num_pending = 0;
+      m_pending_prfmdl->iterate();
+   }
 }
 
 void TraceThread::addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const xed_decoded_inst_t &xed_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_prefetch, PerformanceModel *prfmdl)
@@ -714,6 +788,14 @@ void TraceThread::run()
    m_trace.initStream();
    m_trace_has_pa = m_trace.getTraceHasPhysicalAddresses();
 
+   if (m_start_instruction)
+   {
+      if (!m_trace.Seek(m_start_instruction))
+         LOG_PRINT_ERROR("Cannot start trace %s at instruction %" PRId64 ", it needs to be an indexed trace (record-trace --index) of at least that length",
+                         m_tracefile.c_str(), m_start_instruction);
+      printf("[TRACE:%u] -- START AT %" PRId64 " --\n", m_thread->getId(), m_start_instruction);
+   }
+
    if (m_thread->getCore() == NULL)
    {
       // We didn't get scheduled on startup, wait here
@@ -726,6 +808,7 @@ void TraceThread::run()
 
    Sift::Instruction inst, next_inst;
 
+   UInt64 icount = 0;
    bool have_first = m_trace.Read(inst);
    // Received first instruction, let TraceManager know our SIFT connection is up and running
    Sim()->getTraceManager()->signalStarted();
@@ -767,12 +850,17 @@ void TraceThread::run()
       m_bbv_end = inst.is_branch;
 
 
+      // Instructions staged in detailed mode must reach the performance model before we start warming or skipping
+      if (m_num_pending && Sim()->getInstrumentationMode() != InstMode::DETAILED)
+         flushInstructions();
+
       switch(Sim()->getInstrumentationMode())
       {
          case InstMode::FAST_FORWARD:
             break;
 
          case InstMode::CACHE_ONLY:
+         case InstMode::FUNCTIONAL:
             handleInstructionWarmup(inst, next_inst, core, do_icache_warmup, icache_warmup_addr, icache_warmup_size);
             break;
 
@@ -788,20 +876,30 @@ void TraceThread::run()
       // We may have been rescheduled to a different core
       // by prfmdl->iterate (in handleInstructionDetailed),
       // or core->countInstructions (when using a fast-forward performance model)
-      SubsecondTime time = prfmdl->getElapsedTime();
-      if (m_thread->reschedule(time, core))
+      // Only move once the instructions of the current basic block have been simulated
+      if (m_num_pending == 0)
       {
-         core = m_thread->getCore();
-         prfmdl = core->getPerformanceModel();
+         SubsecondTime time = prfmdl->getElapsedTime();
+         if (m_thread->reschedule(time, core))
+         {
+            core = m_thread->getCore();
+            prfmdl = core->getPerformanceModel();
+         }
       }
 
 
       if (m_stop)
          break;
 
+      // End of the trace segment, behave as if the trace ended here
+      if (m_num_instructions && ++icount == m_num_instructions)
+         break;
+
       inst = next_inst;
    }
 
+   flushInstructions();
+
    printf("[TRACE:%u] -- %s --\n", m_thread->getId(), m_stop ? "STOP" : "DONE");
 
    SubsecondTime time_end = prfmdl->getElapsedTime();
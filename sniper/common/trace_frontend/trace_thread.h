@@ -39,6 +39,21 @@ class TraceThread : public Runnable
       static const UInt64 va_page_shift = 12;
       static const UInt64 va_page_mask = (UInt64(1) << va_page_shift) - 1;
 
+      // Memory operands of a static instruction, decoded once for replay in cache-only and functional modes
+      struct MemoryOperands
+      {
+         static const UInt32 MAX_OPERANDS = 4;
+         bool is_atomic_update;
+         bool is_prefetch;
+         UInt32 num_operands;
+         struct
+         {
+            bool is_read;
+            bool is_write;
+            UInt32 size;
+         } operands[MAX_OPERANDS];
+      };
+
       static UInt64 _va2pa(UInt64 self, UInt64 va) { return ((TraceThread*)self)->va2pa(va); }
       UInt64 va2pa(UInt64 va, bool *noMapping = NULL);
       UInt64 remapAddress(UInt64 va_page);
@@ -52,7 +67,10 @@ class TraceThread : public Runnable
       bool m_appid_from_coreid;
       uint8_t m_address_randomization_table[256];
       bool m_stop;
-      std::unordered_map<IntPtr, Instruction *> m_icache;
+      Sift::PageTable<Instruction *> m_icache;
+      Sift::PageTable<const MemoryOperands *> m_memops;
+      // Replay memory accesses only, without warming up the branch predictor
+      const bool m_memory_only;
       UInt64 m_bbv_base;
       UInt64 m_bbv_count;
       UInt64 m_bbv_last;
@@ -66,6 +84,15 @@ class TraceThread : public Runnable
       bool m_blocked;
       bool m_cleanup;
       bool m_started;
+      // Trace segment to simulate: first instruction (requires an indexed trace) and length (0 = until the end)
+      UInt64 m_start_instruction;
+      UInt64 m_num_instructions;
+
+      // Detailed instructions of the current basic block, handed to the performance model together
+      static const UInt32 MAX_PENDING_INSTRUCTIONS = 64;
+      DynamicInstruction *m_pending[MAX_PENDING_INSTRUCTIONS];
+      UInt32 m_num_pending;
+      PerformanceModel *m_pending_prfmdl;
 
       void run();
       static Sift::Mode __handleInstructionCountFunc(void* arg, uint32_t icount)
@@ -104,9 +131,11 @@ class TraceThread : public Runnable
       void handleRoutineAnnounceFunc(uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename);
 
       Instruction* decode(Sift::Instruction &inst);
+      const MemoryOperands* getMemoryOperands(const Sift::StaticInstruction *sinst);
       void handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size);
       void handleInstructionDetailed(Sift::Instruction &inst, Sift::Instruction &next_inst, PerformanceModel *prfmdl);
       void addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const xed_decoded_inst_t &xed_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_pretetch, PerformanceModel *prfmdl);
+      void flushInstructions();
       void unblock();
 
       SubsecondTime getCurrentTime() const;
@@ -116,7 +145,7 @@ class TraceThread : public Runnable
    public:
       bool m_stopped;
 
-      TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup);
+      TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup, UInt64 start_instruction = 0, UInt64 num_instructions = 0);
       ~TraceThread();
 
       void spawn();
@@ -21,6 +21,7 @@
 #define SIM_OPT_INSTRUMENT_DETAILED    0
 #define SIM_OPT_INSTRUMENT_WARMUP      1
 #define SIM_OPT_INSTRUMENT_FASTFORWARD 2
+#define SIM_OPT_INSTRUMENT_FUNCTIONAL  3
 
 
 #if defined(__i386)
@@ -9,6 +9,8 @@
 #define INSTR_IF_NOT_CACHEONLY(__inst_mode)    ((__inst_mode) != InstMode::CACHE_ONLY)
 #define INSTR_IF_FASTFORWARD(__inst_mode)      ((__inst_mode) == InstMode::FAST_FORWARD)
 #define INSTR_IF_NOT_FASTFORWARD(__inst_mode)  ((__inst_mode) != InstMode::FAST_FORWARD)
+#define INSTR_IF_FUNCTIONAL(__inst_mode)       ((__inst_mode) == InstMode::FUNCTIONAL)
+#define INSTR_IF_WARMUP(__inst_mode)           (InstMode::isWarmup(__inst_mode))
 
 #define __INSTRUMENT(predicated, condition, trace, ins, point, func, ...) \
    if (condition)                                                         \
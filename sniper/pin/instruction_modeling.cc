@@ -241,7 +241,7 @@ VOID InstructionModeling::addInstructionModeling(TRACE trace, INS ins, InstMode:
    {
       // In warming mode, warm up the branch predictors
       INSTRUMENT_PREDICATED(
-         INSTR_IF_CACHEONLY(inst_mode),
+         INSTR_IF_WARMUP(inst_mode),
          trace, ins, IPOINT_TAKEN_BRANCH, (AFUNPTR)handleBranchWarming,
          IARG_THREAD_ID,
          IARG_ADDRINT, INS_Address(ins),
@@ -250,7 +250,7 @@ VOID InstructionModeling::addInstructionModeling(TRACE trace, INS ins, InstMode:
          IARG_END);
 
       INSTRUMENT_PREDICATED(
-         INSTR_IF_CACHEONLY(inst_mode),
+         INSTR_IF_WARMUP(inst_mode),
          trace, ins, IPOINT_AFTER, (AFUNPTR)handleBranchWarming,
          IARG_THREAD_ID,
          IARG_ADDRINT, INS_Address(ins),
@@ -17,6 +17,12 @@ namespace lite
 
 Lock g_atomic_lock;
 
+// Non-detailed accesses are counted in cache-only mode, functional warming only updates cache contents
+static Core::MemModeled warmupModeled()
+{
+   return Sim()->getInstrumentationMode() == InstMode::FUNCTIONAL ? Core::MEM_MODELED_WARMUP : Core::MEM_MODELED_COUNT;
+}
+
 void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
 {
    if (INS_IsMemoryRead (ins) || INS_IsMemoryWrite (ins))
@@ -41,7 +47,7 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
                      IARG_END);
 
                INSTRUMENT(
-                     INSTR_IF_CACHEONLY(inst_mode),
+                     INSTR_IF_WARMUP(inst_mode),
                      trace, ins, IPOINT_BEFORE,
                      AFUNPTR(lite::handleMemoryReadFaultinjection),
                      IARG_THREAD_ID,
@@ -97,6 +103,19 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
                      IARG_UINT32, i,
                      IARG_END);
 
+               INSTRUMENT(
+                     INSTR_IF_FUNCTIONAL(inst_mode),
+                     trace, ins, IPOINT_BEFORE,
+                     AFUNPTR(lite::handleMemoryReadFunctional),
+                     IARG_THREAD_ID,
+                     IARG_EXECUTING,
+                     IARG_ADDRINT, INS_Address(ins),
+                     IARG_BOOL, INS_MemoryOperandIsWritten(ins, i) ? INS_IsAtomicUpdate(ins) : false,
+                     IARG_MEMORYOP_EA, i,
+                     IARG_UINT32, INS_MemoryOperandSize(ins, i),
+                     IARG_UINT32, i,
+                     IARG_END);
+
                INSTRUMENT(
                      INSTR_IF_DETAILED(inst_mode),
                      trace, ins, IPOINT_BEFORE,
@@ -120,7 +139,7 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
             if (Sim()->getFaultinjectionManager())
             {
                INSTRUMENT(
-                     INSTR_IF_CACHEONLY(inst_mode),
+                     INSTR_IF_WARMUP(inst_mode),
                      trace, ins, IPOINT_BEFORE,
                      AFUNPTR(lite::handleMemoryWriteFaultinjection),
                      IARG_THREAD_ID,
@@ -158,6 +177,19 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
                      IARG_UINT32, i,
                      IARG_END);
 
+               INSTRUMENT(
+                     INSTR_IF_FUNCTIONAL(inst_mode),
+                     trace, ins, IPOINT_BEFORE,
+                     AFUNPTR(lite::handleMemoryWriteFunctional),
+                     IARG_THREAD_ID,
+                     IARG_EXECUTING,
+                     IARG_ADDRINT, INS_Address(ins),
+                     IARG_BOOL, INS_IsAtomicUpdate(ins),
+                     IARG_MEMORYOP_EA, i,
+                     IARG_UINT32, INS_MemoryOperandSize(ins, i),
+                     IARG_UINT32, i,
+                     IARG_END);
+
                INSTRUMENT(
                      INSTR_IF_DETAILED(inst_mode),
                      trace, ins, IPOINT_BEFORE,
@@ -184,6 +216,22 @@ void handleMemoryRead(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_a
       core->accessMemoryFast(false, Core::READ, read_address);
 }
 
+void handleMemoryReadFunctional(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr read_address, UInt32 read_data_size)
+{
+   // Functional warming: update cache and TLB contents without counting the access
+   Core *core = localStore[thread_id].thread->getCore();
+   assert(core);
+   if (executing)
+      core->accessMemory(
+            Core::NONE,
+            (is_atomic_update) ? Core::READ_EX : Core::READ,
+            read_address,
+            NULL,
+            read_data_size,
+            Core::MEM_MODELED_WARMUP,
+            eip);
+}
+
 void handleMemoryReadDetailed(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr read_address, UInt32 read_data_size)
 {
    // Detailed mode: core model will do its own access, just log the address
@@ -251,7 +299,7 @@ ADDRINT handleMemoryReadFaultinjection(THREADID thread_id, BOOL executing, ADDRI
             read_address,
             buf_fault,
             read_data_size,
-            eip ? Core::MEM_MODELED_RETURN : Core::MEM_MODELED_COUNT,
+            eip ? Core::MEM_MODELED_RETURN : warmupModeled(),
             eip,
             SubsecondTime::MaxTime(),
             true);
@@ -301,6 +349,21 @@ void handleMemoryWrite(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_
       core->accessMemoryFast(false, Core::WRITE, write_address);
 }
 
+void handleMemoryWriteFunctional(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr write_address, UInt32 write_data_size)
+{
+   // The write of an atomic update hits the line its read just brought in, and hits are not counted here
+   Core* core = localStore[thread_id].thread->getCore();
+   if (executing && !is_atomic_update)
+      core->accessMemory(
+            Core::NONE,
+            Core::WRITE,
+            write_address,
+            NULL,
+            write_data_size,
+            Core::MEM_MODELED_WARMUP,
+            eip);
+}
+
 void handleMemoryWriteDetailed(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr write_address, UInt32 write_data_size)
 {
    /* Optimization for atomic instructions: we know the second (write) access will be a hit. Also, since this is Lite mode,
@@ -373,7 +436,8 @@ void handleMemoryWriteFaultinjection(THREADID thread_id, BOOL executing, ADDRINT
             SubsecondTime::MaxTime(),
             false);
 
-      core->logMemoryHit(false, Core::WRITE, write_address, eip ? Core::MEM_MODELED_RETURN : Core::MEM_MODELED_COUNT, eip);
+      if (eip || warmupModeled() != Core::MEM_MODELED_WARMUP)
+         core->logMemoryHit(false, Core::WRITE, write_address, eip ? Core::MEM_MODELED_RETURN : Core::MEM_MODELED_COUNT, eip);
       if (eip)
       {
          assert(localStore[thread_id].dynins);
@@ -388,7 +452,7 @@ void handleMemoryWriteFaultinjection(THREADID thread_id, BOOL executing, ADDRINT
             write_address,
             g_zeros,
             write_data_size,
-            eip ? Core::MEM_MODELED_RETURN : Core::MEM_MODELED_COUNT,
+            eip ? Core::MEM_MODELED_RETURN : warmupModeled(),
             eip,
             SubsecondTime::MaxTime(),
             false);
@@ -207,6 +207,7 @@ VOID traceCallback(TRACE trace, void *v)
    SWITCH_VERSION(InstMode::DETAILED)
    SWITCH_VERSION(InstMode::CACHE_ONLY)
    SWITCH_VERSION(InstMode::FAST_FORWARD)
+   SWITCH_VERSION(InstMode::FUNCTIONAL)
 
    // Version 0 is only for startup / amnesia, don't do anything else there
    if (TRACE_Version(trace) == 0)
@@ -256,7 +257,7 @@ VOID traceCallback(TRACE trace, void *v)
       // I-cache modeling during warmup
       if (Sim()->getConfig()->getEnableICacheModeling()) {
          INSTRUMENT(
-            INSTR_IF_CACHEONLY(inst_mode),
+            INSTR_IF_WARMUP(inst_mode),
             trace, BBL_InsHead(bbl), IPOINT_BEFORE,
             AFUNPTR(InstructionModeling::accessInstructionCacheWarmup),
             IARG_THREAD_ID,
@@ -5,8 +5,9 @@
 # run Z instructions in detailed mode,
 # and then fast-forward to the end.
 # X can be roi+X for ROI-relative start
+# With a fourth argument 'stop', the simulation ends right after the detailed region
 #
-# run-sniper --roi-script --no-cache-warming -s roi-icount:X:Y:Z
+# run-sniper --roi-script --no-cache-warming -s roi-icount:X:Y:Z[:stop]
 #
 # Start the simulation with "--roi-script --no-cache-warming"
 # to start in fast-forward mode and ignore SimRoi{Start,End}
@@ -34,6 +35,7 @@ class RoiIcount:
     self.init_length = long(start or 0)
     self.warmup_length = long(args.get(1, '') or 0)
     self.detailed_length = long(args.get(2, '') or 0)
+    self.stop = args.get(3, '') == 'stop'
 
     if self.detailed_length < 1:
       print >> sys.stderr, '[ROI-ICOUNT] Detailed instrucion count cannot be 0'
@@ -83,6 +85,9 @@ class RoiIcount:
       print '[ROI-ICOUNT] Icount = %d: ending ROI' % icount
       sim.control.set_roi(False)
       self.state = 'done'
+      if self.stop:
+        sim.control.abort()
+        return
 
     if self.state in ('init', 'warmup') and icount >= self.offset + self.init_length + self.warmup_length:
       print '[ROI-ICOUNT] Icount = %d: beginning ROI' % icount
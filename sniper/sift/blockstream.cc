@@ -0,0 +1,540 @@
+#include "blockstream.h"
+#include "sift_format.h"
+#include "sift_assert.h"
+
+#include <cstring>
+#include <algorithm>
+#include <time.h>
+
+#ifdef SIFT_HAVE_ZSTD
+# include <zstd.h>
+#endif
+#ifdef SIFT_HAVE_LZ4
+# include <lz4.h>
+#endif
+
+static uint64_t now_ns()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#ifdef SIFT_HAVE_ZSTD
+class ZstdCodec : public BlockCodec
+{
+   private:
+      static const int level = 3;
+   public:
+      virtual const char* getName() const { return "zstd"; }
+      virtual size_t bound(size_t n) const { return ZSTD_compressBound(n); }
+      virtual size_t compress(const char *src, size_t n, char *dst, size_t capacity) const
+      {
+         size_t ret = ZSTD_compress(dst, capacity, src, n, level);
+         return ZSTD_isError(ret) ? 0 : ret;
+      }
+      virtual bool decompress(const char *src, size_t compressed_size, char *dst, size_t n) const
+      {
+         size_t ret = ZSTD_decompress(dst, n, src, compressed_size);
+         return !ZSTD_isError(ret) && ret == n;
+      }
+};
+#endif
+
+#ifdef SIFT_HAVE_LZ4
+class Lz4Codec : public BlockCodec
+{
+   public:
+      virtual const char* getName() const { return "lz4"; }
+      virtual size_t bound(size_t n) const { return LZ4_compressBound(n); }
+      virtual size_t compress(const char *src, size_t n, char *dst, size_t capacity) const
+      {
+         int ret = LZ4_compress_default(src, dst, n, capacity);
+         return ret > 0 ? ret : 0;
+      }
+      virtual bool decompress(const char *src, size_t compressed_size, char *dst, size_t n) const
+      {
+         int ret = LZ4_decompress_safe(src, dst, compressed_size, n);
+         return ret >= 0 && size_t(ret) == n;
+      }
+};
+#endif
+
+BlockCodec* BlockCodec::create(uint64_t option)
+{
+   switch(option)
+   {
+#ifdef SIFT_HAVE_ZSTD
+      case Sift::CompressionZstd:
+         return new ZstdCodec();
+#endif
+#ifdef SIFT_HAVE_LZ4
+      case Sift::CompressionLZ4:
+         return new Lz4Codec();
+#endif
+      default:
+         return NULL;
+   }
+}
+
+
+
+namespace
+{
+   struct PthreadHandle
+   {
+      pthread_t thread;
+      void (*func)(void*);
+      void *arg;
+   };
+
+   void* pthreadStart(void *arg)
+   {
+      PthreadHandle *handle = (PthreadHandle*)arg;
+      handle->func(handle->arg);
+      return NULL;
+   }
+
+   void* pthreadSpawn(void (*func)(void*), void *arg)
+   {
+      PthreadHandle *handle = new PthreadHandle;
+      handle->func = func;
+      handle->arg = arg;
+      if (pthread_create(&handle->thread, NULL, pthreadStart, handle) != 0)
+      {
+         delete handle;
+         return NULL;
+      }
+      return handle;
+   }
+
+   void pthreadJoin(void *arg)
+   {
+      PthreadHandle *handle = (PthreadHandle*)arg;
+      pthread_join(handle->thread, NULL);
+      delete handle;
+   }
+
+   const BlockThreadFuncs pthread_funcs = { pthreadSpawn, pthreadJoin };
+}
+
+oblockstream::oblockstream(vostream *output, BlockCodec *codec, unsigned int num_threads, const BlockThreadFuncs *thread_funcs, size_t blocksize)
+   : output(output)
+   , codec(codec)
+   , blocksize(blocksize)
+   , blocks(2 * num_threads + 2)
+   , fill_index(0)
+   , compress_index(0)
+   , write_index(0)
+   , in_flight(0)
+   , thread_funcs(thread_funcs ? thread_funcs : &pthread_funcs)
+   , threads(num_threads)
+   , stopping(false)
+   , finished(false)
+   , num_blocks(0)
+   , bytes_in(0)
+   , bytes_out(0)
+   , time_ns(0)
+{
+   sift_assert(codec);
+   sift_assert(blocksize < (1ull << 32));
+   for(size_t i = 0; i < blocks.size(); ++i)
+   {
+      blocks[i].state = BLOCK_FREE;
+      blocks[i].data.reserve(blocksize);
+   }
+
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&cond_queued, NULL);
+   pthread_cond_init(&cond_done, NULL);
+   for(size_t i = 0; i < threads.size(); ++i)
+   {
+      threads[i] = this->thread_funcs->spawn(workerThread, this);
+      sift_assert(threads[i]);
+   }
+}
+
+oblockstream::~oblockstream()
+{
+   finish();
+
+   pthread_mutex_lock(&lock);
+   stopping = true;
+   pthread_cond_broadcast(&cond_queued);
+   pthread_mutex_unlock(&lock);
+   for(size_t i = 0; i < threads.size(); ++i)
+      thread_funcs->join(threads[i]);
+
+   pthread_cond_destroy(&cond_done);
+   pthread_cond_destroy(&cond_queued);
+   pthread_mutex_destroy(&lock);
+
+   output->flush();
+   delete output;
+   delete codec;
+}
+
+void oblockstream::write(const char* s, std::streamsize n)
+{
+   while(n > 0)
+   {
+      std::vector<char> &data = blocks[fill_index].data;
+      size_t count = std::min(size_t(n), blocksize - data.size());
+      data.insert(data.end(), s, s + count);
+      s += count;
+      n -= count;
+      if (data.size() == blocksize)
+         submit();
+   }
+}
+
+void oblockstream::flush()
+{
+   // Like ozstream, do not cut the current block short: only write out blocks that are done already
+   writeBlocks(false);
+   output->flush();
+}
+
+uint64_t oblockstream::cut()
+{
+   if (blocks[fill_index].data.size())
+      submit();
+   return num_blocks;
+}
+
+void oblockstream::finish()
+{
+   if (finished)
+      return;
+
+   cut();
+   while(in_flight)
+      writeBlocks(true);
+
+   BlockHeader hdr = { 0, 0 };
+   output->write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   bytes_out += sizeof(hdr);
+   output->flush();
+
+   finished = true;
+}
+
+void oblockstream::compressBlock(Block &block)
+{
+   uint64_t start = now_ns();
+
+   size_t size = block.data.size();
+   block.frame.resize(sizeof(BlockHeader) + codec->bound(size));
+   size_t compressed_size = codec->compress(&block.data[0], size, &block.frame[sizeof(BlockHeader)], block.frame.size() - sizeof(BlockHeader));
+   if (compressed_size == 0 || compressed_size >= size)
+   {
+      // Incompressible, store as-is
+      block.frame.resize(sizeof(BlockHeader) + size);
+      memcpy(&block.frame[sizeof(BlockHeader)], &block.data[0], size);
+      compressed_size = size;
+   }
+   block.frame.resize(sizeof(BlockHeader) + compressed_size);
+
+   BlockHeader hdr = { uint32_t(compressed_size), uint32_t(size) };
+   memcpy(&block.frame[0], &hdr, sizeof(hdr));
+
+   block.time_ns = now_ns() - start;
+}
+
+void oblockstream::submit()
+{
+   Block &block = blocks[fill_index];
+   sift_assert(!finished);
+   ++num_blocks;
+
+   if (threads.empty())
+   {
+      compressBlock(block);
+      block.state = BLOCK_DONE;
+   }
+   else
+   {
+      pthread_mutex_lock(&lock);
+      block.state = BLOCK_QUEUED;
+      pthread_cond_signal(&cond_queued);
+      pthread_mutex_unlock(&lock);
+   }
+
+   ++in_flight;
+   fill_index = (fill_index + 1) % blocks.size();
+   // When the ring is full, the next block to fill is the oldest one: wait until it has been written out
+   while(in_flight == blocks.size())
+      writeBlocks(true);
+}
+
+void oblockstream::writeBlocks(bool wait)
+{
+   // Write out finished blocks in order, optionally waiting for the oldest one to finish
+   while(in_flight)
+   {
+      Block &block = blocks[write_index];
+
+      pthread_mutex_lock(&lock);
+      while(wait && (block.state == BLOCK_QUEUED || block.state == BLOCK_COMPRESSING))
+         pthread_cond_wait(&cond_done, &lock);
+      bool done = block.state == BLOCK_DONE;
+      pthread_mutex_unlock(&lock);
+
+      if (!done)
+         break;
+      wait = false;
+
+      block_offsets.push_back(bytes_out);
+      output->write(&block.frame[0], block.frame.size());
+      bytes_in += block.data.size();
+      bytes_out += block.frame.size();
+      time_ns += block.time_ns;
+      block.data.clear();
+
+      pthread_mutex_lock(&lock);
+      block.state = BLOCK_FREE;
+      pthread_mutex_unlock(&lock);
+      write_index = (write_index + 1) % blocks.size();
+      --in_flight;
+   }
+}
+
+void oblockstream::workerThread(void *arg)
+{
+   oblockstream *self = (oblockstream*)arg;
+
+   pthread_mutex_lock(&self->lock);
+   while(true)
+   {
+      Block &block = self->blocks[self->compress_index];
+      if (block.state == BLOCK_QUEUED)
+      {
+         block.state = BLOCK_COMPRESSING;
+         self->compress_index = (self->compress_index + 1) % self->blocks.size();
+         pthread_mutex_unlock(&self->lock);
+
+         self->compressBlock(block);
+
+         pthread_mutex_lock(&self->lock);
+         block.state = BLOCK_DONE;
+         pthread_cond_broadcast(&self->cond_done);
+      }
+      else if (self->stopping)
+         break;
+      else
+         pthread_cond_wait(&self->cond_queued, &self->lock);
+   }
+   pthread_mutex_unlock(&self->lock);
+}
+
+bool oblockstream::getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const
+{
+   compressed = bytes_out;
+   uncompressed = bytes_in;
+   ns = time_ns;
+   return true;
+}
+
+
+
+iblockstream::iblockstream(vistream *input, BlockCodec *codec, bool read_ahead, unsigned int num_blocks)
+   : input(input)
+   , codec(codec)
+   , blocks(read_ahead ? num_blocks : 1)
+   , read_index(0)
+   , fill_index(0)
+   , offset(0)
+   , have_block(false)
+   , have_thread(read_ahead)
+   , stopping(false)
+   , input_done(false)
+   , m_eof(false)
+   , m_fail(false)
+   , peek_valid(false)
+   , position(0)
+   , bytes_in(0)
+   , bytes_out(0)
+   , time_ns(0)
+{
+   sift_assert(codec);
+   for(size_t i = 0; i < blocks.size(); ++i)
+      blocks[i].state = BLOCK_FREE;
+
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&cond_full, NULL);
+   pthread_cond_init(&cond_free, NULL);
+   if (have_thread)
+   {
+      int ret = pthread_create(&thread, NULL, readAheadThread, this);
+      sift_assert(ret == 0);
+   }
+}
+
+iblockstream::~iblockstream()
+{
+   if (have_thread)
+   {
+      pthread_mutex_lock(&lock);
+      stopping = true;
+      pthread_cond_broadcast(&cond_free);
+      pthread_mutex_unlock(&lock);
+      pthread_join(thread, NULL);
+   }
+
+   pthread_cond_destroy(&cond_free);
+   pthread_cond_destroy(&cond_full);
+   pthread_mutex_destroy(&lock);
+
+   delete input;
+   delete codec;
+}
+
+bool iblockstream::fetchBlock(Block &block)
+{
+   BlockHeader hdr;
+   input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (input->fail())
+      return false;
+   if (hdr.compressed_size == 0 && hdr.uncompressed_size == 0)
+      return false;
+
+   block.compressed.resize(hdr.compressed_size);
+   block.data.resize(hdr.uncompressed_size);
+   block.frame_size = sizeof(hdr) + hdr.compressed_size;
+   input->read(&block.compressed[0], hdr.compressed_size);
+   sift_assert(!input->fail());
+
+   uint64_t start = now_ns();
+   if (hdr.compressed_size == hdr.uncompressed_size)
+      memcpy(&block.data[0], &block.compressed[0], hdr.uncompressed_size);
+   else
+   {
+      bool ok = codec->decompress(&block.compressed[0], hdr.compressed_size, &block.data[0], hdr.uncompressed_size);
+      sift_assert(ok);
+   }
+   block.time_ns = now_ns() - start;
+
+   return true;
+}
+
+void* iblockstream::readAheadThread(void *arg)
+{
+   iblockstream *self = (iblockstream*)arg;
+
+   while(true)
+   {
+      Block &block = self->blocks[self->fill_index];
+
+      pthread_mutex_lock(&self->lock);
+      while(block.state != BLOCK_FREE && !self->stopping)
+         pthread_cond_wait(&self->cond_free, &self->lock);
+      bool stopping = self->stopping;
+      pthread_mutex_unlock(&self->lock);
+      if (stopping)
+         break;
+
+      bool ok = self->fetchBlock(block);
+
+      pthread_mutex_lock(&self->lock);
+      if (ok)
+         block.state = BLOCK_FULL;
+      else
+         self->input_done = true;
+      pthread_cond_signal(&self->cond_full);
+      pthread_mutex_unlock(&self->lock);
+
+      if (!ok)
+         break;
+      self->fill_index = (self->fill_index + 1) % self->blocks.size();
+   }
+
+   return NULL;
+}
+
+bool iblockstream::nextBlock()
+{
+   // Release the block we just consumed, and wait for the next one to be available
+   if (have_block)
+   {
+      Block &prev = blocks[read_index];
+      bytes_in += prev.frame_size;
+      bytes_out += prev.data.size();
+      time_ns += prev.time_ns;
+      position += prev.frame_size;
+
+      pthread_mutex_lock(&lock);
+      prev.state = BLOCK_FREE;
+      pthread_cond_signal(&cond_free);
+      pthread_mutex_unlock(&lock);
+      read_index = (read_index + 1) % blocks.size();
+      have_block = false;
+   }
+   offset = 0;
+
+   Block &block = blocks[read_index];
+   if (have_thread)
+   {
+      pthread_mutex_lock(&lock);
+      while(block.state != BLOCK_FULL && !input_done)
+         pthread_cond_wait(&cond_full, &lock);
+      have_block = block.state == BLOCK_FULL;
+      pthread_mutex_unlock(&lock);
+   }
+   else if (fetchBlock(block))
+   {
+      block.state = BLOCK_FULL;
+      have_block = true;
+   }
+
+   return have_block;
+}
+
+void iblockstream::read(char* s, std::streamsize n)
+{
+   if (peek_valid)
+   {
+      s[0] = peek_value;
+      peek_valid = false;
+      ++s;
+      --n;
+   }
+
+   while(n > 0)
+   {
+      if (!have_block || offset == blocks[read_index].data.size())
+      {
+         if (!nextBlock())
+         {
+            m_eof = true;
+            m_fail = true;
+            return;
+         }
+      }
+
+      Block *block = &blocks[read_index];
+      size_t count = std::min(size_t(n), block->data.size() - offset);
+      memcpy(s, &block->data[offset], count);
+      offset += count;
+      s += count;
+      n -= count;
+   }
+}
+
+int iblockstream::peek()
+{
+   if (peek_valid == true)
+      return peek_value;
+
+   read(&peek_value, 1);
+   peek_valid = true;
+
+   return peek_value;
+}
+
+bool iblockstream::getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const
+{
+   compressed = bytes_in;
+   uncompressed = bytes_out;
+   ns = time_ns;
+   return true;
+}
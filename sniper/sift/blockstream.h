@@ -0,0 +1,156 @@
+#ifndef __BLOCKSTREAM_H
+#define __BLOCKSTREAM_H
+
+#include "zfstream.h"
+
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+// Block-compressed streams: data is cut into blocks which are compressed independently,
+// and written out as a BlockHeader followed by compressed_size bytes of compressed data.
+// A block whose compressed_size equals its uncompressed_size is stored as-is,
+// a header with both sizes zero marks the end of the stream.
+// Since blocks do not depend on each other, the writer compresses them on a pool of worker threads,
+// and the reader decompresses ahead of the consumer on a background thread.
+
+typedef struct
+{
+   uint32_t compressed_size;
+   uint32_t uncompressed_size;
+} __attribute__ ((__packed__)) BlockHeader;
+
+class BlockCodec
+{
+   public:
+      virtual ~BlockCodec() {}
+      virtual const char* getName() const = 0;
+      // Maximum compressed size of n bytes of input
+      virtual size_t bound(size_t n) const = 0;
+      // Returns the compressed size, or zero on failure
+      virtual size_t compress(const char *src, size_t n, char *dst, size_t capacity) const = 0;
+      // Returns false if src does not decompress into exactly n bytes
+      virtual bool decompress(const char *src, size_t compressed_size, char *dst, size_t n) const = 0;
+
+      // Codec for one of the Sift::Compression* options, NULL when not supported by this build
+      static BlockCodec* create(uint64_t option);
+};
+
+// Thread creation for the compression workers, so Pin tools can use PIN_SpawnInternalThread instead of pthreads.
+// spawn runs func(arg) on a new thread and returns a handle for join, or NULL on failure.
+struct BlockThreadFuncs
+{
+   void* (*spawn)(void (*func)(void*), void *arg);
+   void (*join)(void *handle);
+};
+
+class oblockstream : public vostream
+{
+   private:
+      enum block_state_t { BLOCK_FREE, BLOCK_QUEUED, BLOCK_COMPRESSING, BLOCK_DONE };
+      struct Block
+      {
+         block_state_t state;
+         std::vector<char> data;
+         std::vector<char> frame;   // BlockHeader + compressed data
+         uint64_t time_ns;
+      };
+
+      vostream *output;
+      BlockCodec *codec;
+      const size_t blocksize;
+      std::vector<Block> blocks;    // Ring of blocks in flight
+      size_t fill_index;            // Block being filled by write()
+      size_t compress_index;        // Next block to be picked up by a worker
+      size_t write_index;           // Oldest block that has not been written out yet
+      size_t in_flight;             // Blocks submitted but not yet written out
+      const BlockThreadFuncs *thread_funcs;
+      std::vector<void*> threads;
+      pthread_mutex_t lock;
+      pthread_cond_t cond_queued;
+      pthread_cond_t cond_done;
+      bool stopping;
+      bool finished;
+      uint64_t num_blocks;          // Blocks submitted so far
+      std::vector<uint64_t> block_offsets;
+
+      uint64_t bytes_in, bytes_out, time_ns;
+
+      void compressBlock(Block &block);
+      void submit();
+      void writeBlocks(bool wait);
+      static void workerThread(void *arg);
+
+   public:
+      // Takes ownership of output and codec. Workers are started using pthreads when thread_funcs is NULL.
+      oblockstream(vostream *output, BlockCodec *codec, unsigned int num_threads, const BlockThreadFuncs *thread_funcs = NULL, size_t blocksize = 1 << 20);
+      virtual ~oblockstream();
+      virtual void write(const char* s, std::streamsize n);
+      virtual void flush();
+      virtual bool is_open()
+         { return output->is_open(); }
+      virtual bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const;
+
+      // End the current block so the next write starts a new one, returns the sequence number of that block
+      uint64_t cut();
+      // Write out all remaining blocks and the end-of-stream marker, after which the underlying stream can be appended to
+      void finish();
+      // Offset of block <seq> relative to the start of this stream, valid once the block was written out
+      uint64_t getBlockOffset(uint64_t seq) const { return block_offsets.at(seq); }
+      // Bytes written to the underlying stream so far
+      uint64_t getBytesWritten() const { return bytes_out; }
+};
+
+class iblockstream : public vistream
+{
+   private:
+      enum block_state_t { BLOCK_FREE, BLOCK_FULL };
+      struct Block
+      {
+         block_state_t state;
+         std::vector<char> data;
+         std::vector<char> compressed;
+         uint64_t frame_size;
+         uint64_t time_ns;
+      };
+
+      vistream *input;
+      BlockCodec *codec;
+      std::vector<Block> blocks;    // Ring of decompressed blocks
+      size_t read_index;            // Block being consumed by read()
+      size_t fill_index;            // Next block to be decompressed into
+      size_t offset;                // Read offset into blocks[read_index]
+      bool have_block;              // Whether blocks[read_index] is available to read()
+      bool have_thread;
+      pthread_t thread;
+      pthread_mutex_t lock;
+      pthread_cond_t cond_full;
+      pthread_cond_t cond_free;
+      bool stopping;
+      bool input_done;
+      bool m_eof;
+      bool m_fail;
+      char peek_value;
+      bool peek_valid;
+
+      uint64_t position;            // Compressed bytes consumed
+      uint64_t bytes_in, bytes_out, time_ns;
+
+      bool fetchBlock(Block &block);
+      bool nextBlock();
+      static void* readAheadThread(void *arg);
+
+   public:
+      // Takes ownership of input and codec
+      iblockstream(vistream *input, BlockCodec *codec, bool read_ahead = true, unsigned int num_blocks = 4);
+      virtual ~iblockstream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool eof() const { return m_eof; }
+      virtual bool fail() const { return m_fail; }
+      virtual bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const;
+      // Compressed bytes consumed so far
+      uint64_t getPosition() const { return position; }
+};
+
+#endif // __BLOCKSTREAM_H
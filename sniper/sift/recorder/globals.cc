@@ -17,6 +17,13 @@ KNOB<BOOL> KnobRoutineTracingOutsideDetailed(KNOB_MODE_WRITEONCE, "pintool", "rt
 KNOB<BOOL> KnobDebug(KNOB_MODE_WRITEONCE, "pintool", "debug", "0", "start debugger on internal exception");
 KNOB<BOOL> KnobVerbose(KNOB_MODE_WRITEONCE, "pintool", "verbose", "0", "verbose output");
 KNOB<UINT64> KnobStopAddress(KNOB_MODE_WRITEONCE, "pintool", "stop", "0", "stop address (0 = disabled)");
+KNOB<string> KnobCompression(KNOB_MODE_WRITEONCE, "pintool", "compress", "zlib", "trace compression: none, zlib, zstd or lz4 (ignored when using response files)");
+KNOB<UINT64> KnobCompressionThreads(KNOB_MODE_WRITEONCE, "pintool", "compress_threads", "2", "threads compressing trace blocks per output file (zstd and lz4 only)");
+KNOB<UINT64> KnobIndexInterval(KNOB_MODE_WRITEONCE, "pintool", "index", "0", "write a seek index every N instructions (requires zstd or lz4 compression, 0 = disabled)");
+KNOB<BOOL> KnobSharedMemory(KNOB_MODE_WRITEONCE, "pintool", "shm", "0", "send the trace and responses through shared memory instead of the FIFOs (response files only)");
+KNOB<BOOL> KnobAddressDelta(KNOB_MODE_WRITEONCE, "pintool", "address_delta", "1", "encode addresses as deltas (disable for traces that need to be read by older versions)");
+KNOB<BOOL> KnobMemoryOnly(KNOB_MODE_WRITEONCE, "pintool", "memory_only", "0", "only record memory accesses and branches, for cache-only simulation (ignored when using response files)");
+KNOB<UINT64> KnobBbvProfile(KNOB_MODE_WRITEONCE, "pintool", "bbvprofile", "0", "only write out a basic-block vector every N instructions, no trace (0 = disabled)");
 
 KNOB_COMMENT pinplay_driver_knob_family(KNOB_FAMILY, "PinPlay SIFT Recorder Knobs");
 KNOB<BOOL>KnobReplayer(KNOB_MODE_WRITEONCE, KNOB_FAMILY,
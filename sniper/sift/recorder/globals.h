@@ -35,6 +35,13 @@ extern KNOB<BOOL> KnobRoutineTracingOutsideDetailed;
 extern KNOB<BOOL> KnobDebug;
 extern KNOB<BOOL> KnobVerbose;
 extern KNOB<UINT64> KnobStopAddress;
+extern KNOB<string> KnobCompression;
+extern KNOB<UINT64> KnobCompressionThreads;
+extern KNOB<UINT64> KnobIndexInterval;
+extern KNOB<BOOL> KnobSharedMemory;
+extern KNOB<BOOL> KnobAddressDelta;
+extern KNOB<BOOL> KnobMemoryOnly;
+extern KNOB<UINT64> KnobBbvProfile;
 extern KNOB<UINT64> KnobExtraePreLoaded;
 
 # define KNOB_REPLAY_NAME "replay"
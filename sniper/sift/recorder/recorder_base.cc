@@ -30,10 +30,19 @@ VOID countInsns(THREADID threadid, INT32 count)
          openFile(threadid);
       thread_data[threadid].icount = 0;
       in_roi = true;
-      setInstrumentationMode(Sift::ModeDetailed);
+      setInstrumentationMode(getRoiMode());
    }
 }
 
+VOID countBbvProfile(THREADID threadid, ADDRINT address, INT32 count)
+{
+   thread_data[threadid].icount += count;
+   thread_data[threadid].bbv->count(address, count);
+
+   if (thread_data[threadid].bbv->getInstructionCount() >= KnobBbvProfile.Value())
+      writeBbvProfile(threadid);
+}
+
 VOID sendInstruction(THREADID threadid, ADDRINT addr, UINT32 size, UINT32 num_addresses, BOOL is_branch, BOOL taken, BOOL is_predicate, BOOL executing, BOOL isbefore, BOOL ispause)
 {
    // We're still called for instructions in the same basic block as ROI end, ignore these
@@ -131,12 +140,20 @@ VOID sendCacheOnly(THREADID threadid, UINT32 icount, UINT32 type, ADDRINT eip, A
    thread_data[threadid].icount_reported += thread_data[threadid].icount_cacheonly_pending;
    thread_data[threadid].icount_cacheonly_pending = 0;
 
-   if (thread_data[threadid].icount_reported > KnobFlowControlFF.Value())
+   if (KnobUseResponseFiles.Value() && thread_data[threadid].icount_reported > KnobFlowControlFF.Value())
    {
       Sift::Mode mode = thread_data[threadid].output->Sync();
       thread_data[threadid].icount_reported = 0;
       setInstrumentationMode(mode);
    }
+
+   // Only memory-only recordings count CacheOnly instructions towards -d, warmup requested through response files does not
+   if (detailed_target != 0 && getRoiMode() == Sift::ModeMemory && thread_data[threadid].icount_cacheonly >= detailed_target)
+   {
+      closeFile(threadid);
+      PIN_Detach();
+      return;
+   }
 }
 
 VOID handleMemory(THREADID threadid, ADDRINT address)
@@ -201,6 +218,14 @@ static VOID traceCallback(TRACE trace, void *v)
 
    BBL bbl_head = TRACE_BblHead(trace);
 
+   if (KnobBbvProfile.Value())
+   {
+      // Profiling only: count basic blocks, never generate a trace
+      for (BBL bbl = bbl_head; BBL_Valid(bbl); bbl = BBL_Next(bbl))
+         BBL_InsertCall(bbl, IPOINT_ANYWHERE, (AFUNPTR)countBbvProfile, IARG_THREAD_ID, IARG_ADDRINT, BBL_Address(bbl), IARG_UINT32, BBL_NumIns(bbl), IARG_END);
+      return;
+   }
+
    for (BBL bbl = bbl_head; BBL_Valid(bbl); bbl = BBL_Next(bbl))
    {
       for(INS ins = BBL_InsHead(bbl); ; ins = INS_Next(ins))
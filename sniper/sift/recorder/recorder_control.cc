@@ -3,6 +3,7 @@
 #include "threads.h"
 #include "syscall_modeling.h"
 #include "sift_assert.h"
+#include "blockstream.h"
 #include "../../include/sim_api.h"
 
 #include <iostream>
@@ -63,7 +64,7 @@ void beginROI(THREADID threadid, const CONTEXT * ctxt)
    }
 
    in_roi = true;
-   setInstrumentationMode(Sift::ModeDetailed);
+   setInstrumentationMode(getRoiMode());
 
    if (KnobEmulateSyscalls.Value())
    {
@@ -127,6 +128,15 @@ void endROI(THREADID threadid, const CONTEXT * ctxt)
    }
 }
 
+Sift::Mode getRoiMode()
+{
+   // Without a simulator on the other end to choose the mode, a memory-only trace is recorded in memory mode
+   if (KnobMemoryOnly.Value() && !KnobUseResponseFiles.Value())
+      return Sift::ModeMemory;
+   else
+      return Sift::ModeDetailed;
+}
+
 void setInstrumentationMode(Sift::Mode mode)
 {
    if (current_mode != mode && mode != Sift::ModeUnknown)
@@ -318,6 +328,47 @@ static void getCode(uint8_t *dst, const uint8_t *src, uint32_t size)
    PIN_SafeCopy(dst, (void*)translateAddress(ADDRINT(src), size), size);
 }
 
+static uint64_t getCompression()
+{
+   // Response files are read through a pipe, keep those uncompressed
+   if (KnobUseResponseFiles.Value())
+      return 0;
+
+   const std::string &compression = KnobCompression.Value();
+   if (compression == "none")
+      return 0;
+   else if (compression == "zlib")
+      return Sift::CompressionZlib;
+   else if (compression == "zstd")
+      return Sift::CompressionZstd;
+   else if (compression == "lz4")
+      return Sift::CompressionLZ4;
+
+   std::cerr << "[SIFT_RECORDER] Error: Unknown compression type " << compression << std::endl;
+   exit(1);
+}
+
+// Compression worker threads are Pin internal threads, threads created through the tool's libc are not supported
+static void* spawnCompressionThread(void (*func)(void*), void *arg)
+{
+   PIN_THREAD_UID *uid = new PIN_THREAD_UID;
+   if (PIN_SpawnInternalThread(func, arg, 0, uid) == INVALID_THREADID)
+   {
+      delete uid;
+      return NULL;
+   }
+   return uid;
+}
+
+static void joinCompressionThread(void *handle)
+{
+   PIN_THREAD_UID *uid = (PIN_THREAD_UID*)handle;
+   PIN_WaitForThreadTermination(*uid, PIN_INFINITE_TIMEOUT, NULL);
+   delete uid;
+}
+
+static const BlockThreadFuncs compression_thread_funcs = { spawnCompressionThread, joinCompressionThread };
+
 void openFile(THREADID threadid)
 {
    if (thread_data[threadid].output)
@@ -366,7 +417,13 @@ void openFile(THREADID threadid)
       #else
          const bool arch32 = false;
       #endif
-      thread_data[threadid].output = new Sift::Writer(filename, getCode, KnobUseResponseFiles.Value() ? false : true, response_filename, threadid, arch32, false, KnobSendPhysicalAddresses.Value());
+      const uint64_t compression = getCompression();
+      if (KnobIndexInterval.Value() && !(compression & (Sift::CompressionZstd | Sift::CompressionLZ4)))
+      {
+         std::cerr << "[SIFT_RECORDER] Error: Indexed traces require zstd or lz4 compression, and cannot be used with response files" << std::endl;
+         exit(1);
+      }
+      thread_data[threadid].output = new Sift::Writer(filename, getCode, compression, response_filename, threadid, arch32, false, KnobSendPhysicalAddresses.Value(), KnobCompressionThreads.Value(), KnobIndexInterval.Value(), KnobSharedMemory.Value() && KnobUseResponseFiles.Value(), KnobAddressDelta.Value(), &compression_thread_funcs);
    } catch (...) {
       std::cerr << "[SIFT_RECORDER:" << app_id << ":" << thread_data[threadid].thread_num << "] Error: Unable to open the output file " << filename << std::endl;
       exit(1);
@@ -413,6 +470,46 @@ void closeFile(THREADID threadid)
    }
 }
 
+void writeBbvProfile(THREADID threadid)
+{
+   Bbv *bbv = thread_data[threadid].bbv;
+   if (bbv->getInstructionCount() == 0)
+      return;
+
+   if (!thread_data[threadid].bbv_profile)
+   {
+      char filename[1024];
+      sprintf(filename, "%s.th%" PRIu64 ".bbvprofile", KnobOutputFile.Value().c_str(), thread_data[threadid].thread_num);
+      thread_data[threadid].bbv_profile = fopen(filename, "w");
+      if (!thread_data[threadid].bbv_profile)
+      {
+         std::cerr << "[SIFT_RECORDER:" << app_id << ":" << thread_data[threadid].thread_num << "] Error: Unable to open the BBV profile " << filename << std::endl;
+         exit(1);
+      }
+   }
+
+   // One interval per line: instruction count, followed by the projected BBV normalized to the instruction count
+   FILE *fp = thread_data[threadid].bbv_profile;
+   fprintf(fp, "%" PRIu64, bbv->getInstructionCount());
+   for(int i = 0; i < Bbv::NUM_BBV; ++i)
+      fprintf(fp, " %" PRIu64, bbv->getDimension(i) / bbv->getInstructionCount());
+   fprintf(fp, "\n");
+
+   bbv->clear();
+}
+
+void closeBbvProfile(THREADID threadid)
+{
+   if (thread_data[threadid].bbv)
+      writeBbvProfile(threadid);
+
+   if (thread_data[threadid].bbv_profile)
+   {
+      fclose(thread_data[threadid].bbv_profile);
+      thread_data[threadid].bbv_profile = NULL;
+   }
+}
+
 bool rtn_in_extrae(RTN rtn)
 {
    ADDRINT rtn_addr = RTN_Address(rtn);
@@ -5,6 +5,8 @@
 #include "pin.H"
 
 void setInstrumentationMode(Sift::Mode mode);
+// Mode used inside the region of interest
+Sift::Mode getRoiMode();
 
 void beginROI(THREADID threadid, const CONTEXT * ctxt);
 void endROI(THREADID threadid, const CONTEXT * ctxt);
@@ -16,6 +18,9 @@ ADDRINT translateAddress(ADDRINT addr, ADDRINT size);
 void openFile(THREADID threadid);
 void closeFile(THREADID threadid);
 
+void writeBbvProfile(THREADID threadid);
+void closeBbvProfile(THREADID threadid);
+
 void findMyAppId();
 
 void initRecorderControl();
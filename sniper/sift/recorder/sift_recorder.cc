@@ -35,6 +35,10 @@ VOID Fini(INT32 code, VOID *v)
       {
          closeFile(i);
       }
+      if (KnobBbvProfile.Value())
+      {
+         closeBbvProfile(i);
+      }
    }
 }
 
@@ -130,10 +134,19 @@ int main(int argc, char **argv)
       if (app_id < 0)
          findMyAppId();
    }
-   if (fast_forward_target == 0 && !KnobUseROI.Value() && !KnobMPIImplicitROI.Value())
+   if (KnobBbvProfile.Value())
+   {
+      if (KnobEmulateSyscalls.Value() || KnobUseResponseFiles.Value())
+      {
+         std::cerr << "Error, BBV profiling cannot be combined with syscall emulation or response files." << std::endl;
+         exit(1);
+      }
+      // Profiling only, no trace files are opened
+   }
+   else if (fast_forward_target == 0 && !KnobUseROI.Value() && !KnobMPIImplicitROI.Value())
    {
       in_roi = true;
-      setInstrumentationMode(Sift::ModeDetailed);
+      setInstrumentationMode(getRoiMode());
       openFile(0);
    }
    else if (KnobEmulateSyscalls.Value())
@@ -70,6 +70,11 @@ static VOID threadFinishHelper(VOID *arg)
       closeFile(threadid);
    }
 
+   if (KnobBbvProfile.Value())
+   {
+      closeBbvProfile(threadid);
+   }
+
    delete thread_data[threadid].bbv;
 
    thread_data[threadid].bbv = NULL;
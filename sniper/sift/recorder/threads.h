@@ -18,6 +18,7 @@ typedef struct {
    UINT64 bbv_count;
    ADDRINT bbv_last;
    BOOL bbv_end;
+   FILE *bbv_profile;
    UINT64 blocknum;
    UINT64 icount;
    UINT64 icount_cacheonly;
@@ -0,0 +1,296 @@
+#include "shmstream.h"
+#include "sift_assert.h"
+
+#include <algorithm>
+#include <new>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace
+{
+   // The data area starts on its own page, after the control block
+   const size_t DATA_OFFSET = 4096;
+   // Polls before going to sleep: when both sides are busy, a round trip never enters the kernel
+   const unsigned int SPIN_ITERATIONS = 2000;
+
+   inline void cpuRelax()
+   {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+   }
+}
+
+ShmRing::ShmRing(void *mapping, size_t size)
+   : control((Control*)mapping)
+   , data((char*)mapping + DATA_OFFSET)
+   , m_size(size)
+{
+}
+
+ShmRing::~ShmRing()
+{
+   munmap(control, m_size);
+}
+
+ShmRing* ShmRing::create(const char *filename, uint32_t capacity)
+{
+   sift_assert((capacity & (capacity - 1)) == 0);
+   static_assert(sizeof(Control) <= DATA_OFFSET, "ShmRing control block does not fit");
+
+   int fd = ::open(filename, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+      return NULL;
+
+   size_t size = DATA_OFFSET + capacity;
+   void *mapping = MAP_FAILED;
+   if (ftruncate(fd, size) == 0)
+      mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (mapping == MAP_FAILED)
+   {
+      unlink(filename);
+      return NULL;
+   }
+
+   Control *control = new (mapping) Control();
+   control->capacity = capacity;
+   control->producer_pid = 0;
+   control->consumer_pid = 0;
+   control->head = 0;
+   control->data_seq = 0;
+   control->producer_waiting = 0;
+   control->producer_closed = 0;
+   control->tail = 0;
+   control->space_seq = 0;
+   control->consumer_waiting = 0;
+   control->consumer_closed = 0;
+   __atomic_store_n(&control->magic, MAGIC, __ATOMIC_RELEASE);
+
+   return new ShmRing(mapping, size);
+}
+
+ShmRing* ShmRing::open(const char *filename)
+{
+   int fd = ::open(filename, O_RDWR);
+   if (fd < 0)
+      return NULL;
+
+   struct stat filestatus;
+   void *mapping = MAP_FAILED;
+   if (fstat(fd, &filestatus) == 0 && size_t(filestatus.st_size) > DATA_OFFSET)
+      mapping = mmap(NULL, filestatus.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (mapping == MAP_FAILED)
+      return NULL;
+
+   Control *control = (Control*)mapping;
+   if (__atomic_load_n(&control->magic, __ATOMIC_ACQUIRE) != MAGIC || DATA_OFFSET + control->capacity != size_t(filestatus.st_size))
+   {
+      munmap(mapping, filestatus.st_size);
+      return NULL;
+   }
+
+   return new ShmRing(mapping, filestatus.st_size);
+}
+
+void ShmRing::wait(std::atomic<uint32_t> &seq, uint32_t value)
+{
+   // The futex is shared between processes, so no FUTEX_PRIVATE_FLAG.
+   // Time out regularly so the caller can check whether the other side is still alive.
+   struct timespec timeout = { 0, 100 * 1000 * 1000 };
+   syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+void ShmRing::wake(std::atomic<uint32_t> &seq)
+{
+   seq.fetch_add(1);
+   syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq), FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+bool ShmRing::isDead(const std::atomic<int32_t> &pid)
+{
+   pid_t p = pid.load();
+   return p != 0 && kill(p, 0) == -1 && errno == ESRCH;
+}
+
+oshmstream::oshmstream(ShmRing *ring)
+   : ring(ring)
+   , m_head(0)
+   , m_published(0)
+   , m_tail(0)
+   , m_fail(false)
+{
+   ring->control->producer_pid = getpid();
+}
+
+oshmstream::~oshmstream()
+{
+   publish();
+   ring->control->producer_closed = 1;
+   ShmRing::wake(ring->control->data_seq);
+   delete ring;
+}
+
+void oshmstream::publish()
+{
+   if (m_head == m_published)
+      return;
+
+   ShmRing::Control *control = ring->control;
+   control->head.store(m_head);
+   m_published = m_head;
+   // Pairs with the consumer setting consumer_waiting before its final check of head
+   if (control->consumer_waiting.load())
+      ShmRing::wake(control->data_seq);
+}
+
+bool oshmstream::waitSpace()
+{
+   ShmRing::Control *control = ring->control;
+   const uint64_t full = m_head - control->capacity;
+
+   for(unsigned int i = 0; i < SPIN_ITERATIONS; ++i)
+   {
+      if ((m_tail = control->tail.load()) != full)
+         return true;
+      cpuRelax();
+   }
+
+   while(true)
+   {
+      control->producer_waiting = 1;
+      uint32_t seq = control->space_seq.load();
+      if ((m_tail = control->tail.load()) != full)
+         break;
+      if (control->consumer_closed.load() || ShmRing::isDead(control->consumer_pid))
+      {
+         control->producer_waiting = 0;
+         return false;
+      }
+      ShmRing::wait(control->space_seq, seq);
+   }
+   control->producer_waiting = 0;
+   return true;
+}
+
+void oshmstream::write(const char* s, std::streamsize n)
+{
+   ShmRing::Control *control = ring->control;
+   const uint64_t capacity = control->capacity;
+
+   while(n > 0 && !m_fail)
+   {
+      if (m_head - m_tail == capacity)
+      {
+         m_tail = control->tail.load();
+         if (m_head - m_tail == capacity)
+         {
+            // Ring is full: make everything available to the consumer, then wait for it to catch up
+            publish();
+            if (!waitSpace())
+            {
+               m_fail = true;
+               break;
+            }
+         }
+      }
+
+      uint64_t offset = m_head & (capacity - 1);
+      uint64_t chunk = std::min<uint64_t>(n, std::min(capacity - (m_head - m_tail), capacity - offset));
+      memcpy(ring->data + offset, s, chunk);
+      m_head += chunk;
+      s += chunk;
+      n -= chunk;
+   }
+
+   if (m_head - m_published >= BATCH_SIZE)
+      publish();
+}
+
+ishmstream::ishmstream(ShmRing *ring)
+   : ring(ring)
+   , m_tail(0)
+   , m_head(0)
+   , m_fail(false)
+{
+   ring->control->consumer_pid = getpid();
+}
+
+ishmstream::~ishmstream()
+{
+   ring->control->consumer_closed = 1;
+   ShmRing::wake(ring->control->space_seq);
+   delete ring;
+}
+
+bool ishmstream::waitData()
+{
+   ShmRing::Control *control = ring->control;
+
+   for(unsigned int i = 0; i < SPIN_ITERATIONS; ++i)
+   {
+      if ((m_head = control->head.load()) != m_tail)
+         return true;
+      cpuRelax();
+   }
+
+   while(true)
+   {
+      control->consumer_waiting = 1;
+      uint32_t seq = control->data_seq.load();
+      if ((m_head = control->head.load()) != m_tail)
+         break;
+      // The producer publishes everything before closing, so an empty ring is now the end of the stream
+      if (control->producer_closed.load() || ShmRing::isDead(control->producer_pid))
+      {
+         m_head = control->head.load();
+         control->consumer_waiting = 0;
+         return m_head != m_tail;
+      }
+      ShmRing::wait(control->data_seq, seq);
+   }
+   control->consumer_waiting = 0;
+   return true;
+}
+
+void ishmstream::read(char* s, std::streamsize n)
+{
+   ShmRing::Control *control = ring->control;
+   const uint64_t capacity = control->capacity;
+
+   while(n > 0)
+   {
+      if (m_head == m_tail && !waitData())
+      {
+         m_fail = true;
+         break;
+      }
+
+      uint64_t offset = m_tail & (capacity - 1);
+      uint64_t chunk = std::min<uint64_t>(n, std::min(m_head - m_tail, capacity - offset));
+      memcpy(s, ring->data + offset, chunk);
+      m_tail += chunk;
+      s += chunk;
+      n -= chunk;
+   }
+
+   control->tail.store(m_tail);
+   // Pairs with the producer setting producer_waiting before its final check of tail
+   if (control->producer_waiting.load())
+      ShmRing::wake(control->space_seq);
+}
+
+int ishmstream::peek()
+{
+   if (m_head == m_tail && !waitData())
+      return EOF;
+   return (unsigned char)ring->data[m_tail & (ring->control->capacity - 1)];
+}
@@ -0,0 +1,106 @@
+#ifndef __SHMSTREAM_H
+#define __SHMSTREAM_H
+
+#include "zfstream.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Shared-memory transport between a SIFT writer and reader, as an alternative to named FIFOs.
+// Each direction is a single-producer single-consumer byte ring in a file mapped by both processes.
+// The producer publishes data in batches (on flush(), or once enough has accumulated) so a burst of records
+// costs a single store.  A side that runs out of data or space spins for a while, then sleeps on a futex;
+// the other side only makes the wake-up system call when it sees that someone is sleeping.
+
+class ShmRing
+{
+   public:
+      struct Control
+      {
+         uint32_t magic;
+         uint32_t capacity;                           // Size of the data area, a power of two
+         std::atomic<int32_t> producer_pid;
+         std::atomic<int32_t> consumer_pid;
+
+         // Written by the producer
+         alignas(64) std::atomic<uint64_t> head;      // Bytes published
+         std::atomic<uint32_t> data_seq;              // Futex the consumer sleeps on
+         std::atomic<uint32_t> producer_waiting;
+         std::atomic<uint32_t> producer_closed;
+
+         // Written by the consumer
+         alignas(64) std::atomic<uint64_t> tail;      // Bytes consumed
+         std::atomic<uint32_t> space_seq;             // Futex the producer sleeps on
+         std::atomic<uint32_t> consumer_waiting;
+         std::atomic<uint32_t> consumer_closed;
+      };
+
+      Control *control;
+      char *data;
+
+      ~ShmRing();
+
+      // Create a new ring file, NULL on failure
+      static ShmRing* create(const char *filename, uint32_t capacity);
+      // Map an existing ring file, NULL on failure
+      static ShmRing* open(const char *filename);
+
+      // Sleep until seq no longer equals value, or until a timeout expires
+      static void wait(std::atomic<uint32_t> &seq, uint32_t value);
+      static void wake(std::atomic<uint32_t> &seq);
+      // Whether the other side has gone away without closing its end
+      static bool isDead(const std::atomic<int32_t> &pid);
+
+   private:
+      static const uint32_t MAGIC = 0x52484d53; // "SMHR"
+      size_t m_size;
+
+      ShmRing(void *mapping, size_t size);
+};
+
+class oshmstream : public vostream
+{
+   private:
+      static const uint64_t BATCH_SIZE = 64 * 1024;
+
+      ShmRing *ring;
+      uint64_t m_head;           // Bytes written, published up to m_published
+      uint64_t m_published;
+      uint64_t m_tail;           // Last known consumer position
+      bool m_fail;
+
+      bool waitSpace();
+      void publish();
+
+   public:
+      // Takes ownership of ring
+      oshmstream(ShmRing *ring);
+      virtual ~oshmstream();
+      virtual void write(const char* s, std::streamsize n);
+      virtual void flush()
+         { publish(); }
+      virtual bool is_open()
+         { return !m_fail; }
+};
+
+class ishmstream : public vistream
+{
+   private:
+      ShmRing *ring;
+      uint64_t m_tail;           // Bytes read
+      uint64_t m_head;           // Last known producer position
+      bool m_fail;
+
+      bool waitData();
+
+   public:
+      // Takes ownership of ring
+      ishmstream(ShmRing *ring);
+      virtual ~ishmstream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+};
+
+#endif // __SHMSTREAM_H
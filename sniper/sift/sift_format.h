@@ -15,6 +15,7 @@ namespace Sift
 {
 
    const uint32_t MagicNumber = 0x54464953; // "SIFT"
+   const uint32_t IndexMagicNumber = 0x58444e49; // "INDX"
    const uint64_t PAGE_SIZE = 4096;
    const uint32_t ICACHE_SIZE = 0x1000;
    const uint64_t ICACHE_OFFSET_MASK = ICACHE_SIZE - 1;
@@ -35,7 +36,57 @@ namespace Sift
       ArchIA32 = 2,
       IcacheVariable = 4,
       PhysicalAddress = 8,
+      // Stream of independently compressed blocks, see blockstream.h
+      CompressionZstd = 16,
+      CompressionLZ4 = 32,
+      // Block-compressed trace followed by an index, see IndexTrailer
+      Indexed = 64,
+      // After the header, the stream continues through a shared-memory ring (see shmstream.h) instead of the file.
+      // The extra header holds the ring's file name, the response ring is at the same name with ".response" appended.
+      SharedMemory = 128,
+      // Addresses are sent as zigzag varints (see sift_utils.h): the address of an InstructionExt record relative to
+      // the previous address + size, and memory addresses relative to a stride prediction per static instruction
+      AddressDelta = 256,
    } Option;
+   const uint64_t CompressionMask = CompressionZlib | CompressionZstd | CompressionLZ4;
+
+   // Indexed traces end with an IndexTrailer, pointing to the index which follows the last block:
+   //  - IndexHeader
+   //  - IndexHeader.num_entries * IndexEntry
+   //  - IndexHeader.num_icache * (uint64_t address, uint8_t[ICACHE_SIZE] bytes)
+   //  - IndexHeader.num_va2pa * (uint64_t virtual page, uint64_t physical page)
+   // Each entry points to a block that starts with instruction number <icount>, whose address is sent in full.
+   // With AddressDelta, such a block starts with a RecOtherAddressReset record.
+   // The writer sends each icache page and va2pa mapping only once, so a reader starting at an index entry
+   // first loads all icache and va2pa state, which is a valid superset of the state at every entry.
+   typedef struct
+   {
+      uint64_t icount;           //< Instructions preceding this entry
+      uint64_t offset;           //< File offset of the first block
+   } __attribute__ ((__packed__)) IndexEntry;
+
+   typedef struct
+   {
+      uint64_t num_instructions; //< Total number of instructions in the trace
+      uint64_t interval;         //< Instructions between index entries
+      uint64_t num_entries;
+      uint64_t num_icache;
+      uint64_t num_va2pa;
+      uint64_t flags;            //< Bit field of IndexFlag* flags
+   } __attribute__ ((__packed__)) IndexHeader;
+
+   // Records in the trace that are not accounted for by IndexEntry.icount
+   typedef enum
+   {
+      IndexHasRoutines = 1,      //< RoutineChange or RoutineAnnounce records
+      IndexHasCacheOnly = 2,     //< CacheOnly records, which carry their own instruction count
+   } IndexFlag;
+
+   typedef struct
+   {
+      uint64_t offset;           //< File offset of the IndexHeader
+      uint32_t magic;            //< IndexMagicNumber
+   } __attribute__ ((__packed__)) IndexTrailer;
 
    typedef union
    {
@@ -56,6 +107,7 @@ namespace Sift
 
       // Extended format for all instructions
       // * first 4 bits: zero, next 4 bits: non-zero
+      // - with AddressDelta, addr is replaced by a varint
 
       struct {
          uint8_t type:4;   // 0
@@ -107,6 +159,7 @@ namespace Sift
       RecOtherForkResponse,
       RecOtherInstructionCount,
       RecOtherCacheOnly,
+      RecOtherAddressReset,   // AddressDelta: the previous address and all address predictions start over
       RecOtherEnd = 0xff,
    } RecOtherType;
 
@@ -0,0 +1,80 @@
+#ifndef __SIFT_PAGETABLE_H
+#define __SIFT_PAGETABLE_H
+
+#include "sift_format.h"
+
+#include <unordered_map>
+#include <stdint.h>
+
+namespace Sift
+{
+   // Per-address lookup table for code, organized like a two-level page table: a hash map finds the page,
+   // a flat array of ICACHE_SIZE entries indexed by page offset holds the values.  Consecutive lookups
+   // mostly stay within the same page, so the last page is remembered and a hit on it costs two loads.
+   // Entries not yet set read as T().
+   template <typename T> class PageTable
+   {
+      private:
+         std::unordered_map<uint64_t, T*> m_pages;
+         uint64_t m_last_page;
+         T *m_last_entries;
+
+         T* getPage(uint64_t page, bool create)
+         {
+            if (page == m_last_page)
+               return m_last_entries;
+
+            T *entries;
+            typename std::unordered_map<uint64_t, T*>::iterator it = m_pages.find(page);
+            if (it != m_pages.end())
+               entries = it->second;
+            else if (create)
+               entries = m_pages[page] = new T[ICACHE_SIZE]();
+            else
+               return NULL;
+
+            m_last_page = page;
+            m_last_entries = entries;
+            return entries;
+         }
+
+         PageTable(const PageTable &);
+         PageTable& operator=(const PageTable &);
+
+      public:
+         PageTable()
+            : m_last_page(~uint64_t(0))
+            , m_last_entries(NULL)
+         {}
+
+         ~PageTable()
+         {
+            for(typename std::unordered_map<uint64_t, T*>::iterator it = m_pages.begin() ; it != m_pages.end() ; ++it)
+               delete [] it->second;
+         }
+
+         // Value stored for addr, T() when not set
+         T find(uint64_t addr)
+         {
+            T *entries = getPage(addr / ICACHE_SIZE, false);
+            return entries ? entries[addr & ICACHE_OFFSET_MASK] : T();
+         }
+
+         // Reference to the entry for addr, allocating its page when needed
+         T& operator[](uint64_t addr)
+         {
+            return getPage(addr / ICACHE_SIZE, true)[addr & ICACHE_OFFSET_MASK];
+         }
+
+         // Call func(addr, value) for every entry that was set
+         template <typename F> void forEach(F func) const
+         {
+            for(typename std::unordered_map<uint64_t, T*>::const_iterator it = m_pages.begin() ; it != m_pages.end() ; ++it)
+               for(uint32_t offset = 0 ; offset < ICACHE_SIZE ; ++offset)
+                  if (it->second[offset] != T())
+                     func(it->first * ICACHE_SIZE + offset, it->second[offset]);
+         }
+   };
+};
+
+#endif // __SIFT_PAGETABLE_H
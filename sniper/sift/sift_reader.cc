@@ -2,11 +2,15 @@
 #include "sift_format.h"
 #include "sift_utils.h"
 #include "zfstream.h"
+#include "blockstream.h"
+#include "shmstream.h"
 
 #include <iostream>
 #include <fstream>
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <string>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -43,12 +47,34 @@ Sift::Reader::Reader(const char *filename, const char *response_filename, uint32
    , handleRoutineAnnounceFunc(NULL)
    , handleRoutineArg(NULL)
    , filesize(0)
+   , inputstream(NULL)
+   , m_blockstream(NULL)
+   , m_mmapstream(NULL)
+   , m_blockstream_base(0)
+   , m_compression_option(0)
+   , m_compression("none")
+   , m_indexed(false)
+   , m_index_header()
+   , m_index()
    , last_address(0)
    , icache()
    , m_id(id)
    , m_trace_has_pa(false)
+   , m_trace_is_ia32(false)
+   , m_trace_has_icache_per_insn(false)
+   , m_address_delta(false)
    , m_seen_end(false)
+   , m_skipping(false)
    , m_last_sinst(NULL)
+   , m_regular_file(false)
+   , m_readahead_size(0)
+   , m_readahead_running(false)
+   , m_readahead_ring()
+   , m_readahead_head(0)
+   , m_readahead_tail(0)
+   , m_readahead_stop(false)
+   , m_readahead_producer_waiting(false)
+   , m_readahead_consumer_waiting(false)
 {
    if (!xed_initialized)
    {
@@ -62,26 +88,32 @@ Sift::Reader::Reader(const char *filename, const char *response_filename, uint32
    m_filename = strdup(filename);
    m_response_filename = strdup(response_filename);
 
+   pthread_mutex_init(&m_readahead_lock, NULL);
+   pthread_cond_init(&m_readahead_cond, NULL);
+
    // initing stream here could cause deadlock when using pipes, as this should be able to be new()ed from
    // a thread that should not block
 }
 
 Sift::Reader::~Reader()
 {
+   stopReadAhead();
+   pthread_cond_destroy(&m_readahead_cond);
+   pthread_mutex_destroy(&m_readahead_lock);
+
    free(m_filename);
    free(m_response_filename);
+   // Icache pages can point into the memory-mapped trace, free them before unmapping it
+   for(std::unordered_map<uint64_t, const uint8_t*>::iterator i = icache.begin() ; i != icache.end() ; ++i)
+   {
+      if (!(m_mmapstream && m_mmapstream->contains((*i).second)))
+         delete [] (*i).second;
+   }
    if (input)
       delete input;
    if (response)
       delete response;
-   for(std::unordered_map<uint64_t, const uint8_t*>::iterator i = icache.begin() ; i != icache.end() ; ++i)
-   {
-      delete [] (*i).second;
-   }
-   for(std::unordered_map<uint64_t, const StaticInstruction*>::iterator i = scache.begin() ; i != scache.end() ; ++i)
-   {
-      delete (*i).second;
-   }
+   scache.forEach([](uint64_t addr, const StaticInstruction *sinst) { delete sinst; });
 }
 
 void Sift::Reader::initStream()
@@ -101,24 +133,88 @@ void Sift::Reader::initStream()
    struct stat filestatus;
    stat(m_filename, &filestatus);
    filesize = filestatus.st_size;
+   m_regular_file = S_ISREG(filestatus.st_mode);
 
    input = new vifstream(inputstream);
 
    Sift::Header hdr;
    input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
    assert(hdr.magic == Sift::MagicNumber);
-   assert(hdr.size == 0);
+   std::vector<char> extra_header(hdr.size + 1, '\0');
+   input->read(extra_header.data(), hdr.size);
+
+   if (hdr.options & SharedMemory)
+   {
+      // The writer continues the stream, and receives our responses, through shared-memory rings
+      std::string shm_filename(extra_header.data());
+      ShmRing *ring = ShmRing::open(shm_filename.c_str());
+      if (!ring)
+      {
+         std::cerr << "Cannot open shared-memory ring " << shm_filename << " for " << m_filename << std::endl;
+         assert(false);
+      }
+      unlink(shm_filename.c_str());
+      delete input;
+      inputstream = NULL;
+      input = new ishmstream(ring);
+
+      if (strcmp(m_response_filename, "") != 0)
+      {
+         std::string response_filename = shm_filename + ".response";
+         ring = ShmRing::open(response_filename.c_str());
+         if (!ring)
+         {
+            std::cerr << "Cannot open shared-memory ring " << response_filename << " for " << m_response_filename << std::endl;
+            assert(false);
+         }
+         unlink(response_filename.c_str());
+         response = new oshmstream(ring);
+      }
+      hdr.options &= ~SharedMemory;
+   }
 
    if (hdr.options & CompressionZlib)
    {
       input = new izstream(input);
+      m_compression = "zlib";
       hdr.options &= ~CompressionZlib;
    }
+   else if (hdr.options & (CompressionZstd | CompressionLZ4))
+   {
+      BlockCodec *codec = BlockCodec::create(hdr.options & (CompressionZstd | CompressionLZ4));
+      if (!codec)
+      {
+         std::cerr << "Trace " << m_filename << " uses a compression format not supported by this build" << std::endl;
+         assert(false);
+      }
+      m_compression = codec->getName();
+      m_compression_option = hdr.options & (CompressionZstd | CompressionLZ4);
+      // Only decompress ahead when reading from a file: a pipe may block the read-ahead thread indefinitely
+      m_blockstream = new iblockstream(input, codec, S_ISREG(filestatus.st_mode));
+      m_blockstream_base = sizeof(hdr) + hdr.size;
+      input = m_blockstream;
+      hdr.options &= ~(CompressionZstd | CompressionLZ4);
+   }
+   else if (S_ISREG(filestatus.st_mode))
+   {
+      // Uncompressed trace file: map it into memory, icache pages will point directly into the mapping
+      vmmapstream *mmapstream = new vmmapstream(m_filename, sizeof(hdr) + hdr.size);
+      if (mmapstream->is_open())
+      {
+         delete input;
+         inputstream = NULL;
+         m_mmapstream = mmapstream;
+         input = m_mmapstream;
+      }
+      else
+         delete mmapstream;
+   }
 
    if (hdr.options & ArchIA32)
    {
       xed_state_t init = { XED_MACHINE_MODE_LONG_COMPAT_32, XED_ADDRESS_WIDTH_32b };
       m_xed_state_init = init;
+      m_trace_is_ia32 = true;
       hdr.options &= ~ArchIA32;
    }
    else
@@ -133,7 +229,23 @@ void Sift::Reader::initStream()
       hdr.options &= ~PhysicalAddress;
    }
 
-   hdr.options &= ~IcacheVariable;
+   if (hdr.options & IcacheVariable)
+   {
+      m_trace_has_icache_per_insn = true;
+      hdr.options &= ~IcacheVariable;
+   }
+
+   if (hdr.options & AddressDelta)
+   {
+      m_address_delta = true;
+      hdr.options &= ~AddressDelta;
+   }
+
+   if (hdr.options & Indexed)
+   {
+      m_indexed = true;
+      hdr.options &= ~Indexed;
+   }
 
    // Make sure there are no unrecognized options
    assert(hdr.options == 0);
@@ -158,6 +270,37 @@ void Sift::Reader::initResponse()
    }
 }
 
+// For memory-mapped traces, bypass the virtual vistream interface on the hot path: reads become pointer bumps
+inline void Sift::Reader::readInput(char *dst, std::streamsize n)
+{
+   if (m_mmapstream)
+      m_mmapstream->vmmapstream::read(dst, n);
+   else
+      input->read(dst, n);
+}
+
+inline uint64_t Sift::Reader::readVarint()
+{
+   uint64_t value = 0;
+   for(unsigned int shift = 0; shift < 64; shift += 7)
+   {
+      uint8_t byte;
+      readInput(reinterpret_cast<char*>(&byte), sizeof(byte));
+      value |= uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         break;
+   }
+   return value;
+}
+
+inline int Sift::Reader::peekInput()
+{
+   if (m_mmapstream)
+      return m_mmapstream->vmmapstream::peek();
+   else
+      return input->peek();
+}
+
 bool Sift::Reader::Read(Instruction &inst)
 {
    if (input == NULL)
@@ -165,16 +308,157 @@ bool Sift::Reader::Read(Instruction &inst)
       initStream();
    }
 
+   // Without response files, nothing we read depends on the simulator's reaction to earlier records
+   if (m_readahead_size && !m_readahead_running && !m_seen_end && m_regular_file && strcmp(m_response_filename, "") == 0)
+      startReadAhead();
+
+   if (!m_readahead_running)
+      return readInstruction(inst);
+
+   while(true)
+   {
+      uint64_t tail = m_readahead_tail.load(std::memory_order_relaxed);
+      if (m_readahead_head.load() == tail)
+      {
+         pthread_mutex_lock(&m_readahead_lock);
+         m_readahead_consumer_waiting = true;
+         while(m_readahead_head.load() == tail)
+            pthread_cond_wait(&m_readahead_cond, &m_readahead_lock);
+         m_readahead_consumer_waiting = false;
+         pthread_mutex_unlock(&m_readahead_lock);
+      }
+
+      ReadAheadEntry &entry = m_readahead_ring[tail % m_readahead_ring.size()];
+      // Leave the end marker in place so subsequent calls keep returning false
+      if (entry.type == ReadAheadEntry::ENTRY_END)
+         return false;
+
+      bool have_instruction = entry.type == ReadAheadEntry::ENTRY_INSTRUCTION;
+      if (have_instruction)
+         inst = entry.inst;
+      else
+      {
+         entry.event();
+         entry.event = nullptr;
+      }
+
+      m_readahead_tail.store(tail + 1);
+      if (m_readahead_producer_waiting.load())
+      {
+         pthread_mutex_lock(&m_readahead_lock);
+         pthread_cond_broadcast(&m_readahead_cond);
+         pthread_mutex_unlock(&m_readahead_lock);
+      }
+
+      if (have_instruction)
+         return true;
+   }
+}
+
+void Sift::Reader::deliver(const std::function<void()> &event)
+{
+   // Records skipped by Seek() are not seen by the client
+   if (m_skipping)
+      return;
+
+   if (m_readahead_running)
+   {
+      ReadAheadEntry entry;
+      entry.type = ReadAheadEntry::ENTRY_EVENT;
+      entry.event = event;
+      pushEntry(entry);
+   }
+   else
+      event();
+}
+
+bool Sift::Reader::pushEntry(ReadAheadEntry &entry)
+{
+   uint64_t head = m_readahead_head.load(std::memory_order_relaxed);
+   if (head - m_readahead_tail.load() == m_readahead_ring.size())
+   {
+      pthread_mutex_lock(&m_readahead_lock);
+      m_readahead_producer_waiting = true;
+      while(head - m_readahead_tail.load() == m_readahead_ring.size() && !m_readahead_stop)
+         pthread_cond_wait(&m_readahead_cond, &m_readahead_lock);
+      m_readahead_producer_waiting = false;
+      pthread_mutex_unlock(&m_readahead_lock);
+   }
+   if (m_readahead_stop)
+      return false;
+
+   ReadAheadEntry &slot = m_readahead_ring[head % m_readahead_ring.size()];
+   slot.type = entry.type;
+   slot.inst = entry.inst;
+   slot.event.swap(entry.event);
+
+   m_readahead_head.store(head + 1);
+   if (m_readahead_consumer_waiting.load())
+   {
+      pthread_mutex_lock(&m_readahead_lock);
+      pthread_cond_broadcast(&m_readahead_cond);
+      pthread_mutex_unlock(&m_readahead_lock);
+   }
+   return true;
+}
+
+void* Sift::Reader::readAheadThread(void *arg)
+{
+   Reader *self = (Reader*)arg;
+
+   while(true)
+   {
+      ReadAheadEntry entry;
+      bool have_instruction = self->readInstruction(entry.inst);
+      entry.type = have_instruction ? ReadAheadEntry::ENTRY_INSTRUCTION : ReadAheadEntry::ENTRY_END;
+      if (!self->pushEntry(entry) || !have_instruction)
+         break;
+   }
+
+   return NULL;
+}
+
+void Sift::Reader::startReadAhead()
+{
+   m_readahead_ring.resize(m_readahead_size);
+   m_readahead_head = 0;
+   m_readahead_tail = 0;
+   m_readahead_stop = false;
+   m_readahead_running = true;
+
+   int ret = pthread_create(&m_readahead_thread, NULL, readAheadThread, this);
+   assert(ret == 0);
+}
+
+void Sift::Reader::stopReadAhead()
+{
+   if (!m_readahead_running)
+      return;
+
+   pthread_mutex_lock(&m_readahead_lock);
+   m_readahead_stop = true;
+   pthread_cond_broadcast(&m_readahead_cond);
+   pthread_mutex_unlock(&m_readahead_lock);
+   pthread_join(m_readahead_thread, NULL);
+   m_readahead_running = false;
+
+   // Drop everything that was read ahead but not consumed
+   for(size_t i = 0; i < m_readahead_ring.size(); ++i)
+      m_readahead_ring[i].event = nullptr;
+}
+
+bool Sift::Reader::readInstruction(Instruction &inst)
+{
    while(!m_seen_end)
    {
       Record rec;
-      uint8_t byte = input->peek();
+      uint8_t byte = peekInput();
       assert(!input->fail());
 
       if (byte == 0)
       {
          // Other
-         input->read(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
+         readInput(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
          switch(rec.Other.type)
          {
             case RecOtherEnd:
@@ -187,10 +471,19 @@ bool Sift::Reader::Read(Instruction &inst)
             {
                assert(rec.Other.size == sizeof(uint64_t) + ICACHE_SIZE);
                uint64_t address;
-               uint8_t *bytes = new uint8_t[ICACHE_SIZE];
                input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
-               input->read(reinterpret_cast<char*>(bytes), ICACHE_SIZE);
-               icache[address] = bytes;
+               const uint8_t *bytes = reinterpret_cast<const uint8_t*>(input->readDirect(ICACHE_SIZE));
+               if (!bytes)
+               {
+                  uint8_t *copy = new uint8_t[ICACHE_SIZE];
+                  input->read(reinterpret_cast<char*>(copy), ICACHE_SIZE);
+                  bytes = copy;
+               }
+               // Pages loaded from the index snapshot by Seek() are sent again by the trace itself
+               const uint8_t* &page = icache[address];
+               if (page && !(m_mmapstream && m_mmapstream->contains(page)))
+                  delete [] page;
+               page = bytes;
                break;
             }
             case RecOtherIcacheVariable:
@@ -208,6 +501,13 @@ bool Sift::Reader::Read(Instruction &inst)
                   uint64_t base_addr = address & ICACHE_PAGE_MASK;
                   if (icache.count(base_addr) == 0)
                      icache[base_addr] = new uint8_t[ICACHE_SIZE];
+                  else if (m_mmapstream && m_mmapstream->contains(icache[base_addr]))
+                  {
+                     // Do not write into the read-only trace mapping
+                     uint8_t *copy = new uint8_t[ICACHE_SIZE];
+                     memcpy(copy, icache[base_addr], ICACHE_SIZE);
+                     icache[base_addr] = copy;
+                  }
                   uint64_t offset = address & ICACHE_OFFSET_MASK;
                   size_t read_amount = std::min(size_left, size_t(ICACHE_SIZE - offset));
                   input->read(const_cast<char*>(reinterpret_cast<const char*>(&(icache[base_addr][offset]))), read_amount);
@@ -228,7 +528,11 @@ bool Sift::Reader::Read(Instruction &inst)
                uint64_t vp, pp;
                input->read(reinterpret_cast<char*>(&vp), sizeof(uint64_t));
                input->read(reinterpret_cast<char*>(&pp), sizeof(uint64_t));
-               vcache[vp] = pp;
+               // vcache is used by the consumer through va2pa(), and is kept up to date while skipping
+               if (m_skipping)
+                  vcache[vp] = pp;
+               else
+                  deliver([=]() { vcache[vp] = pp; });
                break;
             }
             case RecOtherInstructionCount:
@@ -239,10 +543,19 @@ bool Sift::Reader::Read(Instruction &inst)
                assert(rec.Other.size == sizeof(uint32_t));
                uint32_t icount;
                input->read(reinterpret_cast<char*>(&icount), sizeof(icount));
-               Mode mode = ModeUnknown;
-               if (handleInstructionCountFunc)
-                  mode = handleInstructionCountFunc(handleInstructionCountArg, icount);
-               sendSimpleResponse(RecOtherSyncResponse, &mode, sizeof(Mode));
+               deliver([=]() {
+                  Mode mode = ModeUnknown;
+                  if (handleInstructionCountFunc)
+                     mode = handleInstructionCountFunc(handleInstructionCountArg, icount);
+                  sendSimpleResponse(RecOtherSyncResponse, &mode, sizeof(Mode));
+               });
+               break;
+            }
+            case RecOtherAddressReset:
+            {
+               assert(rec.Other.size == 0);
+               last_address = 0;
+               m_address_predictors.reset();
                break;
             }
             case RecOtherCacheOnly:
@@ -258,7 +571,7 @@ bool Sift::Reader::Read(Instruction &inst)
                input->read(reinterpret_cast<char*>(&eip), sizeof(uint64_t));
                input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
                if (handleCacheOnlyFunc)
-                  handleCacheOnlyFunc(handleCacheOnlyArg, icount, (Sift::CacheOnlyType)type, eip, address);
+                  deliver([=]() { handleCacheOnlyFunc(handleCacheOnlyArg, icount, (Sift::CacheOnlyType)type, eip, address); });
                break;
             }
             case RecOtherOutput:
@@ -269,12 +582,11 @@ bool Sift::Reader::Read(Instruction &inst)
                assert(rec.Other.size > sizeof(uint8_t));
                uint8_t fd;
                uint32_t size = rec.Other.size - sizeof(uint8_t);
-               uint8_t *bytes = new uint8_t[size];
+               std::vector<uint8_t> bytes(size);
                input->read(reinterpret_cast<char*>(&fd), sizeof(uint8_t));
-               input->read(reinterpret_cast<char*>(bytes), size);
+               input->read(reinterpret_cast<char*>(&bytes[0]), size);
                if (handleOutputFunc)
-                  handleOutputFunc(handleOutputArg, fd, bytes, size);
-               delete [] bytes;
+                  deliver([=]() { handleOutputFunc(handleOutputArg, fd, &bytes[0], size); });
                break;
             }
             case RecOtherSyscallRequest:
@@ -285,31 +597,32 @@ bool Sift::Reader::Read(Instruction &inst)
                assert(rec.Other.size > sizeof(uint16_t));
                uint16_t syscall_number;
                uint32_t size = rec.Other.size - sizeof(uint16_t);
-               uint8_t *bytes = new uint8_t[size];
+               std::vector<uint8_t> bytes(size);
                input->read(reinterpret_cast<char*>(&syscall_number), sizeof(uint16_t));
-               input->read(reinterpret_cast<char*>(bytes), size);
+               input->read(reinterpret_cast<char*>(&bytes[0]), size);
                #if VERBOSE_HEX > 0
                hexdump((char*)&rec, sizeof(rec.Other));
                hexdump((char*)&syscall_number, sizeof(syscall_number));
-               hexdump((char*)bytes, size);
+               hexdump((char*)&bytes[0], size);
                #endif
                #if VERBOSE > 1
                for (int i = 0 ; i < (size/8) ; i++)
                {
-                  std::cerr << __FUNCTION__ << ": syscall args[" << i << "] = " << ((uint64_t*)bytes)[i] << std::endl;
+                  std::cerr << __FUNCTION__ << ": syscall args[" << i << "] = " << ((uint64_t*)&bytes[0])[i] << std::endl;
                }
                #endif
 
                assert(handleSyscallFunc);
                if (handleSyscallFunc)
                {
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleSyscall" << std::endl;
-                  #endif
-                  uint64_t ret = handleSyscallFunc(handleSyscallArg, syscall_number, bytes, size);
-                  sendSyscallResponse(ret);
+                  deliver([=]() {
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleSyscall" << std::endl;
+                     #endif
+                     uint64_t ret = handleSyscallFunc(handleSyscallArg, syscall_number, &bytes[0], size);
+                     sendSyscallResponse(ret);
+                  });
                }
-               delete [] bytes;
                break;
             }
             case RecOtherNewThread:
@@ -318,14 +631,16 @@ bool Sift::Reader::Read(Instruction &inst)
                assert(handleNewThreadFunc);
                if (handleNewThreadFunc)
                {
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleNewThread" << std::endl;
-                  #endif
-                  int32_t ret = handleNewThreadFunc(handleNewThreadArg);
-                  sendSimpleResponse(RecOtherNewThreadResponse, &ret, sizeof(ret));
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleNewThread Done" << std::endl;
-                  #endif
+                  deliver([=]() {
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleNewThread" << std::endl;
+                     #endif
+                     int32_t ret = handleNewThreadFunc(handleNewThreadArg);
+                     sendSimpleResponse(RecOtherNewThreadResponse, &ret, sizeof(ret));
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleNewThread Done" << std::endl;
+                     #endif
+                  });
                }
                break;
             }
@@ -337,24 +652,28 @@ bool Sift::Reader::Read(Instruction &inst)
                assert(handleJoinFunc);
                if (handleJoinFunc)
                {
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleJoin" << std::endl;
-                  #endif
-                  int32_t ret = handleJoinFunc(handleJoinArg, thread);
-                  sendSimpleResponse(RecOtherJoinResponse, &ret, sizeof(ret));
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleJoin Done" << std::endl;
-                  #endif
+                  deliver([=]() {
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleJoin" << std::endl;
+                     #endif
+                     int32_t ret = handleJoinFunc(handleJoinArg, thread);
+                     sendSimpleResponse(RecOtherJoinResponse, &ret, sizeof(ret));
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleJoin Done" << std::endl;
+                     #endif
+                  });
                }
                break;
             }
             case RecOtherSync:
             {
                assert(rec.Other.size == 0);
-               Mode mode = ModeUnknown;
-               if (handleInstructionCountFunc)
-                  mode = handleInstructionCountFunc(handleInstructionCountArg, 0);
-               sendSimpleResponse(RecOtherSyncResponse, &mode, sizeof(Mode));
+               deliver([=]() {
+                  Mode mode = ModeUnknown;
+                  if (handleInstructionCountFunc)
+                     mode = handleInstructionCountFunc(handleInstructionCountArg, 0);
+                  sendSimpleResponse(RecOtherSyncResponse, &mode, sizeof(Mode));
+               });
                break;
             }
             case RecOtherFork:
@@ -363,14 +682,16 @@ bool Sift::Reader::Read(Instruction &inst)
                assert(handleForkFunc);
                if(handleForkFunc)
                {
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleFork" << std::endl;
-                  #endif
-                  int32_t ret = handleForkFunc(handleForkArg);
-                  sendSimpleResponse(RecOtherForkResponse, &ret, sizeof(ret));
-                  #if VERBOSE > 0
-                  std::cerr << "[DEBUG:" << m_id << "] HandleFork Done" << std::endl;
-                  #endif
+                  deliver([=]() {
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleFork" << std::endl;
+                     #endif
+                     int32_t ret = handleForkFunc(handleForkArg);
+                     sendSimpleResponse(RecOtherForkResponse, &ret, sizeof(ret));
+                     #if VERBOSE > 0
+                     std::cerr << "[DEBUG:" << m_id << "] HandleFork Done" << std::endl;
+                     #endif
+                  });
                }
                break;
             }
@@ -381,16 +702,18 @@ bool Sift::Reader::Read(Instruction &inst)
                input->read(reinterpret_cast<char*>(&a), sizeof(uint64_t));
                input->read(reinterpret_cast<char*>(&b), sizeof(uint64_t));
                input->read(reinterpret_cast<char*>(&c), sizeof(uint64_t));
-               uint64_t result;
-               if (handleMagicFunc)
-               {
-                  result = handleMagicFunc(handleMagicArg, a, b, c);
-               }
-               else
-               {
-                  result = a; // Do not modify GAX register
-               }
-               sendSimpleResponse(RecOtherMagicInstructionResponse, &result, sizeof(result));
+               deliver([=]() {
+                  uint64_t result;
+                  if (handleMagicFunc)
+                  {
+                     result = handleMagicFunc(handleMagicArg, a, b, c);
+                  }
+                  else
+                  {
+                     result = a; // Do not modify GAX register
+                  }
+                  sendSimpleResponse(RecOtherMagicInstructionResponse, &result, sizeof(result));
+               });
                break;
             }
             case RecOtherEmu:
@@ -399,12 +722,14 @@ bool Sift::Reader::Read(Instruction &inst)
                uint16_t type; EmuRequest req;
                input->read(reinterpret_cast<char*>(&type), sizeof(uint16_t));
                input->read(reinterpret_cast<char*>(&req), rec.Other.size - sizeof(uint16_t));
-               bool result = false; EmuReply res = {};
-               if (handleEmuFunc)
-               {
-                  result = handleEmuFunc(handleEmuArg, EmuType(type), req, res);
-               }
-               sendEmuResponse(result, res);
+               deliver([=]() {
+                  bool result = false; EmuRequest request = req; EmuReply res = {};
+                  if (handleEmuFunc)
+                  {
+                     result = handleEmuFunc(handleEmuArg, EmuType(type), request, res);
+                  }
+                  sendEmuResponse(result, res);
+               });
                break;
             }
             case RecOtherRoutineChange:
@@ -417,7 +742,7 @@ bool Sift::Reader::Read(Instruction &inst)
                input->read(reinterpret_cast<char*>(&esp), sizeof(uint64_t));
                input->read(reinterpret_cast<char*>(&callEip), sizeof(uint64_t));
                if (handleRoutineChangeFunc)
-                  handleRoutineChangeFunc(handleRoutineArg, Sift::RoutineOpType(event), eip, esp, callEip);
+                  deliver([=]() { handleRoutineChangeFunc(handleRoutineArg, Sift::RoutineOpType(event), eip, esp, callEip); });
                break;
             }
             case RecOtherRoutineAnnounce:
@@ -440,8 +765,12 @@ bool Sift::Reader::Read(Instruction &inst)
                filename = (char*)malloc(len_filename);
                input->read(filename, len_filename);
                if (handleRoutineAnnounceFunc)
-                  handleRoutineAnnounceFunc(handleRoutineArg, eip, name, imgname, offset, line, column, filename);
+               {
+                  std::string s_name(name, len_name), s_imgname(imgname, len_imgname), s_filename(filename, len_filename);
+                  deliver([=]() { handleRoutineAnnounceFunc(handleRoutineArg, eip, s_name.c_str(), s_imgname.c_str(), offset, line, column, s_filename.c_str()); });
+               }
                free(name);
+               free(imgname);
                free(filename);
                break;
             }
@@ -462,7 +791,7 @@ bool Sift::Reader::Read(Instruction &inst)
       if ((byte & 0xf) != 0)
       {
          // Instruction
-         input->read(reinterpret_cast<char*>(&rec), sizeof(rec.Instruction));
+         readInput(reinterpret_cast<char*>(&rec), sizeof(rec.Instruction));
 
          #if VERBOSE_HEX > 2
          hexdump(&rec, sizeof(rec.Instruction));
@@ -479,14 +808,22 @@ bool Sift::Reader::Read(Instruction &inst)
       else
       {
          // InstructionExt
-         input->read(reinterpret_cast<char*>(&rec), sizeof(rec.InstructionExt));
+         if (m_address_delta)
+         {
+            readInput(reinterpret_cast<char*>(&rec), sizeof(rec.InstructionExt) - sizeof(rec.InstructionExt.addr));
+            addr = last_address + zigzagDecode(readVarint());
+         }
+         else
+         {
+            readInput(reinterpret_cast<char*>(&rec), sizeof(rec.InstructionExt));
+            addr = rec.InstructionExt.addr;
+         }
 
          #if VERBOSE_HEX > 2
          hexdump(&rec, sizeof(rec.InstructionExt));
          #endif
 
          size = rec.InstructionExt.size;
-         addr = rec.InstructionExt.addr;
          inst.num_addresses = rec.InstructionExt.num_addresses;
          inst.is_branch = rec.InstructionExt.is_branch;
          inst.taken = rec.InstructionExt.taken;
@@ -498,8 +835,21 @@ bool Sift::Reader::Read(Instruction &inst)
 
       last_address += size;
 
-      for(int i = 0; i < inst.num_addresses; ++i)
-         input->read(reinterpret_cast<char*>(&inst.addresses[i]), sizeof(uint64_t));
+      if (m_address_delta && inst.num_addresses)
+      {
+         AddressPredictor &predictor = m_address_predictors[addr];
+
+         for(int i = 0; i < inst.num_addresses; ++i)
+         {
+            inst.addresses[i] = predictor.predict(i) + zigzagDecode(readVarint());
+            predictor.update(i, inst.addresses[i]);
+         }
+      }
+      else
+      {
+         for(int i = 0; i < inst.num_addresses; ++i)
+            readInput(reinterpret_cast<char*>(&inst.addresses[i]), sizeof(uint64_t));
+      }
 
       inst.sinst = getStaticInstruction(addr, size);
 
@@ -518,6 +868,107 @@ bool Sift::Reader::Read(Instruction &inst)
    return true;
 }
 
+bool Sift::Reader::loadIndex()
+{
+   if (!m_index.empty())
+      return true;
+   if (!m_indexed)
+      return false;
+
+   std::ifstream file(m_filename, std::ios::in | std::ios::binary);
+   IndexTrailer trailer;
+   file.seekg(-off_t(sizeof(trailer)), std::ios::end);
+   file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   if (file.fail() || trailer.magic != IndexMagicNumber)
+   {
+      // Most likely, the trace was not closed properly
+      std::cerr << "[SIFT:" << m_id << "] Trace " << m_filename << " does not have a valid index" << std::endl;
+      m_indexed = false;
+      return false;
+   }
+
+   file.seekg(trailer.offset);
+   file.read(reinterpret_cast<char*>(&m_index_header), sizeof(m_index_header));
+   m_index.resize(m_index_header.num_entries);
+   file.read(reinterpret_cast<char*>(&m_index[0]), m_index_header.num_entries * sizeof(IndexEntry));
+
+   // Icache and va2pa snapshots: merge in everything we do not know about yet
+   for(uint64_t i = 0; i < m_index_header.num_icache; ++i)
+   {
+      uint64_t address;
+      file.read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
+      if (icache.count(address))
+         file.seekg(ICACHE_SIZE, std::ios::cur);
+      else
+      {
+         uint8_t *bytes = new uint8_t[ICACHE_SIZE];
+         file.read(reinterpret_cast<char*>(bytes), ICACHE_SIZE);
+         icache[address] = bytes;
+      }
+   }
+   for(uint64_t i = 0; i < m_index_header.num_va2pa; ++i)
+   {
+      uint64_t vp, pp;
+      file.read(reinterpret_cast<char*>(&vp), sizeof(uint64_t));
+      file.read(reinterpret_cast<char*>(&pp), sizeof(uint64_t));
+      vcache[vp] = pp;
+   }
+   assert(!file.fail());
+
+   return !m_index.empty();
+}
+
+static bool compareIndexEntry(uint64_t icount, const Sift::IndexEntry &entry)
+{
+   return icount < entry.icount;
+}
+
+bool Sift::Reader::Seek(uint64_t icount)
+{
+   if (input == NULL)
+   {
+      initStream();
+   }
+
+   // Read-ahead restarts at the new position on the next Read()
+   stopReadAhead();
+
+   if (!loadIndex())
+      return false;
+
+   // Last index entry at or before icount
+   std::vector<IndexEntry>::const_iterator entry = std::upper_bound(m_index.begin(), m_index.end(), icount, compareIndexEntry);
+   assert(entry != m_index.begin());
+   --entry;
+
+   #if VERBOSE > 0
+   std::cerr << "[DEBUG:" << m_id << "] Seek to " << icount << ", index entry " << entry->icount << " at offset " << entry->offset << std::endl;
+   #endif
+
+   // Restart decompression at the block of this index entry
+   delete input;
+   inputstream = new std::ifstream(m_filename, std::ios::in);
+   inputstream->seekg(entry->offset);
+   m_blockstream = new iblockstream(new vifstream(inputstream), BlockCodec::create(m_compression_option));
+   m_blockstream_base = entry->offset;
+   input = m_blockstream;
+
+   // The first instruction of each indexed block carries its full address
+   last_address = 0;
+   m_last_sinst = NULL;
+   m_seen_end = false;
+
+   // Skip to icount without running callbacks, only reader state (icache, va2pa, address resets) is updated
+   Instruction inst;
+   bool success = true;
+   m_skipping = true;
+   for(uint64_t i = entry->icount; i < icount && success; ++i)
+      success = readInstruction(inst);
+   m_skipping = false;
+
+   return success;
+}
+
 void Sift::Reader::AccessMemory(MemoryLockType lock_signal, MemoryOpType mem_op, uint64_t d_addr, uint8_t *data_buffer, uint32_t data_size)
 {
    #if VERBOSE > 0
@@ -633,15 +1084,18 @@ const Sift::StaticInstruction* Sift::Reader::getStaticInstruction(uint64_t addr,
    {
       sinst = m_last_sinst->next;
    }
-   else if (scache.count(addr))
-   {
-      sinst = scache[addr];
-      assert(sinst->size == size);
-   }
    else
    {
-      sinst = decodeInstruction(addr, size);
-      scache[addr] = sinst;
+      const StaticInstruction* &entry = scache[addr];
+      if (entry)
+      {
+         assert(entry->size == size);
+      }
+      else
+      {
+         entry = decodeInstruction(addr, size);
+      }
+      sinst = entry;
    }
 
    if (m_last_sinst && m_last_sinst->next == NULL)
@@ -711,7 +1165,12 @@ void Sift::Reader::sendSimpleResponse(RecOtherType type, void *data, uint32_t si
 
 uint64_t Sift::Reader::getPosition()
 {
-   if (inputstream)
+   // The read-ahead thread moves the file pointer, use the position of the block being consumed instead
+   if (m_blockstream)
+      return m_blockstream_base + m_blockstream->getPosition();
+   else if (m_mmapstream)
+      return m_mmapstream->getPosition();
+   else if (inputstream)
       return inputstream->tellg();
    else
       return 0;
@@ -722,6 +1181,14 @@ uint64_t Sift::Reader::getLength()
    return filesize;
 }
 
+bool Sift::Reader::getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const
+{
+   if (input)
+      return input->getCompressionStats(compressed, uncompressed, ns);
+   else
+      return false;
+}
+
 uint64_t Sift::Reader::va2pa(uint64_t va)
 {
    if (m_trace_has_pa)
@@ -729,13 +1196,14 @@ uint64_t Sift::Reader::va2pa(uint64_t va)
       intptr_t vp = va / PAGE_SIZE;
       intptr_t vo = va & (PAGE_SIZE-1);
 
-      if (vcache.count(vp) == 0)
+      std::unordered_map<uint64_t, uint64_t>::const_iterator it = vcache.find(vp);
+      if (it == vcache.end())
       {
          return 0;
       }
       else
       {
-         intptr_t pp = vcache[vp];
+         intptr_t pp = it->second;
          return (pp * PAGE_SIZE) | vo;
       }
    }
@@ -744,3 +1212,9 @@ uint64_t Sift::Reader::va2pa(uint64_t va)
       return va;
    }
 }
+
+const uint8_t* Sift::Reader::getCodePage(uint64_t addr) const
+{
+   std::unordered_map<uint64_t, const uint8_t*>::const_iterator it = icache.find(addr & ICACHE_PAGE_MASK);
+   return it == icache.end() ? NULL : it->second;
+}
@@ -3,17 +3,25 @@
 
 #include "sift.h"
 #include "sift_format.h"
+#include "sift_pagetable.h"
+#include "sift_utils.h"
 
 extern "C" {
 #include "xed-interface.h"
 }
 
 #include <unordered_map>
+#include <vector>
 #include <fstream>
+#include <atomic>
+#include <functional>
+#include <pthread.h>
 #include <cassert>
 
 class vistream;
 class vostream;
+class iblockstream;
+class vmmapstream;
 
 namespace Sift
 {
@@ -83,6 +91,14 @@ namespace Sift
          void *handleRoutineArg;
          uint64_t filesize;
          std::ifstream *inputstream;
+         iblockstream *m_blockstream;
+         vmmapstream *m_mmapstream;
+         uint64_t m_blockstream_base;
+         uint64_t m_compression_option;
+         const char *m_compression;
+         bool m_indexed;
+         IndexHeader m_index_header;
+         std::vector<IndexEntry> m_index;
 
          char *m_filename;
          char *m_response_filename;
@@ -92,16 +108,53 @@ namespace Sift
 
          uint64_t last_address;
          std::unordered_map<uint64_t, const uint8_t*> icache;
-         std::unordered_map<uint64_t, const StaticInstruction*> scache;
+         PageTable<const StaticInstruction*> scache;
          std::unordered_map<uint64_t, uint64_t> vcache;
 
          uint32_t m_id;
 
          bool m_trace_has_pa;
+         bool m_trace_is_ia32;
+         bool m_trace_has_icache_per_insn;
+         bool m_address_delta;
+         AddressPredictorTable m_address_predictors;
          bool m_seen_end;
+         bool m_skipping;
          const StaticInstruction *m_last_sinst;
-
+         bool m_regular_file;
+
+         // Read-ahead: a producer thread parses and decodes instructions into a single-producer, single-consumer ring.
+         // All callbacks, and reader state used by the consumer (vcache), are deferred through the ring as events,
+         // so they are seen by the consumer in trace order.
+         struct ReadAheadEntry
+         {
+            enum { ENTRY_INSTRUCTION, ENTRY_EVENT, ENTRY_END } type;
+            Instruction inst;
+            std::function<void()> event;
+         };
+         size_t m_readahead_size;
+         bool m_readahead_running;
+         std::vector<ReadAheadEntry> m_readahead_ring;
+         std::atomic<uint64_t> m_readahead_head;      // Next entry to be produced
+         std::atomic<uint64_t> m_readahead_tail;      // Next entry to be consumed
+         std::atomic<bool> m_readahead_stop;
+         std::atomic<bool> m_readahead_producer_waiting;
+         std::atomic<bool> m_readahead_consumer_waiting;
+         pthread_t m_readahead_thread;
+         pthread_mutex_t m_readahead_lock;
+         pthread_cond_t m_readahead_cond;
+
+         bool readInstruction(Instruction &inst);
+         void deliver(const std::function<void()> &event);
+         bool pushEntry(ReadAheadEntry &entry);
+         void startReadAhead();
+         void stopReadAhead();
+         static void* readAheadThread(void *arg);
          void initResponse();
+         bool loadIndex();
+         void readInput(char *dst, std::streamsize n);
+         uint64_t readVarint();
+         int peekInput();
          const Sift::StaticInstruction* decodeInstruction(uint64_t addr, uint8_t size);
          const Sift::StaticInstruction* getStaticInstruction(uint64_t addr, uint8_t size);
          void sendSyscallResponse(uint64_t return_code);
@@ -112,7 +165,13 @@ namespace Sift
          Reader(const char *filename, const char *response_filename = "", uint32_t id = 0);
          ~Reader();
          void initStream();
+         // Parse and decode up to <entries> instructions ahead on a separate thread (0 = disabled).
+         // Only used for trace files without response files, must be set before the first Read().
+         void setReadAhead(size_t entries) { m_readahead_size = entries; }
          bool Read(Instruction&);
+         // Continue reading at instruction number <icount>, requires an indexed trace.
+         // No callbacks are made for the records that are skipped.
+         bool Seek(uint64_t icount);
          void AccessMemory(MemoryLockType lock_signal, MemoryOpType mem_op, uint64_t d_addr, uint8_t *data_buffer, uint32_t data_size);
 
          void setHandleInstructionCountFunc(HandleInstructionCountFunc func, void* arg = NULL) { handleInstructionCountFunc = func; handleInstructionCountArg = arg; }
@@ -128,7 +187,19 @@ namespace Sift
 
          uint64_t getPosition();
          uint64_t getLength();
+         const char* getCompression() const { return m_compression; }
+         // Compressed and uncompressed bytes read so far, and time spent decompressing them
+         bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const;
          bool getTraceHasPhysicalAddresses() const { return m_trace_has_pa; }
+         bool getTraceIsIA32() const { return m_trace_is_ia32; }
+         bool getTraceHasIcachePerInstruction() const { return m_trace_has_icache_per_insn; }
+         // Code page containing addr as received so far (ICACHE_SIZE bytes), NULL if none of it was seen
+         const uint8_t* getCodePage(uint64_t addr) const;
+         bool isIndexed() const { return m_indexed; }
+         // Total number of instructions according to the index, zero when not available
+         uint64_t getNumInstructions() { return loadIndex() ? m_index_header.num_instructions : 0; }
+         // IndexFlag* bits according to the index, zero when not available
+         uint64_t getIndexFlags() { return loadIndex() ? m_index_header.flags : 0; }
          uint64_t va2pa(uint64_t va);
    };
 };
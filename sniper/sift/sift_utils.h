@@ -2,10 +2,81 @@
 #define __SIFT_UTILS_H
 
 #include "sift.h"
+#include "sift_pagetable.h"
 
 namespace Sift
 {
    void hexdump(const void * data, uint32_t size);
+
+   // Variable-length integers for the AddressDelta format: 7 bits per byte, least significant first,
+   // the top bit is set on all but the last byte.  Signed values are zigzag-encoded first, so small
+   // negative values are short as well.
+   const unsigned int MAX_VARINT_SIZE = 10;
+
+   inline uint64_t zigzagEncode(uint64_t value) { return (value << 1) ^ uint64_t(int64_t(value) >> 63); }
+   inline uint64_t zigzagDecode(uint64_t value) { return (value >> 1) ^ -(value & 1); }
+
+   // Writes value to buffer, returns the number of bytes used
+   inline unsigned int varintEncode(uint64_t value, uint8_t *buffer)
+   {
+      unsigned int n = 0;
+      while(value >= 0x80)
+      {
+         buffer[n++] = uint8_t(value) | 0x80;
+         value >>= 7;
+      }
+      buffer[n++] = uint8_t(value);
+      return n;
+   }
+
+   // Predicts each memory address of a static instruction as its previous address plus the previous stride,
+   // so strided accesses are encoded in a single byte.  The first address of an operand only sets last,
+   // its stride stays zero so the second address is predicted as a repeat of the first.
+   struct AddressPredictor
+   {
+      uint64_t last[MAX_DYNAMIC_ADDRESSES];
+      uint64_t stride[MAX_DYNAMIC_ADDRESSES];
+      bool valid[MAX_DYNAMIC_ADDRESSES];
+      uint64_t epoch;
+
+      AddressPredictor(uint64_t epoch = 0) : last(), stride(), valid(), epoch(epoch) {}
+
+      uint64_t predict(unsigned int idx) const { return last[idx] + stride[idx]; }
+      void update(unsigned int idx, uint64_t address)
+      {
+         stride[idx] = valid[idx] ? address - last[idx] : 0;
+         last[idx] = address;
+         valid[idx] = true;
+      }
+   };
+
+   // Address predictors for all static instructions, which can all be reset at once
+   class AddressPredictorTable
+   {
+      private:
+         PageTable<AddressPredictor*> m_predictors;
+         uint64_t m_epoch;
+
+      public:
+         AddressPredictorTable() : m_epoch(0) {}
+         ~AddressPredictorTable()
+         {
+            m_predictors.forEach([](uint64_t addr, AddressPredictor *predictor) { delete predictor; });
+         }
+
+         AddressPredictor& operator[](uint64_t addr)
+         {
+            AddressPredictor* &predictor = m_predictors[addr];
+            if (!predictor)
+               predictor = new AddressPredictor(m_epoch);
+            else if (predictor->epoch != m_epoch)
+               *predictor = AddressPredictor(m_epoch);
+            return *predictor;
+         }
+
+         // Forget all previous addresses, predictors are cleared lazily on their next use
+         void reset() { ++m_epoch; }
+   };
 };
 
 #endif // __SIFT_UTILS_H
@@ -4,9 +4,12 @@
 #include "sift_utils.h"
 #include "sift_assert.h"
 #include "zfstream.h"
+#include "blockstream.h"
+#include "shmstream.h"
 
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <iostream>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -30,7 +33,7 @@ __sift_assert_fail(__const char *__assertion, __const char *__file,
 }
 
 
-Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, bool send_va2pa_mapping)
+Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, uint64_t compression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, bool send_va2pa_mapping, uint32_t compression_threads, uint64_t index_interval, bool shared_memory, bool address_delta, const BlockThreadFuncs *thread_funcs)
    : response(NULL)
    , getCodeFunc(getCodeFunc)
    , ninstrs(0)
@@ -45,21 +48,67 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    , m_id(id)
    , m_requires_icache_per_insn(requires_icache_per_insn)
    , m_send_va2pa_mapping(send_va2pa_mapping)
+   , m_address_delta(address_delta)
+   , m_rawoutput(NULL)
+   , m_blockstream(NULL)
+   , m_index_interval(index_interval)
+   , m_index_flags(0)
+   , m_shm_response(NULL)
 {
    memset(hsize, 0, sizeof(hsize));
    memset(haddr, 0, sizeof(haddr));
 
    m_response_filename = strdup(response_filename);
 
-   uint64_t options = 0;
-   if (useCompression)
-      options |= CompressionZlib;
+   // One of the Compression* options (zero for none)
+   sift_assert((compression & ~CompressionMask) == 0);
+   uint64_t options = compression;
    if (arch32)
       options |= ArchIA32;
    if (requires_icache_per_insn)
       options |= IcacheVariable;
    if (m_send_va2pa_mapping)
       options |= PhysicalAddress;
+   if (m_address_delta)
+      options |= AddressDelta;
+   if (m_index_interval)
+   {
+      // Seeking requires independently compressed blocks
+      sift_assert(options & (CompressionZstd | CompressionLZ4));
+      options |= Indexed;
+   }
+
+   // Shared-memory transport: create the rings, and send their location in the extra header
+   ShmRing *shm_output = NULL;
+   char shm_filename[MAXPATHLEN] = "";
+   if (shared_memory)
+   {
+      // Only for uncompressed streams to a live simulator, which unlinks the ring files once it has mapped them
+      sift_assert(compression == 0 && !m_index_interval);
+
+      static uint32_t shm_counter = 0;
+      if (access("/dev/shm", W_OK) == 0)
+         snprintf(shm_filename, sizeof(shm_filename), "/dev/shm/sift-%d-%u-%u", getpid(), id, __sync_fetch_and_add(&shm_counter, 1));
+      else
+         snprintf(shm_filename, sizeof(shm_filename), "%s.shm%u", filename, __sync_fetch_and_add(&shm_counter, 1));
+
+      shm_output = ShmRing::create(shm_filename, 4 << 20);
+      if (shm_output && strcmp(response_filename, "") != 0)
+      {
+         String response_shm_filename = String(shm_filename) + ".response";
+         m_shm_response = ShmRing::create(response_shm_filename.c_str(), 256 << 10);
+         if (!m_shm_response)
+         {
+            delete shm_output;
+            shm_output = NULL;
+            unlink(shm_filename);
+         }
+      }
+
+      // Fall back to the regular transport when shared memory is not available
+      if (shm_output)
+         options |= SharedMemory;
+   }
 
    output = new vofstream(filename, std::ios::out | std::ios::binary | std::ios::trunc);
 
@@ -68,11 +117,29 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    #endif
 
    Sift::Header hdr = { Sift::MagicNumber, 0 /* header size */, options, {}};
+   if (options & SharedMemory)
+      hdr.size = strlen(shm_filename) + 1;
    output->write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (hdr.size)
+      output->write(shm_filename, hdr.size);
    output->flush();
 
+   if (options & SharedMemory)
+   {
+      delete output;
+      output = new oshmstream(shm_output);
+   }
+
    if (options & CompressionZlib)
       output = new ozstream(output);
+   else if (options & (CompressionZstd | CompressionLZ4))
+   {
+      BlockCodec *codec = BlockCodec::create(options & (CompressionZstd | CompressionLZ4));
+      sift_assert(codec); // Codec not supported by this build
+      m_rawoutput = output;
+      m_blockstream = new oblockstream(output, codec, compression_threads, thread_funcs);
+      output = m_blockstream;
+   }
 }
 
 // Modified from http://stackoverflow.com/questions/2203159/is-there-a-c-equivalent-to-getcwd
@@ -84,7 +151,12 @@ String get_working_path()
 
 void Sift::Writer::initResponse()
 {
-   if (!response)
+   if (!response && m_shm_response)
+   {
+      response = new ishmstream(m_shm_response);
+      m_shm_response = NULL;
+   }
+   else if (!response)
    {
      sift_assert(strcmp(m_response_filename, "") != 0);
      response = new vifstream(m_response_filename, std::ios::in);
@@ -106,6 +178,9 @@ void Sift::Writer::End()
       rec.Other.size = 0;
       output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
       output->flush();
+
+      if (m_index_interval)
+         writeIndex();
    }
 
    if (response)
@@ -125,11 +200,21 @@ void Sift::Writer::End()
       response = NULL;
    }
 
+   if (m_shm_response)
+   {
+      delete m_shm_response;
+      m_shm_response = NULL;
+   }
+
    if (output)
    {
       delete output;
       output = NULL;
    }
+
+   for(auto it = m_icache_snapshot.begin(); it != m_icache_snapshot.end(); ++it)
+      delete [] it->second;
+   m_icache_snapshot.clear();
 }
 
 Sift::Writer::~Writer()
@@ -155,6 +240,9 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
    sift_assert(size < 16);
    sift_assert(num_addresses <= MAX_DYNAMIC_ADDRESSES);
 
+   if (m_index_interval && ninstrs % m_index_interval == 0)
+      addIndexEntry();
+
    if (m_requires_icache_per_insn)
    {
       if (! icache[addr])
@@ -172,6 +260,8 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
          uint8_t buffer[16] = {0};
          getCodeFunc(buffer, reinterpret_cast<const uint8_t *>(addr), size);
          output->write(reinterpret_cast<char*>(buffer), size);
+         if (m_index_interval)
+            snapshotCode(addr, buffer, size);
 
          #if VERBOSE_ICACHE
          hexdump((char*)buffer, sizeof(buffer));
@@ -200,6 +290,8 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
             uint8_t buffer[ICACHE_SIZE];
             getCodeFunc(buffer, (const uint8_t *)base_addr, ICACHE_SIZE);
             output->write(reinterpret_cast<char*>(buffer), ICACHE_SIZE);
+            if (m_index_interval)
+               snapshotCode(base_addr, buffer, ICACHE_SIZE);
 
             icache[base_addr] = true;
          }
@@ -250,8 +342,20 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
       rec.InstructionExt.taken = taken;
       rec.InstructionExt.is_predicate = is_predicate;
       rec.InstructionExt.executed = executed;
-      rec.InstructionExt.addr = addr;
-      output->write(reinterpret_cast<char*>(&rec), sizeof(rec.InstructionExt));
+      if (m_address_delta)
+      {
+         // Replace the full address with its distance from where the previous instruction ended
+         uint8_t buffer[sizeof(rec.InstructionExt) - sizeof(rec.InstructionExt.addr) + MAX_VARINT_SIZE];
+         unsigned int n = sizeof(rec.InstructionExt) - sizeof(rec.InstructionExt.addr);
+         memcpy(buffer, &rec, n);
+         n += varintEncode(zigzagEncode(addr - last_address), buffer + n);
+         output->write(reinterpret_cast<char*>(buffer), n);
+      }
+      else
+      {
+         rec.InstructionExt.addr = addr;
+         output->write(reinterpret_cast<char*>(&rec), sizeof(rec.InstructionExt));
+      }
 
       #if VERBOSE_HEX > 2
       hexdump((char*)&rec, sizeof(rec.InstructionExt));
@@ -262,8 +366,24 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
       ninstrext++;
    }
 
-   for(int i = 0; i < num_addresses; ++i)
-      output->write(reinterpret_cast<char*>(&addresses[i]), sizeof(uint64_t));
+   if (m_address_delta && num_addresses)
+   {
+      AddressPredictor &predictor = m_address_predictors[addr];
+
+      uint8_t buffer[MAX_DYNAMIC_ADDRESSES * MAX_VARINT_SIZE];
+      unsigned int n = 0;
+      for(int i = 0; i < num_addresses; ++i)
+      {
+         n += varintEncode(zigzagEncode(addresses[i] - predictor.predict(i)), buffer + n);
+         predictor.update(i, addresses[i]);
+      }
+      output->write(reinterpret_cast<char*>(buffer), n);
+   }
+   else
+   {
+      for(int i = 0; i < num_addresses; ++i)
+         output->write(reinterpret_cast<char*>(&addresses[i]), sizeof(uint64_t));
+   }
 
    last_address += size;
 
@@ -317,6 +437,7 @@ void Sift::Writer::CacheOnly(uint8_t icount, CacheOnlyType type, uint64_t eip, u
 
    send_va2pa(eip);
    send_va2pa(address);
+   m_index_flags |= IndexHasCacheOnly;
 
    uint8_t _type = type;
 
@@ -692,6 +813,8 @@ bool Sift::Writer::Emulate(Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuR
 
 void Sift::Writer::RoutineChange(Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
 {
+   m_index_flags |= IndexHasRoutines;
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherRoutineChange;
@@ -707,6 +830,7 @@ void Sift::Writer::RoutineChange(Sift::RoutineOpType event, uint64_t eip, uint64
 void Sift::Writer::RoutineAnnounce(uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename)
 {
    uint16_t len_name = strlen(name) + 1, len_imgname = strlen(imgname) + 1, len_filename = strlen(filename) + 1;
+   m_index_flags |= IndexHasRoutines;
 
    Record rec;
    rec.Other.zero = 0;
@@ -855,7 +979,91 @@ void Sift::Writer::send_va2pa(uint64_t va)
             output->write(reinterpret_cast<char*>(&pp), sizeof(uint64_t));
 
             m_va2pa[vp] = true;
+            if (m_index_interval)
+               m_va2pa_snapshot[vp] = pp;
          }
       }
    }
 }
+
+void Sift::Writer::addIndexEntry()
+{
+   // Start a new block, and make the reader's and our notion of the previous address agree
+   // so the first instruction of the block is sent with its full address
+   uint64_t seq = m_blockstream->cut();
+   m_index.push_back(std::make_pair(ninstrs, seq));
+   last_address = 0;
+
+   if (m_address_delta)
+   {
+      // Deltas cannot refer to anything before the block, tell a reader that did not seek here
+      m_address_predictors.reset();
+
+      Record rec;
+      rec.Other.zero = 0;
+      rec.Other.type = RecOtherAddressReset;
+      rec.Other.size = 0;
+      output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
+   }
+}
+
+void Sift::Writer::snapshotCode(uint64_t addr, const uint8_t *bytes, uint32_t size)
+{
+   while(size > 0)
+   {
+      uint64_t base_addr = addr & ICACHE_PAGE_MASK;
+      uint8_t *&page = m_icache_snapshot[base_addr];
+      if (!page)
+      {
+         page = new uint8_t[ICACHE_SIZE];
+         memset(page, 0, ICACHE_SIZE);
+      }
+      uint64_t offset = addr & ICACHE_OFFSET_MASK;
+      uint32_t amount = std::min(size, uint32_t(ICACHE_SIZE - offset));
+      memcpy(page + offset, bytes, amount);
+      addr += amount;
+      bytes += amount;
+      size -= amount;
+   }
+}
+
+void Sift::Writer::writeIndex()
+{
+   #if VERBOSE > 0
+   std::cerr << "[DEBUG:" << m_id << "] Write Index" << std::endl;
+   #endif
+
+   // Write out all blocks so their offsets are known, the index follows the end-of-stream marker
+   m_blockstream->finish();
+
+   IndexHeader hdr;
+   hdr.num_instructions = ninstrs;
+   hdr.interval = m_index_interval;
+   hdr.num_entries = m_index.size();
+   hdr.num_icache = m_icache_snapshot.size();
+   hdr.num_va2pa = m_va2pa_snapshot.size();
+   hdr.flags = m_index_flags;
+
+   IndexTrailer trailer;
+   trailer.offset = sizeof(Header) + m_blockstream->getBytesWritten();
+   trailer.magic = IndexMagicNumber;
+
+   m_rawoutput->write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   for(auto it = m_index.begin(); it != m_index.end(); ++it)
+   {
+      IndexEntry entry = { it->first, sizeof(Header) + m_blockstream->getBlockOffset(it->second) };
+      m_rawoutput->write(reinterpret_cast<char*>(&entry), sizeof(entry));
+   }
+   for(auto it = m_icache_snapshot.begin(); it != m_icache_snapshot.end(); ++it)
+   {
+      m_rawoutput->write(reinterpret_cast<const char*>(&it->first), sizeof(uint64_t));
+      m_rawoutput->write(reinterpret_cast<char*>(it->second), ICACHE_SIZE);
+   }
+   for(auto it = m_va2pa_snapshot.begin(); it != m_va2pa_snapshot.end(); ++it)
+   {
+      m_rawoutput->write(reinterpret_cast<const char*>(&it->first), sizeof(uint64_t));
+      m_rawoutput->write(reinterpret_cast<const char*>(&it->second), sizeof(uint64_t));
+   }
+   m_rawoutput->write(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   m_rawoutput->flush();
+}
@@ -3,13 +3,18 @@
 
 #include "sift.h"
 #include "sift_format.h"
+#include "sift_utils.h"
 
 #include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <assert.h>
 
 class vistream;
 class vostream;
+class oblockstream;
+struct BlockThreadFuncs;
+class ShmRing;
 
 namespace Sift
 {
@@ -34,14 +39,31 @@ namespace Sift
          uint32_t m_id;
          bool m_requires_icache_per_insn;
          bool m_send_va2pa_mapping;
+         bool m_address_delta;
+         AddressPredictorTable m_address_predictors;
+
+         // Index state, see IndexTrailer
+         vostream *m_rawoutput;
+         oblockstream *m_blockstream;
+         uint64_t m_index_interval;
+         std::vector<std::pair<uint64_t, uint64_t> > m_index;     // (instruction count, block sequence number)
+         std::unordered_map<uint64_t, uint8_t*> m_icache_snapshot;
+         std::unordered_map<uint64_t, uint64_t> m_va2pa_snapshot;
+         uint64_t m_index_flags;
+
+         // Response ring of the shared-memory transport, until the response channel is first used
+         ShmRing *m_shm_response;
 
          void initResponse();
+         void addIndexEntry();
+         void writeIndex();
+         void snapshotCode(uint64_t addr, const uint8_t *bytes, uint32_t size);
          void handleMemoryRequest(Record &respRec);
          void send_va2pa(uint64_t va);
          uint64_t va2pa_lookup(uint64_t va);
 
       public:
-         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, bool send_va2pa_mapping = false);
+         Writer(const char *filename, GetCodeFunc getCodeFunc, uint64_t compression = 0, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, bool send_va2pa_mapping = false, uint32_t compression_threads = 0, uint64_t index_interval = 0, bool shared_memory = false, bool address_delta = false, const BlockThreadFuncs *thread_funcs = NULL);
          ~Writer();
          void End();
          void Instruction(uint64_t addr, uint8_t size, uint8_t num_addresses, uint64_t addresses[], bool is_branch, bool taken, bool is_predicate, bool executed);
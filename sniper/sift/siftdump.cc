@@ -8,6 +8,7 @@
 #include <cstring>
 #include <map>
 #include <unordered_map>
+#include <time.h>
 
 #if PIN_REV >= 67254
 extern "C" {
@@ -15,9 +16,47 @@ extern "C" {
 }
 #endif
 
+static double now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
 int main(int argc, char* argv[])
 {
-   if (argc > 1 && strcmp(argv[1], "-d") == 0)
+   if (argc > 2 && strcmp(argv[1], "-s") == 0)
+   {
+      // Read through the whole trace and report compression ratio and decoding throughput
+      Sift::Reader reader(argv[2]);
+
+      double t_start = now();
+      uint64_t icount = 0;
+      Sift::Instruction inst;
+      while(reader.Read(inst))
+         ++icount;
+      double t_total = now() - t_start;
+
+      uint64_t compressed = reader.getLength(), uncompressed = reader.getLength(), ns = 0;
+      bool have_stats = reader.getCompressionStats(compressed, uncompressed, ns);
+
+      printf("compression        %s\n", reader.getCompression());
+      printf("file size          %" PRIu64 "\n", reader.getLength());
+      if (have_stats)
+      {
+         printf("uncompressed size  %" PRIu64 "\n", uncompressed);
+         printf("compression ratio  %.2f\n", compressed ? double(uncompressed) / compressed : 0.);
+      }
+      printf("instructions       %" PRIu64 "\n", icount);
+      if (reader.isIndexed())
+         printf("indexed            %s\n", reader.getNumInstructions() == icount ? "yes" : "invalid");
+      printf("bytes/instruction  %.2f\n", icount ? double(reader.getLength()) / icount : 0.);
+      printf("read time          %.3f s\n", t_total);
+      if (ns)
+         printf("decompress time    %.3f s\n", ns / 1e9);
+      printf("throughput         %.1f MB/s, %.2f MIPS\n", uncompressed / t_total / 1e6, icount / t_total / 1e6);
+   }
+   else if (argc > 1 && strcmp(argv[1], "-d") == 0)
    {
       Sift::Reader reader(argv[2]);
       const xed_syntax_enum_t syntax = XED_SYNTAX_ATT;
@@ -100,6 +139,6 @@ int main(int argc, char* argv[])
    }
    else
    {
-      printf("Usage: %s [-d] <file.sift>\n", argv[0]);
+      printf("Usage: %s [-d|-s] <file.sift>\n", argv[0]);
    }
 }
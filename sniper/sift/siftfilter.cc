@@ -0,0 +1,474 @@
+#define __STDC_FORMAT_MACROS
+
+#include "sift_reader.h"
+#include "sift_writer.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+// Cut regions out of SIFT traces, concatenate them, and convert them to another encoding, without re-recording.
+//
+// All input traces are read in order as a single instruction stream.  The region that is written out starts
+// after the <begin>-th magic instruction (xchg %bx,%bx, as executed by SimRoiStart(), SimMarker() etc.)
+// and after skipping a number of instructions, and ends at the <end>-th magic instruction or after a maximum
+// number of instructions.  Code bytes are taken from the input traces themselves, so inputs that are
+// concatenated must come from the same program.  Memory use does not depend on the length of the traces.
+
+namespace
+{
+   const uint8_t MAGIC_INSTRUCTION[] = { 0x66, 0x87, 0xdb };   // xchg %bx, %bx
+   const uint32_t MAX_CACHEONLY_ICOUNT = 255;                  // CacheOnly records have an 8-bit instruction count
+
+   struct Compression
+   {
+      const char *name;
+      uint64_t option;
+   };
+   const Compression compressions[] = {
+      { "none", 0 },
+      { "zlib", Sift::CompressionZlib },
+      { "zstd", Sift::CompressionZstd },
+      { "lz4", Sift::CompressionLZ4 },
+   };
+
+   bool findCompression(const char *name, uint64_t &option)
+   {
+      for(unsigned int i = 0; i < sizeof(compressions) / sizeof(compressions[0]); ++i)
+      {
+         if (strcmp(compressions[i].name, name) == 0)
+         {
+            option = compressions[i].option;
+            return true;
+         }
+      }
+      return false;
+   }
+
+   bool isMagicInstruction(const Sift::StaticInstruction *sinst)
+   {
+      return sinst->size == sizeof(MAGIC_INSTRUCTION) && memcmp(sinst->data, MAGIC_INSTRUCTION, sizeof(MAGIC_INSTRUCTION)) == 0;
+   }
+
+   // The Sift::Writer asks for code bytes through a plain function pointer: copy them from the input being read
+   Sift::Reader *current_reader = NULL;
+
+   void getCode(uint8_t *dst, const uint8_t *src, uint32_t size)
+   {
+      uint64_t addr = (uint64_t)src;
+      while(size)
+      {
+         uint32_t offset = addr & Sift::ICACHE_OFFSET_MASK;
+         uint32_t amount = std::min(size, Sift::ICACHE_SIZE - offset);
+         const uint8_t *page = current_reader->getCodePage(addr);
+         if (page)
+            memcpy(dst, page + offset, amount);
+         else
+            memset(dst, 0, amount);
+         dst += amount;
+         addr += amount;
+         size -= amount;
+      }
+   }
+
+   class Filter
+   {
+      public:
+         struct Options
+         {
+            uint64_t begin_marker;        // Start after this magic instruction (1-based, 0 = from the start)
+            uint64_t end_marker;          // Stop at this magic instruction (0 = no limit)
+            uint64_t skip;                // Instructions to skip after the start
+            uint64_t count;               // Maximum number of instructions to write (0 = no limit)
+            bool memory_only;             // Write CacheOnly records instead of instructions
+         };
+
+      private:
+         enum state_t { STATE_BEGIN, STATE_SKIP, STATE_ACTIVE, STATE_DONE };
+
+         Sift::Writer *m_writer;
+         const Options m_options;
+         state_t m_state;
+         uint64_t m_markers;
+         uint64_t m_skipped;
+         bool m_seeking;
+
+         // Memory-only output: instructions not yet accounted for in a CacheOnly record,
+         // and a conditional branch whose target is only known once the next instruction is seen
+         uint32_t m_pending_icount;
+         bool m_pending_branch;
+         bool m_branch_taken;
+         uint64_t m_branch_eip, m_branch_fallthrough;
+         uint64_t m_last_eip;
+         uint8_t m_last_size;
+
+         static void __handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
+         { ((Filter*)arg)->handleCacheOnly(icount, type, eip, address); }
+         static void __handleOutputFunc(void* arg, uint8_t fd, const uint8_t *data, uint32_t size)
+         { ((Filter*)arg)->handleOutput(fd, data, size); }
+         static void __handleRoutineChangeFunc(void* arg, Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
+         { ((Filter*)arg)->handleRoutineChange(event, eip, esp, callEip); }
+         static void __handleRoutineAnnounceFunc(void* arg, uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename)
+         { ((Filter*)arg)->handleRoutineAnnounce(eip, name, imgname, offset, line, column, filename); }
+
+         // Account for <icount> input instructions, returns whether they are part of the selected region
+         bool select(uint64_t icount, bool is_marker)
+         {
+            if (is_marker)
+               ++m_markers;
+
+            switch(m_state)
+            {
+               case STATE_BEGIN:
+                  if (is_marker && m_markers == m_options.begin_marker)
+                     m_state = STATE_SKIP;
+                  return false;
+               case STATE_SKIP:
+                  if (m_skipped + icount <= m_options.skip)
+                  {
+                     m_skipped += icount;
+                     return false;
+                  }
+                  m_state = STATE_ACTIVE;
+                  // fall through
+               case STATE_ACTIVE:
+                  if ((is_marker && m_markers == m_options.end_marker) || (m_options.count && written >= m_options.count))
+                  {
+                     m_state = STATE_DONE;
+                     return false;
+                  }
+                  written += icount;
+                  return true;
+               case STATE_DONE:
+                  return false;
+            }
+            return false;
+         }
+
+         void cacheOnly(Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
+         {
+            m_writer->CacheOnly(m_pending_icount, type, eip, address);
+            m_pending_icount = 0;
+         }
+
+         void flushBranch(uint64_t next_eip)
+         {
+            if (m_pending_branch)
+            {
+               cacheOnly(m_branch_taken ? Sift::CacheOnlyBranchTaken : Sift::CacheOnlyBranchNotTaken, m_branch_eip, m_branch_taken ? next_eip : m_branch_fallthrough);
+               m_pending_branch = false;
+            }
+         }
+
+         // Instructions without memory accesses or branches are counted by the next CacheOnly record,
+         // when too many of them have accumulated, account for them as an instruction fetch
+         void flushIcount(uint32_t room)
+         {
+            if (m_pending_icount + room > MAX_CACHEONLY_ICOUNT)
+               cacheOnly(Sift::CacheOnlyMemIcache, m_last_eip, m_last_size);
+         }
+
+         void writeMemoryOnly(const Sift::Instruction &inst)
+         {
+            flushIcount(1);
+            ++m_pending_icount;
+            m_last_eip = inst.sinst->addr;
+            m_last_size = inst.sinst->size;
+
+            const xed_decoded_inst_t *xed_inst = &inst.sinst->xed_inst;
+            if (inst.executed && !xed_decoded_inst_get_attribute(xed_inst, XED_ATTRIBUTE_NOP))
+            {
+               uint32_t num_operands = std::min<uint32_t>(xed_decoded_inst_number_of_memory_operands(xed_inst), inst.num_addresses);
+               for(uint32_t i = 0; i < num_operands; ++i)
+               {
+                  if (xed_decoded_inst_mem_read(xed_inst, i))
+                     cacheOnly(Sift::CacheOnlyMemRead, inst.sinst->addr, inst.addresses[i]);
+                  if (xed_decoded_inst_mem_written(xed_inst, i))
+                     cacheOnly(Sift::CacheOnlyMemWrite, inst.sinst->addr, inst.addresses[i]);
+               }
+            }
+
+            // Only conditional branches are marked as such in the trace
+            if (inst.is_branch)
+            {
+               m_pending_branch = true;
+               m_branch_taken = inst.taken;
+               m_branch_eip = inst.sinst->addr;
+               m_branch_fallthrough = inst.sinst->addr + inst.sinst->size;
+            }
+         }
+
+         void handleCacheOnly(uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
+         {
+            if (m_seeking)
+               return;
+            if (m_options.memory_only)
+               flushBranch(eip);
+            if (!select(icount, false))
+               return;
+            flushIcount(icount);
+            m_pending_icount += icount;
+            cacheOnly(type, eip, address);
+         }
+
+         void handleOutput(uint8_t fd, const uint8_t *data, uint32_t size)
+         {
+            if (m_seeking)
+               return;
+            if (m_state == STATE_ACTIVE)
+               m_writer->Output(fd, (const char*)data, size);
+         }
+
+         void handleRoutineChange(Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
+         {
+            if (m_seeking)
+               return;
+            if (m_state == STATE_ACTIVE)
+               m_writer->RoutineChange(event, eip, esp, callEip);
+         }
+
+         void handleRoutineAnnounce(uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename)
+         {
+            // Routine names are needed for any RoutineChange record that follows, also for those in the selected region
+            m_writer->RoutineAnnounce(eip, name, imgname, offset, line, column, filename);
+         }
+
+      public:
+         uint64_t instructions;           // Instructions read
+         uint64_t written;                // Instructions written
+
+         Filter(Sift::Writer *writer, const Options &options)
+            : m_writer(writer)
+            , m_options(options)
+            , m_state(options.begin_marker ? STATE_BEGIN : STATE_SKIP)
+            , m_markers(0)
+            , m_skipped(0)
+            , m_seeking(false)
+            , m_pending_icount(0)
+            , m_pending_branch(false)
+            , m_branch_taken(false)
+            , m_branch_eip(0)
+            , m_branch_fallthrough(0)
+            , m_last_eip(0)
+            , m_last_size(0)
+            , instructions(0)
+            , written(0)
+         {
+         }
+
+         bool done() const { return m_state == STATE_DONE; }
+
+         void read(Sift::Reader &reader, const char *filename)
+         {
+            current_reader = &reader;
+            reader.setHandleCacheOnlyFunc(__handleCacheOnlyFunc, this);
+            reader.setHandleOutputFunc(__handleOutputFunc, this);
+            reader.setHandleRoutineFunc(__handleRoutineChangeFunc, __handleRoutineAnnounceFunc, this);
+
+            // Without markers to count, jump straight to the start of the region when the trace has an index.
+            // Not when skipped records need to be seen: routine announcements are always copied, and the
+            // instruction counts of CacheOnly records are not part of the index.
+            if (m_state == STATE_SKIP && instructions == 0 && m_options.skip && !m_options.end_marker
+                && reader.isIndexed() && m_options.skip < reader.getNumInstructions()
+                && !(reader.getIndexFlags() & (Sift::IndexHasRoutines | Sift::IndexHasCacheOnly)))
+            {
+               // The reader makes no callbacks for skipped records, ignore them here as well so select() does not count them twice
+               m_seeking = true;
+               bool sought = reader.Seek(m_options.skip);
+               m_seeking = false;
+               if (sought)
+               {
+                  instructions = m_skipped = m_options.skip;
+                  m_state = STATE_ACTIVE;
+               }
+            }
+
+            Sift::Instruction inst;
+            while(!done() && reader.Read(inst))
+            {
+               if ((instructions++ & 0xfffff) == 0 && reader.getLength())
+                  fprintf(stderr, "Reading SIFT trace %s: %" PRId64 "%%\r", filename, 100 * reader.getPosition() / reader.getLength());
+
+               if (m_options.memory_only)
+                  flushBranch(inst.sinst->addr);
+               if (!select(1, isMagicInstruction(inst.sinst)))
+                  continue;
+
+               if (m_options.memory_only)
+                  writeMemoryOnly(inst);
+               else
+                  m_writer->Instruction(inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.addresses, inst.is_branch, inst.taken, inst.is_predicate, inst.executed);
+            }
+            fprintf(stderr, "%*s\r", int(strlen(filename)) + 25, "");
+
+            current_reader = NULL;
+         }
+
+         void finish()
+         {
+            if (m_options.memory_only)
+            {
+               flushBranch(m_branch_fallthrough);
+               if (m_pending_icount)
+                  cacheOnly(Sift::CacheOnlyMemIcache, m_last_eip, m_last_size);
+            }
+            m_writer->End();
+         }
+   };
+
+   void listMarkers(int argc, char* argv[])
+   {
+      uint64_t icount = 0, markers = 0;
+      printf("%-8s %16s %18s  %s\n", "marker", "instruction", "address", "trace");
+      for(int i = 0; i < argc; ++i)
+      {
+         Sift::Reader reader(argv[i]);
+         Sift::Instruction inst;
+         while(reader.Read(inst))
+         {
+            if (isMagicInstruction(inst.sinst))
+               printf("%-8" PRIu64 " %16" PRIu64 " %18" PRIx64 "  %s\n", ++markers, icount, inst.sinst->addr, argv[i]);
+            ++icount;
+         }
+      }
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   Filter::Options options = { 0, 0, 0, 0, false };
+   const char *compression = NULL;
+   unsigned int compression_threads = 0;
+   uint64_t index_interval = 0;
+   bool icache_per_insn = false, address_delta = true, list = false;
+
+   int opt;
+   while((opt = getopt(argc, argv, "b:e:s:n:c:j:x:imrl")) != -1)
+   {
+      switch(opt)
+      {
+         case 'b':
+            options.begin_marker = strtoull(optarg, NULL, 0);
+            break;
+         case 'e':
+            options.end_marker = strtoull(optarg, NULL, 0);
+            break;
+         case 's':
+            options.skip = strtoull(optarg, NULL, 0);
+            break;
+         case 'n':
+            options.count = strtoull(optarg, NULL, 0);
+            break;
+         case 'c':
+            compression = optarg;
+            break;
+         case 'j':
+            compression_threads = strtoul(optarg, NULL, 0);
+            break;
+         case 'x':
+            index_interval = strtoull(optarg, NULL, 0);
+            break;
+         case 'i':
+            icache_per_insn = true;
+            break;
+         case 'm':
+            options.memory_only = true;
+            break;
+         case 'r':
+            address_delta = false;
+            break;
+         case 'l':
+            list = true;
+            break;
+         default:
+            optind = argc + 1;
+            break;
+      }
+   }
+
+   if (list && optind < argc)
+   {
+      listMarkers(argc - optind, argv + optind);
+      return 0;
+   }
+
+   if (optind + 1 >= argc)
+   {
+      printf("Usage: %s [options] <output.sift> <input.sift> [<input.sift> ...]\n", argv[0]);
+      printf("       %s -l <input.sift> [<input.sift> ...]\n", argv[0]);
+      printf("Inputs are concatenated, of which the selected region is written to the output.\n");
+      printf("  -b <marker>    start after magic instruction number <marker> (SimRoiStart, SimMarker, ...)\n");
+      printf("  -e <marker>    stop at magic instruction number <marker>\n");
+      printf("  -s <count>     skip <count> instructions after the start\n");
+      printf("  -n <count>     write at most <count> instructions\n");
+      printf("  -c <codec>     output compression: none, zlib, zstd or lz4 (default: as the first input)\n");
+      printf("  -j <threads>   compression threads (zstd and lz4 only)\n");
+      printf("  -x <interval>  write a seek index every <interval> instructions (zstd and lz4 only)\n");
+      printf("  -i             store only the code bytes of executed instructions, not whole code pages\n");
+      printf("  -m             memory-only: write memory accesses and branches instead of instructions\n");
+      printf("  -r             write raw addresses rather than deltas, readable by older versions\n");
+      printf("  -l             list the magic instructions in the input traces\n");
+      return 1;
+   }
+
+   if (options.end_marker && options.end_marker <= options.begin_marker)
+   {
+      fprintf(stderr, "End marker should come after the begin marker\n");
+      return 1;
+   }
+
+   const char *output_filename = argv[optind];
+   std::vector<Sift::Reader*> readers;
+   bool arch32 = false, has_pa = false;
+   for(int i = optind + 1; i < argc; ++i)
+   {
+      Sift::Reader *reader = new Sift::Reader(argv[i]);
+      reader->initStream();
+      if (i > optind + 1 && reader->getTraceIsIA32() != arch32)
+      {
+         fprintf(stderr, "Cannot concatenate 32-bit and 64-bit traces\n");
+         return 1;
+      }
+      arch32 = reader->getTraceIsIA32();
+      has_pa |= reader->getTraceHasPhysicalAddresses();
+      // Code pages of such traces only hold the instructions seen so far, so the output cannot store whole pages either
+      icache_per_insn |= reader->getTraceHasIcachePerInstruction();
+      readers.push_back(reader);
+   }
+
+   uint64_t compression_option = 0;
+   if (!compression)
+      compression = readers[0]->getCompression();
+   if (!findCompression(compression, compression_option))
+   {
+      fprintf(stderr, "Unknown compression type %s\n", compression);
+      return 1;
+   }
+   if (index_interval && !(compression_option & (Sift::CompressionZstd | Sift::CompressionLZ4)))
+   {
+      fprintf(stderr, "Indexed traces require zstd or lz4 compression\n");
+      return 1;
+   }
+   if (has_pa)
+      fprintf(stderr, "Warning: physical address mappings are not copied to %s\n", output_filename);
+
+   Sift::Writer *writer = new Sift::Writer(output_filename, getCode, compression_option, "", 0, arch32, icache_per_insn, false, compression_threads, index_interval, false, address_delta);
+   Filter filter(writer, options);
+
+   for(unsigned int i = 0; i < readers.size(); ++i)
+   {
+      if (!filter.done())
+         filter.read(*readers[i], argv[optind + 1 + i]);
+      delete readers[i];
+   }
+   filter.finish();
+   delete writer;
+
+   fprintf(stderr, "%" PRIu64 " instructions read, %" PRIu64 " written to %s\n", filter.instructions, filter.written, output_filename);
+
+   return 0;
+}
@@ -0,0 +1,398 @@
+#define __STDC_FORMAT_MACROS
+
+#include "sift_reader.h"
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <inttypes.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+// Footprint and reuse distance profiles of SIFT traces, one per trace file (thread).
+//
+// The reuse distance of an access is the number of distinct cache lines touched since the previous access
+// to the same line, i.e., its LRU stack distance: a fully-associative LRU cache of C lines hits on all accesses
+// with a distance smaller than C.  Distances are found with an order-statistic tree over last-use times.
+// Cache lines are partitioned over worker threads by address hash.  Each worker computes distances within
+// its partition, which are scaled by the number of partitions to estimate the distance over all lines.
+// Profiles are exact when using a single worker.
+
+namespace
+{
+   const unsigned int NUM_BUCKETS = 48;      // Distance histogram bucket b holds distances in [2^(b-1), 2^b)
+   const size_t BATCH_SIZE = 1 << 16;
+   const size_t MAX_QUEUED_BATCHES = 16;     // Per partition, the reader blocks when a partition falls this far behind
+
+   typedef __gnu_pbds::tree<uint64_t, __gnu_pbds::null_type, std::less<uint64_t>, __gnu_pbds::rb_tree_tag,
+                            __gnu_pbds::tree_order_statistics_node_update> ordered_set_t;
+
+   struct Profile
+   {
+      Profile() : accesses(0), footprint(0), histogram() {}
+
+      uint64_t accesses;
+      uint64_t footprint;                    // Distinct lines, a first access to each of these has infinite distance
+      uint64_t histogram[NUM_BUCKETS];
+   };
+
+   struct Batch
+   {
+      unsigned int trace;
+      bool end;                              // Last batch of this trace
+      std::vector<uint64_t> lines;
+   };
+
+   class Partition
+   {
+      private:
+         const uint64_t m_scale;
+         pthread_t m_thread;
+         pthread_mutex_t m_lock;
+         pthread_cond_t m_cond;              // Signaled when a batch is queued
+         pthread_cond_t m_cond_space;        // Signaled when a batch is dequeued
+         std::deque<Batch*> m_queue;         // NULL marks the end of the input
+
+         // State of the trace being processed
+         std::unordered_map<uint64_t, uint64_t> m_last_use;
+         ordered_set_t m_stack;
+         uint64_t m_time;
+
+         void access(Profile &profile, uint64_t line)
+         {
+            ++profile.accesses;
+
+            std::unordered_map<uint64_t, uint64_t>::iterator it = m_last_use.find(line);
+            if (it == m_last_use.end())
+            {
+               ++profile.footprint;
+               m_last_use[line] = m_time;
+               all_lines.insert(line);
+            }
+            else
+            {
+               // Lines used more recently than this one are those with a larger last-use time
+               uint64_t distance = (m_stack.size() - 1 - m_stack.order_of_key(it->second)) * m_scale;
+               unsigned int bucket = 0;
+               while(distance)
+               {
+                  ++bucket;
+                  distance >>= 1;
+               }
+               ++profile.histogram[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1];
+
+               m_stack.erase(it->second);
+               it->second = m_time;
+            }
+            m_stack.insert(m_time);
+            ++m_time;
+         }
+
+         void run()
+         {
+            while(true)
+            {
+               pthread_mutex_lock(&m_lock);
+               while(m_queue.empty())
+                  pthread_cond_wait(&m_cond, &m_lock);
+               Batch *batch = m_queue.front();
+               m_queue.pop_front();
+               pthread_cond_signal(&m_cond_space);
+               pthread_mutex_unlock(&m_lock);
+
+               if (batch == NULL)
+                  break;
+
+               if (profiles.size() <= batch->trace)
+                  profiles.resize(batch->trace + 1);
+               Profile &profile = profiles[batch->trace];
+               for(std::vector<uint64_t>::const_iterator it = batch->lines.begin(); it != batch->lines.end(); ++it)
+                  access(profile, *it);
+
+               if (batch->end)
+               {
+                  m_last_use.clear();
+                  m_stack.clear();
+                  m_time = 0;
+               }
+               delete batch;
+            }
+         }
+
+         static void* threadFunc(void *arg)
+         {
+            ((Partition*)arg)->run();
+            return NULL;
+         }
+
+      public:
+         std::vector<Profile> profiles;      // Per trace, valid after join()
+         std::unordered_set<uint64_t> all_lines;
+
+         Partition(uint64_t scale)
+            : m_scale(scale)
+            , m_time(0)
+         {
+            pthread_mutex_init(&m_lock, NULL);
+            pthread_cond_init(&m_cond, NULL);
+            pthread_cond_init(&m_cond_space, NULL);
+            pthread_create(&m_thread, NULL, threadFunc, this);
+         }
+
+         ~Partition()
+         {
+            pthread_mutex_destroy(&m_lock);
+            pthread_cond_destroy(&m_cond);
+            pthread_cond_destroy(&m_cond_space);
+         }
+
+         void push(Batch *batch)
+         {
+            pthread_mutex_lock(&m_lock);
+            // Bound memory use when reading is faster than computing distances
+            while(m_queue.size() >= MAX_QUEUED_BATCHES)
+               pthread_cond_wait(&m_cond_space, &m_lock);
+            m_queue.push_back(batch);
+            pthread_cond_signal(&m_cond);
+            pthread_mutex_unlock(&m_lock);
+         }
+
+         void join()
+         {
+            push(NULL);
+            pthread_join(m_thread, NULL);
+         }
+   };
+
+   // Reads one trace, sending its data accesses to the partitions
+   class TraceStats
+   {
+      private:
+         std::vector<Partition*> &m_partitions;
+         std::vector<Batch*> m_batches;
+         const unsigned int m_trace;
+         const uint64_t m_line_shift;
+         uint64_t m_last_page, m_last_code_line;
+
+         static void __handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
+         { ((TraceStats*)arg)->handleCacheOnly(icount, type, eip, address); }
+
+         void handleCacheOnly(uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
+         {
+            instructions += icount;
+            fetch(eip);
+            if (type == Sift::CacheOnlyMemRead || type == Sift::CacheOnlyMemWrite)
+               access(address);
+         }
+
+         Batch* newBatch()
+         {
+            Batch *batch = new Batch();
+            batch->trace = m_trace;
+            batch->end = false;
+            batch->lines.reserve(BATCH_SIZE);
+            return batch;
+         }
+
+         void access(uint64_t address)
+         {
+            uint64_t line = address >> m_line_shift;
+            // Fibonacci hashing, so strided access patterns still spread evenly over the partitions
+            unsigned int partition = ((line * 0x9e3779b97f4a7c15ULL) >> 32) % m_partitions.size();
+            m_batches[partition]->lines.push_back(line);
+            if (m_batches[partition]->lines.size() == BATCH_SIZE)
+            {
+               m_partitions[partition]->push(m_batches[partition]);
+               m_batches[partition] = newBatch();
+            }
+
+            uint64_t page = address / Sift::PAGE_SIZE;
+            if (page != m_last_page)
+            {
+               pages.insert(page);
+               m_last_page = page;
+            }
+         }
+
+         void fetch(uint64_t address)
+         {
+            uint64_t line = address >> m_line_shift;
+            if (line != m_last_code_line)
+            {
+               code_lines.insert(line);
+               m_last_code_line = line;
+            }
+         }
+
+      public:
+         uint64_t instructions;
+         std::unordered_set<uint64_t> pages;
+         std::unordered_set<uint64_t> code_lines;
+
+         TraceStats(std::vector<Partition*> &partitions, unsigned int trace, uint64_t line_shift)
+            : m_partitions(partitions)
+            , m_trace(trace)
+            , m_line_shift(line_shift)
+            , m_last_page(~0ULL)
+            , m_last_code_line(~0ULL)
+            , instructions(0)
+         {
+            for(unsigned int i = 0; i < m_partitions.size(); ++i)
+               m_batches.push_back(newBatch());
+         }
+
+         void read(const char *filename)
+         {
+            Sift::Reader reader(filename);
+            reader.setHandleCacheOnlyFunc(__handleCacheOnlyFunc, this);
+
+            Sift::Instruction inst;
+            while(reader.Read(inst))
+            {
+               if ((instructions++ & 0xfffff) == 0 && reader.getLength())
+                  fprintf(stderr, "Reading SIFT trace %s: %" PRId64 "%%\r", filename, 100 * reader.getPosition() / reader.getLength());
+
+               fetch(inst.sinst->addr);
+               if (inst.executed)
+                  for(uint8_t i = 0; i < inst.num_addresses; ++i)
+                     access(inst.addresses[i]);
+            }
+            fprintf(stderr, "%*s\r", int(strlen(filename)) + 25, "");
+
+            for(unsigned int i = 0; i < m_partitions.size(); ++i)
+            {
+               m_batches[i]->end = true;
+               m_partitions[i]->push(m_batches[i]);
+            }
+            m_batches.clear();
+         }
+   };
+
+   std::string formatSize(uint64_t bytes)
+   {
+      char buffer[32];
+      if (bytes >= (1 << 30))
+         snprintf(buffer, sizeof(buffer), "%.1f GB", bytes / double(1 << 30));
+      else if (bytes >= (1 << 20))
+         snprintf(buffer, sizeof(buffer), "%.1f MB", bytes / double(1 << 20));
+      else
+         snprintf(buffer, sizeof(buffer), "%.1f KB", bytes / 1024.);
+      return buffer;
+   }
+
+   void printProfile(const Profile &profile, uint64_t line_size)
+   {
+      printf("  memory accesses    %" PRIu64 "\n", profile.accesses);
+      printf("  footprint          %" PRIu64 " lines (%s)\n", profile.footprint, formatSize(profile.footprint * line_size).c_str());
+
+      unsigned int last = 0;
+      for(unsigned int b = 0; b < NUM_BUCKETS; ++b)
+         if (profile.histogram[b])
+            last = b;
+
+      printf("  %-16s %10s %14s %13s\n", "reuse distance", "cache size", "accesses", "LRU hit rate");
+      uint64_t hits = 0;
+      for(unsigned int b = 0; b <= last; ++b)
+      {
+         // Accesses with a distance below 2^b lines hit in a fully-associative LRU cache of that size
+         hits += profile.histogram[b];
+         printf("  < %-14" PRIu64 " %10s %14" PRIu64 " %12.2f%%\n", uint64_t(1) << b, formatSize((uint64_t(1) << b) * line_size).c_str(),
+                profile.histogram[b], profile.accesses ? 100. * hits / profile.accesses : 0.);
+      }
+      printf("  %-16s %10s %14" PRIu64 "\n", "cold", "", profile.footprint);
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   uint64_t line_size = 64;
+   unsigned int num_threads = 1;
+
+   int opt;
+   while((opt = getopt(argc, argv, "l:j:")) != -1)
+   {
+      switch(opt)
+      {
+         case 'l':
+            line_size = strtoull(optarg, NULL, 0);
+            break;
+         case 'j':
+            num_threads = strtoul(optarg, NULL, 0);
+            break;
+         default:
+            optind = argc + 1;
+            break;
+      }
+   }
+
+   if (optind >= argc || line_size == 0 || (line_size & (line_size - 1)) || num_threads == 0)
+   {
+      printf("Usage: %s [-l <line size (default 64)>] [-j <worker threads (default 1)>] <file.sift> [<file.sift> ...]\n", argv[0]);
+      return 1;
+   }
+
+   uint64_t line_shift = 0;
+   while((uint64_t(1) << line_shift) < line_size)
+      ++line_shift;
+
+   std::vector<Partition*> partitions;
+   for(unsigned int i = 0; i < num_threads; ++i)
+      partitions.push_back(new Partition(num_threads));
+
+   std::vector<TraceStats*> traces;
+   for(int i = optind; i < argc; ++i)
+   {
+      TraceStats *stats = new TraceStats(partitions, traces.size(), line_shift);
+      stats->read(argv[i]);
+      traces.push_back(stats);
+   }
+
+   for(unsigned int i = 0; i < partitions.size(); ++i)
+      partitions[i]->join();
+
+   uint64_t total_lines = 0;
+   std::unordered_set<uint64_t> total_pages;
+   for(unsigned int t = 0; t < traces.size(); ++t)
+   {
+      Profile profile;
+      for(unsigned int i = 0; i < partitions.size(); ++i)
+      {
+         if (partitions[i]->profiles.size() <= t)
+            continue;
+         const Profile &part = partitions[i]->profiles[t];
+         profile.accesses += part.accesses;
+         profile.footprint += part.footprint;
+         for(unsigned int b = 0; b < NUM_BUCKETS; ++b)
+            profile.histogram[b] += part.histogram[b];
+      }
+
+      printf("thread %u: %s\n", t, argv[optind + t]);
+      printf("  instructions       %" PRIu64 "\n", traces[t]->instructions);
+      printf("  code footprint     %zu lines (%s)\n", traces[t]->code_lines.size(), formatSize(traces[t]->code_lines.size() * line_size).c_str());
+      printf("  page footprint     %zu pages (%s)\n", traces[t]->pages.size(), formatSize(traces[t]->pages.size() * Sift::PAGE_SIZE).c_str());
+      printProfile(profile, line_size);
+      printf("\n");
+
+      total_pages.insert(traces[t]->pages.begin(), traces[t]->pages.end());
+   }
+
+   for(unsigned int i = 0; i < partitions.size(); ++i)
+      total_lines += partitions[i]->all_lines.size();
+
+   printf("total footprint      %" PRIu64 " lines (%s), %zu pages (%s)\n", total_lines, formatSize(total_lines * line_size).c_str(),
+          total_pages.size(), formatSize(total_pages.size() * Sift::PAGE_SIZE).c_str());
+
+   for(unsigned int i = 0; i < partitions.size(); ++i)
+      delete partitions[i];
+   for(unsigned int i = 0; i < traces.size(); ++i)
+      delete traces[i];
+
+   return 0;
+}
@@ -2,6 +2,10 @@
 
 #include <zlib.h>
 #include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 ozstream::ozstream(vostream *output)
    : output(output)
@@ -114,3 +118,34 @@ int izstream::peek()
 
    return peek_value;
 }
+
+vmmapstream::vmmapstream(const char *filename, size_t offset)
+   : m_data(NULL)
+   , m_size(0)
+   , m_offset(offset)
+   , m_fail(false)
+{
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0)
+      return;
+
+   struct stat st;
+   if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && size_t(st.st_size) >= offset)
+   {
+      void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED)
+      {
+         madvise(data, st.st_size, MADV_SEQUENTIAL);
+         m_data = (const char *)data;
+         m_size = st.st_size;
+      }
+   }
+   // The mapping stays valid after closing the file
+   close(fd);
+}
+
+vmmapstream::~vmmapstream()
+{
+   if (m_data)
+      munmap(const_cast<char*>(m_data), m_size);
+}
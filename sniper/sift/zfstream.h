@@ -5,6 +5,9 @@
 #include <ostream>
 #include <istream>
 #include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
 
 class vostream
 {
@@ -13,6 +16,8 @@ class vostream
       virtual void write(const char* s, std::streamsize n) = 0;
       virtual void flush() = 0;
       virtual bool is_open() = 0;
+      // Bytes before and after compression and time spent compressing, for compressed streams
+      virtual bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const { return false; }
 };
 
 class vofstream : public vostream
@@ -52,6 +57,8 @@ class ozstream : public vostream
          { output->flush(); }
       virtual bool is_open()
          { return output->is_open(); }
+      virtual bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const
+         { compressed = zstream.total_out; uncompressed = zstream.total_in; ns = 0; return true; }
 };
 
 
@@ -63,6 +70,52 @@ class vistream
       virtual void read(char* s, std::streamsize n) = 0;
       virtual int peek() = 0;
       virtual bool fail() const = 0;
+      // Bytes before and after decompression and time spent decompressing, for compressed streams
+      virtual bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const { return false; }
+      // Zero-copy read: skip over the next n bytes and return a pointer to them, valid for the lifetime of the stream.
+      // Returns NULL when not supported, in which case nothing was read.
+      virtual const char* readDirect(std::streamsize n) { return NULL; }
+};
+
+// Read-only memory mapping of a file, starting at a given offset
+class vmmapstream : public vistream
+{
+   private:
+      const char *m_data;
+      size_t m_size;
+      size_t m_offset;
+      bool m_fail;
+   public:
+      vmmapstream(const char *filename, size_t offset = 0);
+      virtual ~vmmapstream();
+      virtual void read(char* s, std::streamsize n)
+      {
+         if (m_offset + n > m_size)
+         {
+            m_fail = true;
+            n = m_size - m_offset;
+         }
+         memcpy(s, m_data + m_offset, n);
+         m_offset += n;
+      }
+      virtual int peek()
+         { return m_offset < m_size ? (unsigned char)m_data[m_offset] : EOF; }
+      virtual bool fail() const { return m_fail; }
+      virtual const char* readDirect(std::streamsize n)
+      {
+         if (m_offset + n > m_size)
+         {
+            m_fail = true;
+            m_offset = m_size;
+            return NULL;
+         }
+         const char *ptr = m_data + m_offset;
+         m_offset += n;
+         return ptr;
+      }
+      bool is_open() const { return m_data != NULL; }
+      uint64_t getPosition() const { return m_offset; }
+      bool contains(const void *ptr) const { return ptr >= m_data && ptr < m_data + m_size; }
 };
 
 class vifstream : public vistream
@@ -100,6 +153,8 @@ class izstream : public vistream
       virtual int peek();
       virtual bool eof() const { return m_eof; }
       virtual bool fail() const { return m_fail; }
+      virtual bool getCompressionStats(uint64_t &compressed, uint64_t &uncompressed, uint64_t &ns) const
+         { compressed = zstream.total_in; uncompressed = zstream.total_out; ns = 0; return true; }
 };
 
 #endif // __ZFSTREAM_H
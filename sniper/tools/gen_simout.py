@@ -82,6 +82,10 @@ def generate_simout(jobid = None, resultsdir = None, partial = None, output = sy
       ('  misprediction rate', 'branch_predictor.missrate', lambda v: '%.2f%%' % v),
       ('  mpki', 'branch_predictor.mpki', lambda v: '%.2f' % v),
     ]
+    if 'branch_predictor.storage-bits' in results:
+      template += [
+        ('  storage (KB)', 'branch_predictor.storage-bits', lambda v: '%.1f' % (v / 8192.)),
+      ]
 
   template += [
     ('TLB Summary', '', ''),
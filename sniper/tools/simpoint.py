@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+
+"""
+simpoint.py
+
+Pick representative simulation regions from a basic-block vector profile, as written by
+  record-trace --bbv-profile=<interval> -- <cmdline>
+following the SimPoint method: k-means clustering of the interval BBVs for a range of k,
+selection of the smallest k whose BIC score comes close enough to the best one, and the
+interval nearest to each cluster centroid as the simulation point for that cluster.
+Each simulation point is weighted by the fraction of instructions in its cluster.
+
+The output lists one region per line and is the input to simpoint_run.py.
+
+Only single-threaded applications are supported: the recorder writes one profile per thread
+(<output>.th<N>.bbvprofile) with positions counted in that thread's instructions, while
+simpoint_run.py places regions using global instruction counts (roi-icount, start_instruction).
+"""
+
+import sys, os, getopt, math
+import numpy
+
+
+def usage():
+  print('Usage: %s -i <bbvprofile> [-o <output (default: stdout)>] [-k <max clusters (20)>] [--seeds=<k-means restarts (5)>] [--iterations=<max k-means iterations (100)>] [--threshold=<BIC threshold (0.9)>] [--seed=<random seed (0)>]' % sys.argv[0])
+  sys.exit(2)
+
+
+def read_profile(filename):
+  lengths = []
+  vectors = []
+  for line in open(filename):
+    fields = line.split()
+    if not fields:
+      continue
+    lengths.append(int(fields[0]))
+    vectors.append([ float(v) for v in fields[1:] ])
+  if not lengths:
+    raise ValueError('BBV profile %s is empty' % filename)
+  # Projected BBV elements are averages of 16-bit random weights, scale them to [0, 1]
+  return numpy.array(lengths, dtype = numpy.int64), numpy.array(vectors) / 65536.
+
+
+def distances(data, centroids):
+  # Squared euclidean distance from each point to each centroid
+  return ((data[:, numpy.newaxis, :] - centroids[numpy.newaxis, :, :]) ** 2).sum(axis = 2)
+
+
+def kmeans(data, k, rng, iterations):
+  # k-means++ seeding
+  centroids = [ data[rng.randint(len(data))] ]
+  for i in range(1, k):
+    d = distances(data, numpy.array(centroids)).min(axis = 1)
+    if d.sum() == 0:
+      centroids.append(data[rng.randint(len(data))])
+    else:
+      centroids.append(data[rng.choice(len(data), p = d / d.sum())])
+  centroids = numpy.array(centroids)
+
+  labels = None
+  for it in range(iterations):
+    new_labels = distances(data, centroids).argmin(axis = 1)
+    if labels is not None and (new_labels == labels).all():
+      break
+    labels = new_labels
+    for c in range(k):
+      members = data[labels == c]
+      if len(members):
+        centroids[c] = members.mean(axis = 0)
+
+  sse = ((data - centroids[labels]) ** 2).sum()
+  return labels, centroids, sse
+
+
+def bic(data, labels, k, sse):
+  # Bayesian Information Criterion of a k-means clustering (Pelleg and Moore, X-means)
+  R, M = data.shape
+  if R <= k:
+    return float('-inf')
+  variance = max(sse / (R - k), 1e-12)
+  loglikelihood = 0.
+  for c in range(k):
+    Rn = float((labels == c).sum())
+    if Rn == 0:
+      continue
+    loglikelihood += - Rn / 2 * math.log(2 * math.pi) - Rn * M / 2 * math.log(variance) - (Rn - k) / 2 + Rn * math.log(Rn) - Rn * math.log(R)
+  parameters = (k - 1) + M * k + 1
+  return loglikelihood - parameters / 2. * math.log(R)
+
+
+def simpoints(lengths, data, max_k = 20, seeds = 5, iterations = 100, threshold = .9, seed = 0):
+  rng = numpy.random.RandomState(seed)
+  max_k = min(max_k, len(data))
+
+  clusterings = {}
+  for k in range(1, max_k + 1):
+    best = None
+    for s in range(seeds):
+      labels, centroids, sse = kmeans(data, k, rng, iterations)
+      if best is None or sse < best[2]:
+        best = (labels, centroids, sse)
+    clusterings[k] = best + (bic(data, best[0], k, best[2]),)
+
+  # Smallest k whose score is within <threshold> of the range of BIC scores seen
+  scores = [ clusterings[k][3] for k in clusterings if clusterings[k][3] != float('-inf') ]
+  if scores:
+    bic_min, bic_max = min(scores), max(scores)
+    k = min([ k for k in clusterings if clusterings[k][3] >= bic_min + threshold * (bic_max - bic_min) ])
+  else:
+    k = 1
+  labels, centroids, sse, score = clusterings[k]
+
+  starts = numpy.concatenate(([ 0 ], numpy.cumsum(lengths)[:-1]))
+  total = float(lengths.sum())
+  d = distances(data, centroids)
+  regions = []
+  for c in range(k):
+    members = numpy.nonzero(labels == c)[0]
+    if not len(members):
+      continue
+    interval = members[d[members, c].argmin()]
+    regions.append({
+      'cluster': c,
+      'interval': int(interval),
+      'start': int(starts[interval]),
+      'length': int(lengths[interval]),
+      'weight': lengths[members].sum() / total,
+    })
+  regions.sort(key = lambda r: r['start'])
+  return regions
+
+
+def write_simpoints(regions, lengths, output):
+  output.write('# %d intervals, %d instructions, %d regions\n' % (len(lengths), lengths.sum(), len(regions)))
+  output.write('# total-instructions %d\n' % lengths.sum())
+  output.write('# region start length weight cluster interval\n')
+  for i, r in enumerate(regions):
+    output.write('%d %d %d %.6f %d %d\n' % (i, r['start'], r['length'], r['weight'], r['cluster'], r['interval']))
+
+
+def read_simpoints(filename):
+  regions = []
+  total = None
+  for line in open(filename):
+    if line.startswith('# total-instructions'):
+      total = int(line.split()[2])
+    if line.startswith('#') or not line.strip():
+      continue
+    region, start, length, weight, cluster, interval = line.split()
+    regions.append({ 'region': int(region), 'start': int(start), 'length': int(length), 'weight': float(weight), 'cluster': int(cluster), 'interval': int(interval) })
+  return regions, total
+
+
+if __name__ == '__main__':
+  inputfile = None
+  outputfile = None
+  max_k = 20
+  seeds = 5
+  iterations = 100
+  threshold = .9
+  seed = 0
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "hi:o:k:", [ "seeds=", "iterations=", "threshold=", "seed=" ])
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+  for o, a in opts:
+    if o == '-h':
+      usage()
+    if o == '-i':
+      inputfile = a
+    if o == '-o':
+      outputfile = a
+    if o == '-k':
+      max_k = int(a)
+    if o == '--seeds':
+      seeds = int(a)
+    if o == '--iterations':
+      iterations = int(a)
+    if o == '--threshold':
+      threshold = float(a)
+    if o == '--seed':
+      seed = int(a)
+
+  if not inputfile or args:
+    usage()
+
+  lengths, data = read_profile(inputfile)
+  regions = simpoints(lengths, data, max_k = max_k, seeds = seeds, iterations = iterations, threshold = threshold, seed = seed)
+  write_simpoints(regions, lengths, outputfile and open(outputfile, 'w') or sys.stdout)
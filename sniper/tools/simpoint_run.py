@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+
+"""
+simpoint_run.py
+
+Simulate the regions picked by simpoint.py as independent Sniper runs, several at a time,
+and combine their statistics into a whole-program estimate.
+
+Each region runs in <outputdir>/region<N> as
+  run-sniper -d <outputdir>/region<N> --roi-script --no-cache-warming -s roi-icount:<start - warmup>:<warmup>:<length>:stop <run-sniper options>
+so it fast-forwards to the region, warms up caches and predictors, simulates the region in detail and stops.
+With --trace=<file.sift>, an indexed trace (record-trace --index) of the same program, each region instead
+seeks directly to its warmup start using traceinput/start_instruction, skipping the fast-forward.
+
+Region positions are global instruction counts, so this only matches the per-thread BBV profile
+of a single-threaded application (see simpoint.py).
+
+Every statistic is extrapolated as sum(weight * value / region instructions) * total instructions,
+the combined CPI is sum(weight * region CPI).  The result is written to <outputdir>/simpoint.out.
+"""
+
+import sys, os, getopt, time, subprocess
+import sniper_lib, simpoint
+
+
+HOME = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+
+
+def usage():
+  print('Usage: %s -s <simpoints> -d <outputdir> [-j <parallel runs (1)>] [-w <warmup instructions (0)>] [--trace=<indexed trace>] [--report-only] -- <run-sniper options> [-- <cmdline>]' % sys.argv[0])
+  sys.exit(2)
+
+
+def region_dir(outputdir, region):
+  return os.path.join(outputdir, 'region%d' % region['region'])
+
+
+def run_regions(regions, outputdir, sniper_args, parallel = 1, warmup = 0, trace = None):
+  pending = list(regions)
+  running = []
+  failed = []
+  while pending or running:
+    while pending and len(running) < parallel:
+      region = pending.pop(0)
+      resultsdir = region_dir(outputdir, region)
+      if not os.path.exists(resultsdir):
+        os.makedirs(resultsdir)
+      region_warmup = min(warmup, region['start'])
+      if trace:
+        cmd = [ os.path.join(HOME, 'run-sniper'), '-d', resultsdir, '--roi-script', '--no-cache-warming', '--traces=%s' % trace,
+                '-g', 'traceinput/start_instruction=%d' % (region['start'] - region_warmup),
+                '-s', 'roi-icount:0:%d:%d:stop' % (region_warmup, region['length']) ] + sniper_args
+      else:
+        cmd = [ os.path.join(HOME, 'run-sniper'), '-d', resultsdir, '--roi-script', '--no-cache-warming',
+                '-s', 'roi-icount:%d:%d:%d:stop' % (region['start'] - region_warmup, region_warmup, region['length']) ] + sniper_args
+      print('[SIMPOINT] Starting region %d (%.1f%%)' % (region['region'], 100 * region['weight']))
+      log = open(os.path.join(resultsdir, 'simpoint-run.log'), 'w')
+      running.append((region, subprocess.Popen(cmd, stdout = log, stderr = subprocess.STDOUT)))
+    time.sleep(1)
+    for region, proc in running[:]:
+      if proc.poll() is not None:
+        running.remove((region, proc))
+        if proc.returncode:
+          print('[SIMPOINT] Region %d failed with exit code %d, see %s' % (region['region'], proc.returncode, os.path.join(region_dir(outputdir, region), 'simpoint-run.log')))
+          failed.append(region)
+        else:
+          print('[SIMPOINT] Region %d done' % region['region'])
+  return failed
+
+
+def combine(regions, total_instructions, outputdir):
+  combined = {}
+  cpi = 0.
+  weights = 0.
+  lines = []
+  for region in regions:
+    res = sniper_lib.get_results(resultsdir = region_dir(outputdir, region))
+    results = res['results']
+    instructions = float(sum(results['performance_model.instruction_count']))
+    cycles = max(results['performance_model.cycle_count'])
+    if not instructions:
+      raise ValueError('Region %d did not simulate any instructions' % region['region'])
+    region_cpi = cycles / instructions
+    lines.append('  region %-4d weight %6.2f%%  instructions %12d  CPI %.4f' % (region['region'], 100 * region['weight'], instructions, region_cpi))
+    cpi += region['weight'] * region_cpi
+    weights += region['weight']
+    for key, value in results.items():
+      if type(value) is not list:
+        continue
+      try:
+        rate = sum(value) / instructions
+      except TypeError:
+        continue
+      combined[key] = combined.get(key, 0.) + region['weight'] * rate
+
+  # Normalize in case not all regions were simulated
+  output = open(os.path.join(outputdir, 'simpoint.out'), 'w')
+  output.write('Regions:\n')
+  output.write('\n'.join(lines) + '\n')
+  output.write('Combined (%.1f%% of instructions covered):\n' % (100 * weights))
+  output.write('  CPI %.4f\n' % (cpi / weights))
+  output.write('  IPC %.4f\n' % (weights / cpi))
+  if total_instructions:
+    output.write('Extrapolated statistics for %d instructions (sum over all cores):\n' % total_instructions)
+    for key in sorted(combined.keys()):
+      output.write('  %s = %d\n' % (key, combined[key] / weights * total_instructions))
+  output.close()
+  return cpi / weights
+
+
+if __name__ == '__main__':
+  simpointsfile = None
+  outputdir = None
+  parallel = 1
+  warmup = 0
+  report_only = False
+  trace = None
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "hs:d:j:w:", [ "report-only", "trace=" ])
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+  for o, a in opts:
+    if o == '-h':
+      usage()
+    if o == '-s':
+      simpointsfile = a
+    if o == '-d':
+      outputdir = a
+    if o == '-j':
+      parallel = int(a)
+    if o == '-w':
+      warmup = int(float(a))
+    if o == '--report-only':
+      report_only = True
+    if o == '--trace':
+      trace = os.path.realpath(a)
+
+  if not simpointsfile or not outputdir or (not args and not report_only and not trace):
+    usage()
+
+  regions, total_instructions = simpoint.read_simpoints(simpointsfile)
+  outputdir = os.path.realpath(outputdir)
+  if not os.path.exists(outputdir):
+    os.makedirs(outputdir)
+
+  if not report_only:
+    failed = run_regions(regions, outputdir, args, parallel = parallel, warmup = warmup, trace = trace)
+    regions = [ r for r in regions if r not in failed ]
+
+  cpi = combine(regions, total_instructions, outputdir)
+  print('[SIMPOINT] Combined CPI %.4f, see %s' % (cpi, os.path.join(outputdir, 'simpoint.out')))